@@ -1,9 +1,22 @@
 
+#include <algorithm>
+#include <climits>
+
 #include "ix.h"
 
 IndexManager* IndexManager::_index_manager = 0;
 PagedFileManager *IndexManager::_pf_manager = NULL;
 
+//what a handle that is not open points at. Its metadata has no magic number, so every
+//operation on the handle fails
+static IndexFile closedIndex;
+
+//IndexFile::lastInsert packs a leaf page number and an entry number in it
+static uint64_t getInsertPosition(PageNum pageNum, unsigned entryNum)
+{
+    return ((uint64_t) pageNum << 32) | entryNum;
+}
+
 IndexManager* IndexManager::instance()
 {
     if(!_index_manager)
@@ -23,30 +36,67 @@ IndexManager::~IndexManager()
 
 RC IndexManager::createFile(const string &fileName)
 {
+    return createFile(fileName, IX_BTREE);
+}
+
+RC IndexManager::createFile(const string &fileName, IndexType indexType)
+{
+    if (indexType != IX_BTREE && indexType != IX_HASH)
+        return IX_INVALID_ARGUMENT;
     // Creating a new paged file.
     if (_pf_manager->createFile(fileName))
         return IX_CREATE_FAILED;
 
-    // Setting up the first page.
+    // Setting up the metadata page and an empty root leaf, or a directory of one empty bucket.
     void * firstPageData = calloc(PAGE_SIZE, 1);
     if (firstPageData == NULL)
         return IX_MALLOC_FAILED;
-    newIndexPage(firstPageData);
-    NodeHeader nodeHeader = getNodePageHeader(firstPageData);
-    // nodeHeader.isRoot = true;
-    nodeHeader.isLeaf = true;
-    setNodePageHeader(firstPageData, nodeHeader);
+    IndexMetadata metadata;
+    memset(&metadata, 0, sizeof(IndexMetadata));
+    metadata.magic = IX_MAGIC;
+    metadata.version = IX_FORMAT_VERSION;
+    metadata.rootPage = IX_METADATA_PAGE + 1;
+    metadata.height = 1;
+    metadata.keyType = IX_NO_KEY_TYPE;
+    metadata.entryNumber = 0;
+    metadata.leafNumber = 1;
+    metadata.freePageList = IX_NO_PAGE;
+    metadata.indexType = indexType;
+    if (indexType == IX_HASH)
+    {
+        metadata.rootPage = IX_NO_PAGE;
+        metadata.height = 0;
+        metadata.globalDepth = 0;
+        metadata.directoryPages[0] = IX_METADATA_PAGE + 1;
+    }
+    memcpy(firstPageData, &metadata, sizeof(IndexMetadata));
 
-    // Adds the first record based page.
     FileHandle handle;
     if (_pf_manager->openFile(fileName.c_str(), handle))
+    {
+        free(firstPageData);
         return IX_OPEN_FAILED;
+    }
+    RC rc = SUCCESS;
     if (handle.appendPage(firstPageData))
-        return IX_APPEND_FAILED;
+        rc = IX_APPEND_FAILED;
+    if (indexType == IX_HASH)
+    {
+        memset(firstPageData, 0, PAGE_SIZE);
+        PageNum bucketPage = IX_METADATA_PAGE + 2;
+        memcpy(firstPageData, &bucketPage, sizeof(PageNum));
+        if (rc == SUCCESS && handle.appendPage(firstPageData))
+            rc = IX_APPEND_FAILED;
+        newBucketPage(firstPageData, 0);
+    }
+    else
+        newIndexPage(firstPageData, IX_NO_PAGE);
+    if (rc == SUCCESS && handle.appendPage(firstPageData))
+        rc = IX_APPEND_FAILED;
     _pf_manager->closeFile(handle);
 
     free(firstPageData);
-    return SUCCESS;
+    return rc;
 }
 
 RC IndexManager::destroyFile(const string &fileName)
@@ -58,37 +108,388 @@ RC IndexManager::openFile(const string &fileName, IXFileHandle &ixfileHandle)
 {
     if(_pf_manager->openFile(fileName.c_str(), ixfileHandle.fileHandle))
         return IX_OPEN_FAILED;
-    ixfileHandle.rootPage = 0;
+    FileId id;
+    if (!_pf_manager->getFileId(fileName, id))
+    {
+        _pf_manager->closeFile(ixfileHandle.fileHandle);
+        return IX_OPEN_FAILED;
+    }
+
+    // Share the index with any other handle that already has it open
+    lock_guard<mutex> guard(openIndexesLatch);
+    auto it = openIndexes.find(id);
+    if (it != openIndexes.end())
+    {
+        it->second->handleCount++;
+        ixfileHandle.index = it->second;
+        return SUCCESS;
+    }
+
+    IndexFile *index = new IndexFile;
+    index->id = id;
+    index->handleCount = 1;
+    ixfileHandle.index = index;
+    RC rc = readMetadata(ixfileHandle);
+    if (rc != SUCCESS)
+    {
+        ixfileHandle.index = &closedIndex;
+        delete index;
+        _pf_manager->closeFile(ixfileHandle.fileHandle);
+        return rc;
+    }
+    openIndexes[id] = index;
     return SUCCESS;
 }
 
+// The metadata is written back when the last handle on the index closes. A handle with open
+// scans stays open, as they still hold leaves pinned through it and are counted in its index
 RC IndexManager::closeFile(IXFileHandle &ixfileHandle)
 {
-    return _pf_manager->closeFile(ixfileHandle.fileHandle);
+    if (ixfileHandle.openScans > 0)
+        return IX_SCAN_OPEN;
+
+    RC rc = SUCCESS;
+    IndexFile *index = ixfileHandle.index;
+    if (index != &closedIndex)
+    {
+        lock_guard<mutex> guard(openIndexesLatch);
+        if (--index->handleCount == 0)
+        {
+            {
+                lock_guard<mutex> metadataGuard(index->metadataLatch);
+                if (index->metadataDirty)
+                    rc = writeMetadata(ixfileHandle);
+            }
+            openIndexes.erase(index->id);
+            delete index;
+        }
+        ixfileHandle.index = &closedIndex;
+    }
+    RC closeRc = _pf_manager->closeFile(ixfileHandle.fileHandle);
+    return rc != SUCCESS ? rc : closeRc;
 }
 
 RC IndexManager::insertEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid)
 {
-    //find correct leaf page
-    unsigned pageNum = traverse(ixfileHandle, attribute, key);
-    void* pageData = malloc(PAGE_SIZE);
-    if (ixfileHandle.fileHandle.readPage(pageNum, pageData))
-        return IX_READ_FAILED;
+    RC rc = checkKeyType(ixfileHandle, attribute);
+    if (rc != SUCCESS)
+        return rc;
+
+    char nodeKey[PAGE_SIZE];
+    toNodeKey(attribute, key, nodeKey);
+    return insertNodeKey(ixfileHandle, attribute, nodeKey, rid);
+}
+
+RC IndexManager::insertEntry(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const void *key, const RID &rid)
+{
+    RC rc = checkKeyFields(ixfileHandle, attributes);
+    if (rc != SUCCESS)
+        return rc;
+
+    char nodeKey[PAGE_SIZE];
+    toCompositeNodeKey(attributes, attributes.size(), key, nodeKey);
+    return insertNodeKey(ixfileHandle, getCompositeAttribute(), nodeKey, rid);
+}
+
+RC IndexManager::insertNodeKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid)
+{
+    unsigned keySize = getKeySize(attribute, nodeKey);
+    if (keySize > IX_MAX_KEY_SIZE)
+        return IX_KEY_TOO_LONG;
+    if (isHashIndex(ixfileHandle))
+        return insertHashKey(ixfileHandle, attribute, nodeKey, rid);
+    // The most an insert adds to a leaf: a new entry, or one more RID in an inline list
+    unsigned maxGrowth = keySize + sizeof(PostingHeader) + IX_MAX_RID_SIZE + sizeof(NodeSlot);
+
+    // Most inserts only change their leaf and the counts above it, so the first descent latches
+    // the internal nodes shared. Only if the leaf is full do we go down again, latching exclusively
+    // the nodes a split may reach as the first descent found them. If one has filled up since,
+    // the split may go further and we go down once more
+    PageNum pageNum;
+    void *pageData;
+    vector<NodePathEntry> path;
+    bool rootLatched;
+    RC rc = traverse(ixfileHandle, attribute, nodeKey, false, IX_TRAVERSE_WRITE_LEAF, pageNum, pageData, path, rootLatched);
+    if (rc != SUCCESS)
+        return rc;
+    // A key that doesn't start with the leaf's prefix shortens it, which may not fit either
+    char entry[PAGE_SIZE];
+    unsigned entrySize = getKeySize(attribute, nodeKey);
+    memcpy(entry, nodeKey, entrySize);
+    if (getNodeFreeSpace(pageData) < maxGrowth || !toLeafEntry(pageData, entry, entrySize))
+    {
+        unsigned splitLevel = getSplitLevel(ixfileHandle, path);
+        while (true)
+        {
+            releaseNode(ixfileHandle, pageNum, false);
+            releasePath(ixfileHandle, path, rootLatched);
+            rc = traverse(ixfileHandle, attribute, nodeKey, false, IX_TRAVERSE_INSERT, pageNum, pageData, path, rootLatched,
+                    splitLevel);
+            if (rc != SUCCESS)
+                return rc;
+            unsigned level = getSplitLevel(ixfileHandle, path);
+            if (level <= splitLevel)
+                break;
+            splitLevel = level;
+        }
+    }
+
+    // Add the RID to the key's entry, or start one. Entries are built with the key as the leaf
+    // stores it
+    unsigned entryNum = lowerBound(pageData, attribute, nodeKey);
     NodeHeader nodeHeader = getNodePageHeader(pageData);
-    //if not enough size
-    if(nodeHeader.endOfEntries+sizeof(NodeEntry)>PAGE_SIZE){
-        splitPage(ixfileHandle, pageData, pageNum,nodeHeader.parent,attribute, key, rid);
-    }else{
-        insertInSortedOrder(pageData, attribute, key, rid, -1, -1);
-        if(ixfileHandle.fileHandle.writePage(pageNum,pageData))
-            return IX_WRITE_FAILED;
+    bool prefixed = true;
+    bool newKey = false;
+    if (entryNum < nodeHeader.entryNumber && compareLeafKey(getKeySearch(attribute.type), pageData, entryNum, nodeKey) == 0)
+    {
+        rc = insertIntoPosting(ixfileHandle, attribute, pageData, entryNum, rid, entry, entrySize);
+        if (rc == SUCCESS)
+            removeEntryAt(pageData, attribute, entryNum);
     }
-    free(pageData);
+    else
+    {
+        rc = makePostingEntry(ixfileHandle, attribute, nodeKey, vector<RID>(1, rid), entry, entrySize);
+        if (rc == SUCCESS)
+            prefixed = toLeafEntry(pageData, entry, entrySize);
+        newKey = true;
+    }
+
+    //if not enough size, or the prefix has to change, the leaf is rebuilt from whole entries
+    vector<NodePathEntry> latched = path;
+    if (rc == SUCCESS)
+    {
+        addToPathCounts(ixfileHandle, attribute, path, 1);
+        if (prefixed && getNodeFreeSpace(pageData) >= entrySize + sizeof(NodeSlot))
+        {
+            setEntryAtOffset(pageData, entryNum, entry, entrySize);
+            if (newKey)
+                ixfileHandle.index->lastInsert = getInsertPosition(pageNum, entryNum);
+        }
+        else
+        {
+            if (prefixed)
+                entrySize = fromLeafEntry(pageData, entry, entrySize);
+            rc = splitPage(ixfileHandle, attribute, pageData, pageNum, path, entryNum, entry, entrySize, false);
+        }
+    }
+
+    releaseNode(ixfileHandle, pageNum, true);
+    releasePath(ixfileHandle, latched, rootLatched);
+    if (rc != SUCCESS)
+        return rc;
+
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    ixfileHandle.index->metadata.entryNumber++;
+    ixfileHandle.index->metadataDirty = true;
     return SUCCESS;
 }
 
+RC IndexManager::bulkLoad(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<const void*> &keys,
+        const vector<RID> &rids, float fillFactor)
+{
+    if (keys.size() != rids.size() || !(fillFactor > 0 && fillFactor <= 1))
+        return IX_INVALID_ARGUMENT;
+    RC rc = checkKeyType(ixfileHandle, attribute);
+    if (rc != SUCCESS)
+        return rc;
+
+    // Convert the keys to the node format once
+    vector<char> nodeKeys;
+    vector<unsigned> keyOffsets(keys.size());
+    char nodeKey[PAGE_SIZE];
+    for (unsigned i = 0; i < keys.size(); i++)
+    {
+        toNodeKey(attribute, keys[i], nodeKey);
+        keyOffsets[i] = nodeKeys.size();
+        nodeKeys.insert(nodeKeys.end(), nodeKey, nodeKey + getKeySize(attribute, nodeKey));
+    }
+    return bulkLoadNodeKeys(ixfileHandle, attribute, nodeKeys, keyOffsets, rids, fillFactor);
+}
+
+RC IndexManager::bulkLoad(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const vector<const void*> &keys,
+        const vector<RID> &rids, float fillFactor)
+{
+    if (keys.size() != rids.size() || !(fillFactor > 0 && fillFactor <= 1))
+        return IX_INVALID_ARGUMENT;
+    RC rc = checkKeyFields(ixfileHandle, attributes);
+    if (rc != SUCCESS)
+        return rc;
+
+    Attribute attribute = getCompositeAttribute();
+    vector<char> nodeKeys;
+    vector<unsigned> keyOffsets(keys.size());
+    char nodeKey[PAGE_SIZE];
+    for (unsigned i = 0; i < keys.size(); i++)
+    {
+        toCompositeNodeKey(attributes, attributes.size(), keys[i], nodeKey);
+        keyOffsets[i] = nodeKeys.size();
+        nodeKeys.insert(nodeKeys.end(), nodeKey, nodeKey + getKeySize(attribute, nodeKey));
+    }
+    return bulkLoadNodeKeys(ixfileHandle, attribute, nodeKeys, keyOffsets, rids, fillFactor);
+}
+
+RC IndexManager::bulkLoadNodeKeys(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<char> &nodeKeys,
+        const vector<unsigned> &keyOffsets, const vector<RID> &rids, float fillFactor)
+{
+    for (unsigned i = 0; i < keyOffsets.size(); i++)
+    {
+        if (getKeySize(attribute, &nodeKeys[keyOffsets[i]]) > IX_MAX_KEY_SIZE)
+            return IX_KEY_TOO_LONG;
+    }
+    // Buckets have no order to build from, the entries go in one at a time
+    if (isHashIndex(ixfileHandle))
+    {
+        for (unsigned i = 0; i < keyOffsets.size(); i++)
+        {
+            RC rc = insertHashKey(ixfileHandle, attribute, &nodeKeys[keyOffsets[i]], rids[i]);
+            if (rc != SUCCESS)
+                return rc;
+        }
+        return SUCCESS;
+    }
+
+    vector<unsigned> order;
+    sortEntries(attribute, nodeKeys, keyOffsets, rids, order);
+    {
+        lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+        ixfileHandle.index->metadata.fillFactor = fillFactor;
+        ixfileHandle.index->metadataDirty = true;
+    }
+
+    // Nothing else may use the tree while it is rebuilt under the root
+    pthread_rwlock_wrlock(&ixfileHandle.index->rootLatch);
+    bool empty;
+    {
+        lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+        empty = ixfileHandle.index->metadata.entryNumber == 0 && ixfileHandle.index->metadata.height == 1;
+    }
+    if (!empty || order.empty())
+        pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+    if (!empty)
+    {
+        for (unsigned i = 0; i < order.size(); i++)
+        {
+            RC rc = insertNodeKey(ixfileHandle, attribute, &nodeKeys[keyOffsets[order[i]]], rids[order[i]]);
+            if (rc != SUCCESS)
+                return rc;
+        }
+        return SUCCESS;
+    }
+    if (order.empty())
+        return SUCCESS;
+
+    // The empty root leaf becomes the first leaf of the new tree
+    PageNum rootPageNum = ixfileHandle.index->metadata.rootPage;
+    void *rootData;
+    RC rc = fetchNode(ixfileHandle, rootPageNum, rootData, true);
+    if (rc != SUCCESS)
+    {
+        pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+        return rc;
+    }
+    PageNum newRootPage;
+    uint32_t height, leafNumber;
+    rc = buildTree(ixfileHandle, attribute, rootPageNum, nodeKeys, keyOffsets, rids, order, fillFactor,
+            newRootPage, height, leafNumber);
+
+    // Switch to the new root only once the whole tree is written
+    clearNodeCache(ixfileHandle);
+    if (rc == SUCCESS)
+    {
+        lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+        ixfileHandle.index->metadata.rootPage = newRootPage;
+        ixfileHandle.index->metadata.height = height;
+        ixfileHandle.index->metadata.entryNumber = order.size();
+        ixfileHandle.index->metadata.leafNumber = leafNumber;
+        rc = writeMetadata(ixfileHandle);
+    }
+    releaseNode(ixfileHandle, rootPageNum, true);
+    pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+    return rc;
+}
+
+RC IndexManager::setFillFactor(IXFileHandle &ixfileHandle, float fillFactor)
+{
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    if (!(fillFactor > 0 && fillFactor <= 1))
+        return IX_INVALID_ARGUMENT;
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    ixfileHandle.index->metadata.fillFactor = fillFactor;
+    return writeMetadata(ixfileHandle);
+}
+
 RC IndexManager::deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid)
 {
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    if (getKeyType(ixfileHandle) != (int32_t) attribute.type || attribute.type == IX_COMPOSITE_KEY)
+        return IX_DELETION_DNE;
+
+    char nodeKey[PAGE_SIZE];
+    toNodeKey(attribute, key, nodeKey);
+    return deleteNodeKey(ixfileHandle, attribute, nodeKey, rid);
+}
+
+RC IndexManager::deleteEntry(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const void *key, const RID &rid)
+{
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    if (!hasKeyFields(ixfileHandle, attributes))
+        return IX_DELETION_DNE;
+
+    char nodeKey[PAGE_SIZE];
+    toCompositeNodeKey(attributes, attributes.size(), key, nodeKey);
+    return deleteNodeKey(ixfileHandle, getCompositeAttribute(), nodeKey, rid);
+}
+
+RC IndexManager::deleteNodeKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid)
+{
+    if (getKeySize(attribute, nodeKey) > IX_MAX_KEY_SIZE)
+        return IX_DELETION_DNE;
+    if (isHashIndex(ixfileHandle))
+        return deleteHashKey(ixfileHandle, attribute, nodeKey, rid);
+
+    PageNum pageNum;
+    void *pageData;
+    vector<NodePathEntry> path;
+    bool rootLatched;
+    RC rc = traverse(ixfileHandle, attribute, nodeKey, false, IX_TRAVERSE_WRITE_LEAF, pageNum, pageData, path, rootLatched);
+    if (rc != SUCCESS)
+        return rc;
+
+    // The entry shrinks, or goes with its last RID
+    unsigned entryNum = lowerBound(pageData, attribute, nodeKey);
+    NodeHeader nodeHeader = getNodePageHeader(pageData);
+    bool found = false;
+    char entry[PAGE_SIZE];
+    unsigned entrySize;
+    if (entryNum < nodeHeader.entryNumber && compareLeafKey(getKeySearch(attribute.type), pageData, entryNum, nodeKey) == 0)
+        rc = removeFromPosting(ixfileHandle, attribute, pageData, entryNum, rid, entry, entrySize, found);
+    if (rc == SUCCESS && found)
+    {
+        removeEntryAt(pageData, attribute, entryNum);
+        if (entrySize > 0)
+            setEntryAtOffset(pageData, entryNum, entry, entrySize);
+    }
+    if (rc == SUCCESS && found)
+        addToPathCounts(ixfileHandle, attribute, path, -1);
+    bool underfull = isUnderfull(pageData);
+    releaseNode(ixfileHandle, pageNum, found);
+    releasePath(ixfileHandle, path, rootLatched);
+    if (rc != SUCCESS)
+        return rc;
+    if (!found)
+        return IX_DELETION_DNE;
+    {
+        lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+        ixfileHandle.index->metadata.entryNumber--;
+        ixfileHandle.index->metadataDirty = true;
+    }
+
+    if (!underfull || deferRebalance(ixfileHandle, attribute, nodeKey, pageNum))
+        return SUCCESS;
+    return rebalanceLeaf(ixfileHandle, attribute, nodeKey, pageNum);
 }
 
 
@@ -100,90 +501,572 @@ RC IndexManager::scan(IXFileHandle &ixfileHandle,
         bool        	highKeyInclusive,
         IX_ScanIterator &ix_ScanIterator)
 {
-    
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    int32_t keyType = getKeyType(ixfileHandle);
+    if ((keyType != IX_NO_KEY_TYPE && keyType != (int32_t) attribute.type) || attribute.type == IX_COMPOSITE_KEY)
+        return IX_KEY_TYPE_MISMATCH;
+
+    char low[PAGE_SIZE];
+    char high[PAGE_SIZE];
+    if (lowKey != NULL)
+        toNodeKey(attribute, lowKey, low);
+    if (highKey != NULL)
+        toNodeKey(attribute, highKey, high);
+    return ix_ScanIterator.scanInit(ixfileHandle, attribute, vector<Attribute>(), lowKey != NULL ? low : NULL,
+            highKey != NULL ? high : NULL, lowKeyInclusive, highKeyInclusive, true);
+}
+
+RC IndexManager::scan(IXFileHandle &ixfileHandle,
+        const vector<Attribute> &attributes,
+        const void      *lowKey,
+        unsigned        lowKeyFields,
+        const void      *highKey,
+        unsigned        highKeyFields,
+        bool			lowKeyInclusive,
+        bool        	highKeyInclusive,
+        IX_ScanIterator &ix_ScanIterator)
+{
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    if (attributes.empty() || attributes.size() > IX_MAX_KEY_FIELDS)
+        return IX_INVALID_ARGUMENT;
+    if ((lowKey != NULL && (lowKeyFields == 0 || lowKeyFields > attributes.size())) ||
+            (highKey != NULL && (highKeyFields == 0 || highKeyFields > attributes.size())))
+        return IX_INVALID_ARGUMENT;
+    if (getKeyType(ixfileHandle) != IX_NO_KEY_TYPE && !hasKeyFields(ixfileHandle, attributes))
+        return IX_KEY_TYPE_MISMATCH;
+
+    char low[PAGE_SIZE];
+    char high[PAGE_SIZE];
+    if (lowKey != NULL)
+        toCompositeNodeKey(attributes, lowKeyFields, lowKey, low);
+    if (highKey != NULL)
+        toCompositeNodeKey(attributes, highKeyFields, highKey, high);
+    return ix_ScanIterator.scanInit(ixfileHandle, getCompositeAttribute(), attributes, lowKey != NULL ? low : NULL,
+            highKey != NULL ? high : NULL, lowKeyInclusive, highKeyInclusive,
+            lowKeyFields == attributes.size() && highKeyFields == attributes.size());
+}
+
+RC IndexManager::countRange(IXFileHandle &ixfileHandle,
+        const Attribute &attribute,
+        const void      *lowKey,
+        const void      *highKey,
+        bool            lowKeyInclusive,
+        bool            highKeyInclusive,
+        uint64_t        &count)
+{
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    int32_t keyType = getKeyType(ixfileHandle);
+    if ((keyType != IX_NO_KEY_TYPE && keyType != (int32_t) attribute.type) || attribute.type == IX_COMPOSITE_KEY)
+        return IX_KEY_TYPE_MISMATCH;
+
+    char low[PAGE_SIZE];
+    char high[PAGE_SIZE];
+    if (lowKey != NULL)
+        toNodeKey(attribute, lowKey, low);
+    if (highKey != NULL)
+        toNodeKey(attribute, highKey, high);
+    return countNodeKeyRange(ixfileHandle, attribute, lowKey != NULL ? low : NULL, highKey != NULL ? high : NULL,
+            lowKeyInclusive, highKeyInclusive, count);
+}
+
+RC IndexManager::countRange(IXFileHandle &ixfileHandle,
+        const vector<Attribute> &attributes,
+        const void      *lowKey,
+        unsigned        lowKeyFields,
+        const void      *highKey,
+        unsigned        highKeyFields,
+        bool            lowKeyInclusive,
+        bool            highKeyInclusive,
+        uint64_t        &count)
+{
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    if (attributes.empty() || attributes.size() > IX_MAX_KEY_FIELDS)
+        return IX_INVALID_ARGUMENT;
+    if ((lowKey != NULL && (lowKeyFields == 0 || lowKeyFields > attributes.size())) ||
+            (highKey != NULL && (highKeyFields == 0 || highKeyFields > attributes.size())))
+        return IX_INVALID_ARGUMENT;
+    if (getKeyType(ixfileHandle) != IX_NO_KEY_TYPE && !hasKeyFields(ixfileHandle, attributes))
+        return IX_KEY_TYPE_MISMATCH;
+
+    char low[PAGE_SIZE];
+    char high[PAGE_SIZE];
+    if (lowKey != NULL)
+        toCompositeNodeKey(attributes, lowKeyFields, lowKey, low);
+    if (highKey != NULL)
+        toCompositeNodeKey(attributes, highKeyFields, highKey, high);
+    return countNodeKeyRange(ixfileHandle, getCompositeAttribute(), lowKey != NULL ? low : NULL,
+            highKey != NULL ? high : NULL, lowKeyInclusive, highKeyInclusive, count);
+}
+
+RC IndexManager::rank(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, uint64_t &position)
+{
+    return countRange(ixfileHandle, attribute, NULL, key, true, false, position);
+}
+
+//goes down by the subtree counts to the leaf entry that holds position, then to the RID in its
+//posting list
+RC IndexManager::select(IXFileHandle &ixfileHandle, const Attribute &attribute, uint64_t position, void *key, RID &rid)
+{
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    int32_t keyType = getKeyType(ixfileHandle);
+    if ((keyType != IX_NO_KEY_TYPE && keyType != (int32_t) attribute.type) || attribute.type == IX_COMPOSITE_KEY)
+        return IX_KEY_TYPE_MISMATCH;
+    if (isHashIndex(ixfileHandle))
+        return IX_UNORDERED_INDEX;
+
+    pthread_rwlock_rdlock(&ixfileHandle.index->rootLatch);
+    PageNum pageNum = ixfileHandle.index->metadata.rootPage;
+    void *pageData;
+    RC rc = fetchNode(ixfileHandle, pageNum, pageData, false);
+    pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+    if (rc != SUCCESS)
+        return rc;
+    while (!getNodePageHeader(pageData).isLeaf())
+    {
+        NodeHeader nodeHeader = getNodePageHeader(pageData);
+        unsigned childIndex = 0;
+        for (; childIndex <= nodeHeader.entryNumber; childIndex++)
+        {
+            SubtreeCount count = __atomic_load_n(getChildCount(attribute, pageData, childIndex), __ATOMIC_RELAXED);
+            if (position < count)
+                break;
+            position -= count;
+        }
+        if (childIndex > nodeHeader.entryNumber)
+        {
+            releaseNode(ixfileHandle, pageNum, false);
+            return IX_EOF;
+        }
+        PageNum child = getChild(attribute, pageData, childIndex);
+        void *childData;
+        rc = fetchNode(ixfileHandle, child, childData, false);
+        releaseNode(ixfileHandle, pageNum, false);
+        if (rc != SUCCESS)
+            return rc;
+        pageNum = child;
+        pageData = childData;
+    }
+
+    NodeHeader nodeHeader = getNodePageHeader(pageData);
+    unsigned entryNum = 0;
+    for (; entryNum < nodeHeader.entryNumber; entryNum++)
+    {
+        unsigned postingSize = getPostingSize(attribute, pageData, entryNum);
+        if (position < postingSize)
+            break;
+        position -= postingSize;
+    }
+    rc = IX_EOF;
+    if (entryNum < nodeHeader.entryNumber)
+    {
+        char nodeKey[PAGE_SIZE];
+        getLeafKey(getKeySearch(attribute.type), pageData, entryNum, nodeKey);
+        fromNodeKey(attribute, nodeKey, key);
+        rc = readPostingRid(ixfileHandle, attribute, pageData, entryNum, position, rid);
+    }
+    releaseNode(ixfileHandle, pageNum, false);
+    return rc;
 }
 
 void IndexManager::printBtree(IXFileHandle &ixfileHandle, const Attribute &attribute) const {
-    unsigned rootPage = getRootPageNum(ixfileHandle);
+    if(isHashIndex(ixfileHandle)){
+        printBuckets(ixfileHandle, attribute);
+        cout<<endl;
+        return;
+    }
+    PageNum rootPage = getRootPageNum(ixfileHandle);
     unsigned tabs = 0;
     printRecursively(ixfileHandle, attribute, rootPage, tabs); 
+    cout<<endl;
+}
+
+//a separator may end part way through a key, the zeros after it end the VarChar there
+void IndexManager::printKey(const Attribute &attribute, const void *nodeKey)const{
+    char paddedKey[PAGE_SIZE] = {0};
+    memcpy(paddedKey, nodeKey, getKeySize(attribute, nodeKey));
+    char key[PAGE_SIZE];
+    fromNodeKey(attribute, paddedKey, key);
+    if(attribute.type==TypeVarChar){
+        int32_t length;
+        memcpy(&length, key, VARCHAR_LENGTH_SIZE);
+        cout.write(key + VARCHAR_LENGTH_SIZE, length);
+    }else if(attribute.type == TypeReal){
+        float value;
+        memcpy(&value, key, sizeof(float));
+        cout<<value;
+    }else{
+        int value;
+        memcpy(&value, key, sizeof(int));
+        cout<<value;
+    }
 }
 
-void IndexManager::printRecursively(IXFileHandle &ixfileHandle, const Attribute &attribute, unsigned pageNum, unsigned tabs)const{
-    if(pageNum<0){
-        return;          //check ----------------------------------
+void IndexManager::printRecursively(IXFileHandle &ixfileHandle, const Attribute &attribute, PageNum pageNum, unsigned tabs)const{
+    void* pageData;
+    if(ixfileHandle.fileHandle.fetchPage(pageNum, pageData) != SUCCESS){
+        return;
     }
-    void* pageData = malloc(PAGE_SIZE);
-    ixfileHandle.fileHandle.readPage(pageNum, pageData);
     NodeHeader nodeHeader = getNodePageHeader(pageData);
-    if(nodeHeader.isLeaf==false){
-        for(unsigned tabCount = 0;tabCount <tabs; tabCount ++){
-            cout<<"\t";
-        }
-        cout<<"{\"keys\": [";
-        for(unsigned i = 0; i<nodeHeader.indexEntryNumber; i++){
+    for(unsigned tabCount = 0;tabCount <tabs; tabCount ++){
+        cout<<"\t";
+    }
+    cout<<"{\"keys\": [";
+    if(!nodeHeader.isLeaf()){
+        for(unsigned i = 0; i<nodeHeader.entryNumber; i++){
             cout<<"\"";
-            NodeEntry temp = getNodeEntry(pageData, i);
-            if(attribute.type==TypeVarChar){
-                cout<<temp.key.strValue;
-            }else if(attribute.type == TypeReal){
-                cout<<temp.key.floatValue;
-            }else{
-                cout<<temp.key.intValue;
-            }
+            printKey(attribute, getEntry(pageData, i));
             cout<<"\"";
-            if(i != nodeHeader.indexEntryNumber-1) cout<<",";
+            if(i != nodeHeader.entryNumber-1u) cout<<",";
         }
         cout<<"],"<<endl;
         for(unsigned tabCount = 0;tabCount <tabs; tabCount ++){
             cout<<"\t";
         }
-        cout<<"\"children\":["<<endl;
-        for(unsigned i = 0;i<nodeHeader.indexEntryNumber;i++){
-            NodeEntry printingNode = getNodeEntry(pageData, i);
-            if(i == 0){
-                printRecursively(ixfileHandle, attribute, printingNode.leftChildPageNum, tabs+1);
-            }
-            printRecursively(ixfileHandle, attribute, printingNode.rightChildPageNum, tabs+1);
+        cout<<"\"children\": ["<<endl;
+        for(unsigned i = 0;i<=nodeHeader.entryNumber;i++){
+            printRecursively(ixfileHandle, attribute, getChild(attribute, pageData, i), tabs+1);
+            if(i != nodeHeader.entryNumber) cout<<",";
+            cout<<endl;
         }
-        cout<<"]}"<<endl;
-    }else{
         for(unsigned tabCount = 0;tabCount <tabs; tabCount ++){
             cout<<"\t";
         }
-        cout<<"{\"keys\": [";
-        for(unsigned i = 0; i<nodeHeader.indexEntryNumber;i++){
+        cout<<"]}";
+    }else{
+        for(unsigned i = 0; i<nodeHeader.entryNumber; i++){
             cout<<"\"";
-            NodeEntry temp = getNodeEntry(pageData,i);
-            if(attribute.type==TypeVarChar){
-                cout<<temp.key.strValue;
-            }else if(attribute.type == TypeReal){
-                cout<<temp.key.floatValue;
-            }else{
-                cout<<temp.key.intValue;
+            char nodeKey[PAGE_SIZE];
+            getLeafKey(getKeySearch(attribute.type), pageData, i, nodeKey);
+            printKey(attribute, nodeKey);
+            cout<<":[";
+            //long posting lists are read a page at a time
+            vector<RID> rids;
+            bool first = true;
+            bool complete;
+            readPosting(ixfileHandle, attribute, pageData, i, NULL, rids, complete);
+            while(!rids.empty()){
+                for(unsigned j = 0; j<rids.size(); j++){
+                    if(!first) cout<<",";
+                    cout<<"("<<rids[j].pageNum<<","<<rids[j].slotNum<<")";
+                    first = false;
+                }
+                RID last = rids.back();
+                rids.clear();
+                readPosting(ixfileHandle, attribute, pageData, i, &last, rids, complete);
             }
-            cout<<":[("<<temp.rid.pageNum<<","<<temp.rid.slotNum<<")]\"";
-            if(i!=nodeHeader.indexEntryNumber-1) cout<<",";
+            cout<<"]\"";
+            if(i != nodeHeader.entryNumber-1u) cout<<",";
         }
-        cout<<"}"<<endl;
+        cout<<"]}";
     }
-    free(pageData);
+    ixfileHandle.fileHandle.unpinPage(pageNum, false);
 }
 
 IX_ScanIterator::IX_ScanIterator()
 {
+    _ix_manager = IndexManager::instance();
+    ixfileHandle = NULL;
+    keySearch = NULL;
+    pageData = NULL;
+    hashScan = false;
+    closed = true;
+    active = false;
 }
 
 IX_ScanIterator::~IX_ScanIterator()
 {
+    close();
+}
+
+RC IX_ScanIterator::scanInit(IXFileHandle &fh, const Attribute &attr, const vector<Attribute> &fields, const void *low,
+        const void *high, bool lowInclusive, bool highInclusive, bool wholeKeys)
+{
+    close();
+
+    ixfileHandle = &fh;
+    attribute = attr;
+    keyFields = fields;
+    keySearch = &IndexManager::getKeySearch(attr.type);
+    hasLowKey = low != NULL;
+    hasHighKey = high != NULL;
+    lowKeyInclusive = lowInclusive;
+    highKeyInclusive = highInclusive;
+    if (hasLowKey)
+    {
+        if (keySearch->keySize(low) > IX_MAX_KEY_SIZE)
+            return IX_KEY_TOO_LONG;
+        memcpy(lowKey, low, keySearch->keySize(low));
+    }
+    if (hasHighKey)
+    {
+        if (keySearch->keySize(high) > IX_MAX_KEY_SIZE)
+            return IX_KEY_TOO_LONG;
+        memcpy(highKey, high, keySearch->keySize(high));
+    }
+    returnedEntry = false;
+    rids.clear();
+    nextRid = 0;
+
+    // A hash index is read from its buckets as getNextEntry goes. A scan for one whole key only
+    // looks at its bucket
+    hashScan = _ix_manager->isHashIndex(fh);
+    if (hashScan)
+    {
+        hashKeys.clear();
+        nextKey = 0;
+        hashPosition = 0;
+        if (wholeKeys && hasLowKey && hasHighKey && lowKeyInclusive && highKeyInclusive &&
+                keySearch->keySize(lowKey) == keySearch->keySize(highKey) &&
+                memcmp(lowKey, highKey, keySearch->keySize(lowKey)) == 0)
+        {
+            hashKeys.push_back(string(lowKey, keySearch->keySize(lowKey)));
+            hashPosition = (uint64_t) 1 << 32;
+        }
+        closed = false;
+        return SUCCESS;
+    }
+
+    // Counted before the descent, so a delete that has not started rebalancing yet won't
+    active = true;
+    ixfileHandle->openScans++;
+    ixfileHandle->index->openScans++;
+
+    // One descent to the first leaf that may hold lowKey, the rest of the scan follows the leaf chain
+    vector<NodePathEntry> path;
+    bool rootLatched;
+    RC rc = _ix_manager->traverse(*ixfileHandle, attribute, hasLowKey ? lowKey : NULL, true, IX_TRAVERSE_READ,
+            currentPage, pageData, path, rootLatched);
+    if (rc != SUCCESS)
+    {
+        pageData = NULL;
+        release();
+        return rc;
+    }
+
+    NodeHeader nodeHeader = _ix_manager->getNodePageHeader(pageData);
+    if (nodeHeader.rightPageNum != IX_NO_PAGE)
+        ixfileHandle->fileHandle.prefetchPage(nodeHeader.rightPageNum);
+
+    ixfileHandle->fileHandle.unlatchPage(currentPage);
+    closed = false;
+    return SUCCESS;
+}
+
+
+
+// Moves to the next leaf, latching it before the current one is let go
+RC IX_ScanIterator::nextLeaf(bool &atEnd)
+{
+    NodeHeader nodeHeader = _ix_manager->getNodePageHeader(pageData);
+    atEnd = nodeHeader.rightPageNum == IX_NO_PAGE;
+    if (atEnd)
+        return SUCCESS;
+
+    PageNum nextPage = nodeHeader.rightPageNum;
+    void *nextPageData;
+    if (ixfileHandle->fileHandle.fetchPage(nextPage, nextPageData))
+        return IX_READ_FAILED;
+    ixfileHandle->fileHandle.latchPage(nextPage, false);
+    ixfileHandle->fileHandle.unlatchPage(currentPage);
+    ixfileHandle->fileHandle.unpinPage(currentPage, false);
+    currentPage = nextPage;
+    pageData = nextPageData;
+
+    // Read the following leaf in the background while this one is consumed
+    nodeHeader = _ix_manager->getNodePageHeader(pageData);
+    if (nodeHeader.rightPageNum != IX_NO_PAGE)
+        ixfileHandle->fileHandle.prefetchPage(nodeHeader.rightPageNum);
+    return SUCCESS;
 }
 
 RC IX_ScanIterator::getNextEntry(RID &rid, void *key)
 {  
+    if (closed)
+        return IX_SCANNER_CLOSED;
+    if (hashScan)
+        return nextHashEntry(rid, key);
+    if (pageData == NULL)
+        return IX_EOF;
+
+    // The rest of the current key's RIDs were copied out already
+    if (nextRid < rids.size())
+    {
+        rid = lastRid = rids[nextRid++];
+        copyKey(key);
+        return SUCCESS;
+    }
+
+    // Other threads may change the leaf between calls, so it is only latched while we read it
+    ixfileHandle->fileHandle.latchPage(currentPage, false);
+    RC rc = nextEntry(rid, key);
+    ixfileHandle->fileHandle.unlatchPage(currentPage);
+    if (rc == IX_EOF)
+        release();
+    return rc;
+}
+
+// Entries may have been inserted or deleted since the last call, or moved on to the next leaf
+// by a split. (key, RID) pairs are in order across the leaves, so the last one we returned
+// still tells us where to continue. Until then we start from lowKey.
+RC IX_ScanIterator::nextEntry(RID &rid, void *key)
+{
+    while (true)
+    {
+        NodeHeader nodeHeader = _ix_manager->getNodePageHeader(pageData);
+        unsigned entryNum = 0;
+        if (returnedEntry && lastEntry < nodeHeader.entryNumber &&
+                IndexManager::compareLeafKey(*keySearch, pageData, lastEntry, lastKey) == 0)
+            entryNum = lastComplete ? lastEntry + 1 : lastEntry;
+        else if (returnedEntry)
+            entryNum = IndexManager::searchLeaf(*keySearch, pageData, lastKey, false);
+        else if (hasLowKey)
+            entryNum = IndexManager::searchLeaf(*keySearch, pageData, lowKey, !lowKeyInclusive);
+
+        for (; entryNum < nodeHeader.entryNumber; entryNum++)
+        {
+            if (hasHighKey)
+            {
+                int result = IndexManager::compareLeafKey(*keySearch, pageData, entryNum, highKey);
+                if (result > 0 || (result == 0 && !highKeyInclusive))
+                    return IX_EOF;
+            }
+
+            bool sameKey = returnedEntry && IndexManager::compareLeafKey(*keySearch, pageData, entryNum, lastKey) == 0;
+            rids.clear();
+            bool complete;
+            RC rc = _ix_manager->readPosting(*ixfileHandle, attribute, pageData, entryNum, sameKey ? &lastRid : NULL, rids,
+                    complete);
+            if (rc != SUCCESS)
+                return rc;
+            if (rids.empty())
+                continue;
+
+            IndexManager::getLeafKey(*keySearch, pageData, entryNum, lastKey);
+            rid = lastRid = rids[0];
+            nextRid = 1;
+            returnedEntry = true;
+            lastEntry = entryNum;
+            lastComplete = complete;
+            copyKey(key);
+            return SUCCESS;
+        }
+
+        bool atEnd;
+        RC rc = nextLeaf(atEnd);
+        if (rc != SUCCESS)
+            return rc;
+        if (atEnd)
+            return IX_EOF;
+    }
+}
+
+// Each key's RIDs are read a posting page at a time, finding the key again each time since a
+// split may have moved it to another bucket. A key deleted meanwhile is passed over
+RC IX_ScanIterator::nextHashEntry(RID &rid, void *key)
+{
+    while (true)
+    {
+        if (nextRid < rids.size())
+        {
+            rid = lastRid = rids[nextRid++];
+            copyKey(key);
+            return SUCCESS;
+        }
+        rids.clear();
+        nextRid = 0;
+        RC rc;
+        if (returnedEntry && !lastComplete)
+        {
+            rc = _ix_manager->readHashPosting(*ixfileHandle, attribute, lastKey, &lastRid, rids, lastComplete);
+            if (rc != SUCCESS)
+                return rc;
+            continue;
+        }
+        if (nextKey < hashKeys.size())
+        {
+            memcpy(lastKey, hashKeys[nextKey].data(), hashKeys[nextKey].size());
+            nextKey++;
+            rc = _ix_manager->readHashPosting(*ixfileHandle, attribute, lastKey, NULL, rids, lastComplete);
+            if (rc != SUCCESS)
+                return rc;
+            returnedEntry = true;
+            continue;
+        }
+        if (hashPosition >> 32)
+            return IX_EOF;
+
+        vector<string> bucketKeys;
+        rc = _ix_manager->readHashBucket(*ixfileHandle, attribute, hashPosition, bucketKeys);
+        if (rc != SUCCESS)
+            return rc;
+        hashKeys.clear();
+        nextKey = 0;
+        returnedEntry = false;
+        for (unsigned i = 0; i < bucketKeys.size(); i++)
+        {
+            if (inBounds(bucketKeys[i].data()))
+                hashKeys.push_back(bucketKeys[i]);
+        }
+    }
+}
+
+bool IX_ScanIterator::inBounds(const void *nodeKey)const
+{
+    if (hasLowKey)
+    {
+        int result = keySearch->compare(nodeKey, lowKey);
+        if (result < 0 || (result == 0 && !lowKeyInclusive))
+            return false;
+    }
+    if (hasHighKey)
+    {
+        int result = keySearch->compare(nodeKey, highKey);
+        if (result > 0 || (result == 0 && !highKeyInclusive))
+            return false;
+    }
+    return true;
+}
+
+// Keys of a composite index go back as tuples over its attributes
+void IX_ScanIterator::copyKey(void *key)
+{
+    if (keyFields.empty())
+        _ix_manager->fromNodeKey(attribute, lastKey, key);
+    else
+        _ix_manager->fromCompositeNodeKey(keyFields, lastKey, key);
+}
+
+// Unpins the current leaf and lets deletes on the file rebalance again
+void IX_ScanIterator::release()
+{
+    if (pageData != NULL)
+    {
+        ixfileHandle->fileHandle.unpinPage(currentPage, false);
+        pageData = NULL;
+    }
+    rids.clear();
+    nextRid = 0;
+    hashKeys.clear();
+    nextKey = 0;
+    hashPosition = (uint64_t) 1 << 32;
+    if (active)
+    {
+        active = false;
+        _ix_manager->endScan(*ixfileHandle);
+        ixfileHandle->openScans--;
+    }
 }
 
 RC IX_ScanIterator::close()
 {
+    release();
+    closed = true;
+    return SUCCESS;
 }
 
 
@@ -192,14 +1075,29 @@ IXFileHandle::IXFileHandle()
     ixReadPageCounter = 0; 
     ixWritePageCounter = 0;
     ixAppendPageCounter = 0;
-    rootPage =-1;
-    // fileHandle = 0;
+    index = &closedIndex;
+    openScans = 0;
 }
 
 IXFileHandle::~IXFileHandle()
 {
 }
 
+IndexFile::IndexFile()
+{
+    handleCount = 0;
+    memset(&metadata, 0, sizeof(IndexMetadata));
+    metadataDirty = false;
+    openScans = 0;
+    lastInsert = getInsertPosition(IX_NO_PAGE, 0);
+    pthread_rwlock_init(&rootLatch, NULL);
+}
+
+IndexFile::~IndexFile()
+{
+    pthread_rwlock_destroy(&rootLatch);
+}
+
 RC IXFileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount)
 {
     if(fileHandle.collectCounterValues(ixReadPageCounter, ixWritePageCounter, ixAppendPageCounter)){
@@ -212,21 +1110,20 @@ RC IXFileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePa
     return SUCCESS;
 }
 
-void IndexManager::newIndexPage(void * page)
+void IndexManager::newIndexPage(void * page, PageNum leftChild)
 {
     memset(page, 0, PAGE_SIZE);
     NodeHeader nodeHeader;
-    nodeHeader.endOfEntries = sizeof(NodeHeader);
-    nodeHeader.indexEntryNumber = 0;
-    nodeHeader.isLeaf = false;
-    // nodeHeader.isRoot = false;
-    nodeHeader.leftPageNum = -1;
-    nodeHeader.rightPageNum = -1;
-    nodeHeader.parent = -1;
-    memcpy (page, &nodeHeader, sizeof(NodeHeader));
+    //a leaf starts with an empty key prefix, an internal node with a count of 0 for leftChild
+    nodeHeader.freeSpaceOffset = leftChild == IX_NO_PAGE ? PAGE_SIZE - sizeof(VarCharKeyLength) : PAGE_SIZE - sizeof(SubtreeCount);
+    nodeHeader.entryNumber = 0;
+    nodeHeader.leftPageNum = IX_NO_PAGE;
+    nodeHeader.rightPageNum = IX_NO_PAGE;
+    nodeHeader.leftChild = leftChild;
+    setNodePageHeader(page, nodeHeader);
 }
 
-NodeHeader IndexManager::getNodePageHeader(void * page)const{
+NodeHeader IndexManager::getNodePageHeader(const void * page)const{
     NodeHeader nodeHeader;
     memcpy (&nodeHeader, page, sizeof(NodeHeader));
     return nodeHeader;
@@ -236,346 +1133,2724 @@ void IndexManager::setNodePageHeader(void * page, NodeHeader nodeHeader){
     memcpy (page, &nodeHeader, sizeof(NodeHeader));
 }
 
-NodeEntry IndexManager::getNodeEntry(void* page, unsigned entryNum)const{
-    NodeEntry entry;
-    unsigned offset = sizeof(NodeHeader) + entryNum * sizeof(NodeEntry);
-    memcpy(&entry, (char*)page + offset, sizeof(NodeEntry));
-    return entry;
-}
-
-unsigned IndexManager::getRootPageNum(IXFileHandle ixfileHandle)const{
-    // void *pageData = malloc(PAGE_SIZE);
-    // if (pageData == NULL)
-    //     return IX_MALLOC_FAILED;
-    // unsigned i;
-    // unsigned numPages = ixfileHandle.fileHandle.getNumberOfPages();
-    // for (i = 0; i < numPages; i++)
-    // {
-    //     if (ixfileHandle.fileHandle.readPage(i, pageData))
-    //         return IX_READ_FAILED;  
-        
-    //     NodeHeader nodeHeader = getNodePageHeader(pageData);
-    //     if(nodeHeader.isRoot == true){
-    //         break;
-    //     }
-    // }
-    // free(pageData);
-    // return i;
-    return ixfileHandle.rootPage;
-}
-
-unsigned IndexManager::traverse(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key){
-    bool atLeaf = false;
-    unsigned currentPage = getRootPageNum(ixfileHandle);
-    while(atLeaf == false && currentPage >= 0){
-        void* pageData = malloc(PAGE_SIZE);
-        if (ixfileHandle.fileHandle.readPage(currentPage, pageData) != SUCCESS)
-        {
-            free(pageData);
-            return IX_READ_FAILED;
-        }
-        NodeHeader nodeHeader = getNodePageHeader(pageData);
-        if(nodeHeader.isLeaf == true){
-            atLeaf = true;
-            free(pageData);
-            break;
-        }
-        //find correct entry
-        unsigned entryNumber = findPointerEntry(pageData, attribute, key);
-        //decide where to go
-        NodeEntry entry = getNodeEntry(pageData, entryNumber);
-        int result = compare(attribute,entry, key);
-        //set current page
-        if(result > 0){
-            currentPage = entry.leftChildPageNum;
-        }else{
-            currentPage = entry.rightChildPageNum;
-        }
-        free(pageData);
-    }
-    return currentPage;
+NodeSlot* IndexManager::getSlots(const void* page){
+    return (NodeSlot*)((char*)page + sizeof(NodeHeader));
 }
 
-unsigned IndexManager::findPointerEntry(void* page, const Attribute &attribute, const void *key){
-    NodeHeader nodeHeader = getNodePageHeader(page);
-    unsigned i;
-    for(i=0; i<nodeHeader.indexEntryNumber; i++){
-        NodeEntry entry = getNodeEntry(page, i);
-        int result = compare(attribute, entry, key);
-        if(result > 0 || i==nodeHeader.indexEntryNumber-1){
-            break;
-        }
-    }
-    return i;
+char* IndexManager::getEntry(const void* page, unsigned entryNum){
+    return (char*)page + getSlots(page)[entryNum];
 }
 
-unsigned IndexManager::findPointerEntryInParent(void* page, const Attribute &attribute, const void *key){
+unsigned IndexManager::getEntrySize(const Attribute &attribute, const void* page, unsigned entryNum)const{
     NodeHeader nodeHeader = getNodePageHeader(page);
-    unsigned i;
-    for(i=0; i<nodeHeader.indexEntryNumber; i++){
-        NodeEntry entry = getNodeEntry(page, i);
-        int result = compareInParent(attribute, entry, key);
-        if(result > 0 || i==nodeHeader.indexEntryNumber-1){
-            break;
-        }
+    const char *entry = getEntry(page, entryNum);
+    if(!nodeHeader.isLeaf()){
+        return getInternalEntrySize(attribute, entry);
+    }
+    unsigned keySize = getKeySize(attribute, entry);
+    PostingHeader postingHeader;
+    memcpy(&postingHeader, entry + keySize, sizeof(PostingHeader));
+    if(postingHeader == IX_POSTING_OVERFLOW){
+        return keySize + sizeof(PostingHeader) + sizeof(OverflowPosting);
     }
-    return i;
+    return keySize + sizeof(PostingHeader) + postingHeader;
 }
 
-//returns -1 if entry.key is less than key, returns 1 otherwise
-//sign points at whatever is smaller
-int IndexManager::compare(const Attribute &attribute, NodeEntry &entry, const void *key){
-    if(attribute.type == TypeVarChar){
-        int lengthOfVarChar;
-        memcpy(&lengthOfVarChar,key, sizeof(int));
-        char varCharBuffer[lengthOfVarChar+1];
-        memcpy(varCharBuffer,(char*)key+sizeof(int), lengthOfVarChar);
-        varCharBuffer[lengthOfVarChar]='\0';
+unsigned IndexManager::getNodeFreeSpace(const void* page)const{
+    NodeHeader nodeHeader = getNodePageHeader(page);
+    return nodeHeader.freeSpaceOffset - sizeof(NodeHeader) - nodeHeader.entryNumber * sizeof(NodeSlot);
+}
 
-        return strcmp(entry.key.strValue, varCharBuffer);
-    }else if(attribute.type == TypeReal){
-        if(entry.key.floatValue<*((float*)key)){return -1;}
-        else if(entry.key.floatValue==*((float*)key)){return 0;}
-        else {return 1;}                            
-    }else{
-        if(entry.key.intValue<*((int*)key)){ return -1;}     
-        else if(entry.key.intValue == *((int*)key)){return 0;}
-        else {return 1;}
+PageNum IndexManager::getChild(const Attribute &attribute, const void* page, unsigned childIndex)const{
+    if(childIndex == 0){
+        return getNodePageHeader(page).leftChild;
     }
+    const char *entry = getEntry(page, childIndex - 1);
+    PageNum child;
+    memcpy(&child, entry + getPaddedKeySize(attribute, entry), sizeof(PageNum));
+    return child;
 }
 
-int IndexManager::compareInParent(const Attribute &attribute, NodeEntry &entry, const void *key){
-    if(attribute.type == TypeVarChar){
-        int lengthOfVarChar = strlen((char*)key);
-        // memcpy(&lengthOfVarChar,key, sizeof(int));
-        char varCharBuffer[lengthOfVarChar+1];
-        memcpy(varCharBuffer,(char*)key, lengthOfVarChar);
-        varCharBuffer[lengthOfVarChar]='\0';
-
-        return strcmp(entry.key.strValue, varCharBuffer);
-    }else if(attribute.type == TypeReal){
-        if(entry.key.floatValue<*((float*)key)){return -1;}
-        else if(entry.key.floatValue==*((float*)key)){return 0;}
-        else {return 1;}                            
-    }else{
-        if(entry.key.intValue<*((int*)key)){ return -1;}     
-        else if(entry.key.intValue == *((int*)key)){return 0;}
-        else {return 1;}
+SubtreeCount* IndexManager::getChildCount(const Attribute &attribute, const void* page, unsigned childIndex)const{
+    if(childIndex == 0){
+        return (SubtreeCount*)((char*)page + PAGE_SIZE - sizeof(SubtreeCount));
     }
+    char *entry = getEntry(page, childIndex - 1);
+    return (SubtreeCount*)(entry + getPaddedKeySize(attribute, entry) + sizeof(PageNum));
 }
 
-void IndexManager::setEntryAtOffset(void* page, unsigned offset, NodeEntry &entry){
-    NodeHeader nodeHeader = getNodePageHeader(page);
-    int movingBlockSize = nodeHeader.endOfEntries - offset;
-    memmove((char*)page+offset+sizeof(NodeEntry), (char*)page+offset, movingBlockSize);
-    
-    memcpy((char*)page + offset, &entry, sizeof(NodeEntry));
+
+
+unsigned IndexManager::getRootPageNum(IXFileHandle &ixfileHandle)const{
+    return ixfileHandle.index->metadata.rootPage;
 }
 
-void IndexManager::insertInSortedOrder(void* page, const Attribute &attribute, const void *key, const RID &rid, unsigned left, unsigned right){
-    //insert in sorted order
-    //find correct place
-    NodeHeader nodeHeader = getNodePageHeader(page);
-    unsigned entryNum = findPointerEntry(page, attribute, key);
-    if(nodeHeader.indexEntryNumber!=0){
-        NodeEntry testEntry = getNodeEntry(page, entryNum);
-        if(compare(attribute, testEntry, key)<=0){ 
-            entryNum++;
-        }
-    }
-    unsigned offset = sizeof(NodeHeader) + entryNum * sizeof(NodeEntry);
-    //insert entry
-    NodeEntry entry;
-    entry.rid = rid;
-    if(attribute.type == TypeInt){
-        entry.key.intValue = *((int*)key);               
-    }else if(attribute.type == TypeReal){
-        entry.key.floatValue = *((float*)key);
+RC IndexManager::readMetadata(IXFileHandle &ixfileHandle){
+    void *pageData;
+    if (ixfileHandle.fileHandle.fetchPage(IX_METADATA_PAGE, pageData))
+        return IX_READ_FAILED;
+    memcpy(&ixfileHandle.index->metadata, pageData, sizeof(IndexMetadata));
+    ixfileHandle.fileHandle.unpinPage(IX_METADATA_PAGE, false);
+    ixfileHandle.index->metadataDirty = false;
+
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC || ixfileHandle.index->metadata.version != IX_FORMAT_VERSION)
+        return IX_BAD_FORMAT;
+    return SUCCESS;
+}
+
+//the caller holds the metadata latch
+RC IndexManager::writeMetadata(IXFileHandle &ixfileHandle){
+    void *pageData;
+    if (ixfileHandle.fileHandle.fetchPage(IX_METADATA_PAGE, pageData))
+        return IX_READ_FAILED;
+    memcpy(pageData, &ixfileHandle.index->metadata, sizeof(IndexMetadata));
+    ixfileHandle.fileHandle.unpinPage(IX_METADATA_PAGE, true);
+    ixfileHandle.index->metadataDirty = false;
+    return SUCCESS;
+}
+
+//the first insert fixes the key type, later calls must use the same one
+RC IndexManager::checkKeyType(IXFileHandle &ixfileHandle, const Attribute &attribute){
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    if (attribute.type == IX_COMPOSITE_KEY)
+        return IX_INVALID_ARGUMENT;
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    if (ixfileHandle.index->metadata.keyType == IX_NO_KEY_TYPE)
+    {
+        ixfileHandle.index->metadata.keyType = attribute.type;
+        ixfileHandle.index->metadataDirty = true;
+        return SUCCESS;
+    }
+    if (ixfileHandle.index->metadata.keyType != (int32_t) attribute.type)
+        return IX_KEY_TYPE_MISMATCH;
+    return SUCCESS;
+}
+
+float IndexManager::getFillFactor(IXFileHandle &ixfileHandle){
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    return ixfileHandle.index->metadata.fillFactor > 0 ? ixfileHandle.index->metadata.fillFactor : IX_DEFAULT_FILL_FACTOR;
+}
+
+int32_t IndexManager::getKeyType(IXFileHandle &ixfileHandle){
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    return ixfileHandle.index->metadata.keyType;
+}
+
+//a composite index is fixed to the types of its fields the same way
+RC IndexManager::checkKeyFields(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes){
+    if (ixfileHandle.index->metadata.magic != IX_MAGIC)
+        return IX_FILE_DNE;
+    if (attributes.empty() || attributes.size() > IX_MAX_KEY_FIELDS)
+        return IX_INVALID_ARGUMENT;
+    {
+        lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+        if (ixfileHandle.index->metadata.keyType == IX_NO_KEY_TYPE)
+        {
+            for (unsigned i = 0; i < attributes.size(); i++)
+            {
+                if (attributes[i].type > TypeVarChar)
+                    return IX_INVALID_ARGUMENT;
+                ixfileHandle.index->metadata.keyFieldTypes[i] = attributes[i].type;
+            }
+            ixfileHandle.index->metadata.keyType = IX_COMPOSITE_KEY;
+            ixfileHandle.index->metadata.keyFieldNumber = attributes.size();
+            ixfileHandle.index->metadataDirty = true;
+            return SUCCESS;
+        }
+    }
+    return hasKeyFields(ixfileHandle, attributes) ? SUCCESS : IX_KEY_TYPE_MISMATCH;
+}
+
+bool IndexManager::hasKeyFields(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes){
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    if (ixfileHandle.index->metadata.keyType != IX_COMPOSITE_KEY || ixfileHandle.index->metadata.keyFieldNumber != attributes.size())
+        return false;
+    for (unsigned i = 0; i < attributes.size(); i++)
+    {
+        if (ixfileHandle.index->metadata.keyFieldTypes[i] != (int32_t) attributes[i].type)
+            return false;
+    }
+    return true;
+}
+
+Attribute IndexManager::getCompositeAttribute(){
+    Attribute attribute;
+    attribute.type = IX_COMPOSITE_KEY;
+    attribute.length = IX_MAX_KEY_SIZE;
+    return attribute;
+}
+
+unsigned IndexManager::getKeySize(const Attribute &attribute, const void *nodeKey)const{
+    return getKeySearch(attribute.type).keySize(nodeKey);
+}
+
+//keys come in as the record manager stores them: Int and Real in 4 bytes, VarChar with a 4 byte
+//length
+void IndexManager::toNodeKey(const Attribute &attribute, const void *key, void *nodeKey)const{
+    unsigned char *out = (unsigned char*)nodeKey;
+    unsigned valueSize;
+    if(attribute.type == TypeVarChar){
+        VarCharKeyLength nodeLength = encodeKeyValue(TypeVarChar, key, valueSize, out + sizeof(VarCharKeyLength));
+        memcpy(nodeKey, &nodeLength, sizeof(VarCharKeyLength));
+    }else{
+        encodeKeyValue(attribute.type, key, valueSize, out);
+    }
+}
+
+void IndexManager::fromNodeKey(const Attribute &attribute, const void *nodeKey, void *key)const{
+    const unsigned char *in = (const unsigned char*)nodeKey;
+    unsigned valueSize;
+    if(attribute.type == TypeVarChar){
+        in += sizeof(VarCharKeyLength);
+    }
+    decodeKeyValue(attribute.type, in, key, valueSize);
+}
+
+//the fields of a composite key are encoded one after the other. Once the key is too long to be
+//accepted the rest is left out, so a key with several long VarChars can't overflow nodeKey
+void IndexManager::toCompositeNodeKey(const vector<Attribute> &attributes, unsigned fieldNumber, const void *key,
+        void *nodeKey)const{
+    const unsigned char *nulls = (const unsigned char*)key;
+    const char *value = (const char*)key + (fieldNumber + CHAR_BIT - 1) / CHAR_BIT;
+    unsigned char *out = (unsigned char*)nodeKey + sizeof(VarCharKeyLength);
+    VarCharKeyLength nodeLength = 0;
+    for(unsigned i = 0; i < fieldNumber && nodeLength <= IX_MAX_KEY_SIZE; i++){
+        if(nulls[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - i % CHAR_BIT))){
+            out[nodeLength++] = 0x00;
+            continue;
+        }
+        out[nodeLength++] = 0x01;
+        unsigned valueSize;
+        nodeLength += encodeKeyValue(attributes[i].type, value, valueSize, out + nodeLength);
+        value += valueSize;
+    }
+    memcpy(nodeKey, &nodeLength, sizeof(VarCharKeyLength));
+}
+
+void IndexManager::fromCompositeNodeKey(const vector<Attribute> &attributes, const void *nodeKey, void *key)const{
+    const unsigned char *in = (const unsigned char*)nodeKey + sizeof(VarCharKeyLength);
+    unsigned char *nulls = (unsigned char*)key;
+    unsigned nullSize = (attributes.size() + CHAR_BIT - 1) / CHAR_BIT;
+    char *value = (char*)key + nullSize;
+    memset(nulls, 0, nullSize);
+    for(unsigned i = 0; i < attributes.size(); i++){
+        if(*in++ == 0x00){
+            nulls[i / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - i % CHAR_BIT);
+            continue;
+        }
+        unsigned valueSize;
+        in += decodeKeyValue(attributes[i].type, in, value, valueSize);
+        value += valueSize;
+    }
+}
+
+//Real -0.0 is stored as 0.0 so the two stay equal
+unsigned IndexManager::encodeKeyValue(AttrType type, const void *value, unsigned &valueSize, unsigned char *out)const{
+    if(type == TypeVarChar){
+        int32_t length;
+        memcpy(&length, value, VARCHAR_LENGTH_SIZE);
+        valueSize = VARCHAR_LENGTH_SIZE + length;
+        if(length > IX_MAX_KEY_SIZE){
+            length = IX_MAX_KEY_SIZE;   //rejected by the size check, don't copy the rest
+        }
+        const unsigned char *in = (const unsigned char*)value + VARCHAR_LENGTH_SIZE;
+        unsigned encodedSize = 0;
+        for(int32_t i = 0; i < length; i++){
+            out[encodedSize++] = in[i];
+            if(in[i] == 0x00){
+                out[encodedSize++] = 0xFF;
+            }
+        }
+        out[encodedSize++] = 0x00;
+        out[encodedSize++] = 0x00;
+        return encodedSize;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, value, sizeof(uint32_t));
+    if(type == TypeReal){
+        if(bits == 0x80000000u){
+            bits = 0;
+        }
+        bits = (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
     }else{
-        int lengthOfVarChar;
-        memcpy(&lengthOfVarChar,key, sizeof(int));
-        char varCharBuffer[lengthOfVarChar+1];
-        memcpy(varCharBuffer,(char*)key+sizeof(int), lengthOfVarChar);
-        varCharBuffer[lengthOfVarChar]='\0';
-        entry.key.strValue = (char*)malloc(lengthOfVarChar + 1);
-        strcpy(entry.key.strValue, varCharBuffer);  
-    }
-    entry.leftChildPageNum = left;
-    entry.rightChildPageNum = right;
-    setEntryAtOffset(page, offset, entry);
+        bits ^= 0x80000000u;
+    }
+    out[0] = bits >> 24;
+    out[1] = bits >> 16;
+    out[2] = bits >> 8;
+    out[3] = bits;
+    valueSize = sizeof(uint32_t);
+    return sizeof(uint32_t);
+}
+
+//a VarChar ends at the first 0x00 that isn't followed by the escape 0xFF
+unsigned IndexManager::decodeKeyValue(AttrType type, const unsigned char *in, void *value, unsigned &valueSize)const{
+    if(type == TypeVarChar){
+        char *out = (char*)value + VARCHAR_LENGTH_SIZE;
+        int32_t length = 0;
+        unsigned i = 0;
+        while(in[i] != 0x00 || in[i + 1] != 0x00){
+            out[length++] = in[i];
+            i += in[i] == 0x00 ? 2 : 1;     //skip the escape
+        }
+        memcpy(value, &length, VARCHAR_LENGTH_SIZE);
+        valueSize = VARCHAR_LENGTH_SIZE + length;
+        return i + 2;
+    }
+
+    uint32_t bits = (uint32_t)in[0] << 24 | (uint32_t)in[1] << 16 | (uint32_t)in[2] << 8 | in[3];
+    if(type == TypeReal){
+        bits = (bits & 0x80000000u) ? bits ^ 0x80000000u : ~bits;
+    }else{
+        bits ^= 0x80000000u;
+    }
+    memcpy(value, &bits, sizeof(uint32_t));
+    valueSize = sizeof(uint32_t);
+    return sizeof(uint32_t);
+}
+
+int IndexManager::compare(const Attribute &attribute, const void *entryKey, const void *key)const{
+    return getKeySearch(attribute.type).compare(entryKey, key);
+}
+
+unsigned IndexManager::lowerBound(const void* page, const Attribute &attribute, const void *key)const{
+    return searchLeaf(getKeySearch(attribute.type), page, key, false);
+}
+
+unsigned IndexManager::upperBound(const void* page, const Attribute &attribute, const void *key)const{
+    return searchLeaf(getKeySearch(attribute.type), page, key, true);
+}
+
+//keys that are a VarCharKeyLength and their bytes, which leaves can store a prefix of once
+static bool hasVarCharLayout(AttrType type){
+    return type == TypeVarChar || type == IX_COMPOSITE_KEY;
+}
+
+//normalized keys compare with memcmp. Int and Real keys are always 4 bytes long. VarChar keys
+//are compared over the shorter length, which always differs somewhere from a longer key
+struct FixedKey
+{
+    static unsigned size(const void *nodeKey){
+        return sizeof(uint32_t);
+    }
+
+    static int compare(const void *entryKey, const void *key){
+        return memcmp(entryKey, key, sizeof(uint32_t));
+    }
+};
+
+struct VarCharKey
+{
+    static unsigned size(const void *nodeKey){
+        VarCharKeyLength length;
+        memcpy(&length, nodeKey, sizeof(VarCharKeyLength));
+        return sizeof(VarCharKeyLength) + length;
+    }
+
+    static int compare(const void *entryKey, const void *key){
+        VarCharKeyLength entryLength, keyLength;
+        memcpy(&entryLength, entryKey, sizeof(VarCharKeyLength));
+        memcpy(&keyLength, key, sizeof(VarCharKeyLength));
+        return memcmp((const char*)entryKey + sizeof(VarCharKeyLength), (const char*)key + sizeof(VarCharKeyLength),
+                min(entryLength, keyLength));
+    }
+};
+
+//separators are compared as plain byte strings, so one that is a prefix of a key sorts before it
+struct SeparatorKey
+{
+    static unsigned size(const void *nodeKey){
+        return VarCharKey::size(nodeKey);
+    }
+
+    static int compare(const void *entryKey, const void *key){
+        VarCharKeyLength entryLength, keyLength;
+        memcpy(&entryLength, entryKey, sizeof(VarCharKeyLength));
+        memcpy(&keyLength, key, sizeof(VarCharKeyLength));
+        int result = memcmp((const char*)entryKey + sizeof(VarCharKeyLength), (const char*)key + sizeof(VarCharKeyLength),
+                min(entryLength, keyLength));
+        return result != 0 ? result : (int) entryLength - (int) keyLength;
+    }
+};
+
+template<class Key>
+unsigned IndexManager::lowerBoundOf(const void *page, const void *key){
+    NodeHeader nodeHeader;
+    memcpy(&nodeHeader, page, sizeof(NodeHeader));
+    unsigned low = 0;
+    unsigned high = nodeHeader.entryNumber;
+    while(low < high){
+        unsigned mid = low + (high - low) / 2;
+        if(Key::compare(getEntry(page, mid), key) < 0){
+            low = mid + 1;
+        }else{
+            high = mid;
+        }
+    }
+    return low;
+}
+
+template<class Key>
+unsigned IndexManager::upperBoundOf(const void *page, const void *key){
+    NodeHeader nodeHeader;
+    memcpy(&nodeHeader, page, sizeof(NodeHeader));
+    unsigned low = 0;
+    unsigned high = nodeHeader.entryNumber;
+    while(low < high){
+        unsigned mid = low + (high - low) / 2;
+        if(Key::compare(getEntry(page, mid), key) <= 0){
+            low = mid + 1;
+        }else{
+            high = mid;
+        }
+    }
+    return low;
+}
+
+const KeySearch &IndexManager::getKeySearch(AttrType type){
+    static const KeySearch fixedSearch = {FixedKey::size, FixedKey::compare, lowerBoundOf<FixedKey>, upperBoundOf<FixedKey>,
+            lowerBoundOf<FixedKey>, upperBoundOf<FixedKey>};
+    static const KeySearch varCharSearch = {VarCharKey::size, VarCharKey::compare, lowerBoundOf<VarCharKey>,
+            upperBoundOf<VarCharKey>, lowerBoundOf<SeparatorKey>, upperBoundOf<SeparatorKey>};
+    return hasVarCharLayout(type) ? varCharSearch : fixedSearch;
+}
+
+//child i lies between the keys of entries i - 1 and i. Duplicates of a separator may be on
+//both sides of it, so the leftmost descent stops short of any separator equal to key
+unsigned IndexManager::findPointerEntry(const void* page, const KeySearch &keySearch, const void *key, bool leftmost)const{
+    return leftmost ? keySearch.separatorLowerBound(page, key) : keySearch.separatorUpperBound(page, key);
+}
+
+unsigned IndexManager::getLeafPrefix(const void *page, const unsigned char *&prefix){
+    VarCharKeyLength prefixLength;
+    memcpy(&prefixLength, (const char*)page + PAGE_SIZE - sizeof(VarCharKeyLength), sizeof(VarCharKeyLength));
+    prefix = (const unsigned char*)page + PAGE_SIZE - sizeof(VarCharKeyLength) - prefixLength;
+    return prefixLength;
+}
+
+//a key that differs from the leaf's prefix comes before or after every entry. Keys that start
+//with it are searched for without it
+unsigned IndexManager::searchLeaf(const KeySearch &keySearch, const void *page, const void *key, bool upper){
+    const unsigned char *prefix;
+    unsigned prefixLength = getLeafPrefix(page, prefix);
+    if(prefixLength == 0){
+        return upper ? keySearch.upperBound(page, key) : keySearch.lowerBound(page, key);
+    }
+    NodeHeader nodeHeader;
+    memcpy(&nodeHeader, page, sizeof(NodeHeader));
+    VarCharKeyLength keyLength;
+    memcpy(&keyLength, key, sizeof(VarCharKeyLength));
+    const char *keyBytes = (const char*)key + sizeof(VarCharKeyLength);
+    int result = memcmp(prefix, keyBytes, min<unsigned>(prefixLength, keyLength));
+    if(result != 0){
+        return result < 0 ? nodeHeader.entryNumber : 0;
+    }
+    if(keyLength <= prefixLength){
+        //a composite key over fewer fields that every entry starts with
+        return upper ? nodeHeader.entryNumber : 0;
+    }
+    char suffix[IX_MAX_KEY_SIZE];
+    VarCharKeyLength suffixLength = keyLength - prefixLength;
+    memcpy(suffix, &suffixLength, sizeof(VarCharKeyLength));
+    memcpy(suffix + sizeof(VarCharKeyLength), keyBytes + prefixLength, suffixLength);
+    return upper ? keySearch.upperBound(page, suffix) : keySearch.lowerBound(page, suffix);
+}
+
+int IndexManager::compareLeafKey(const KeySearch &keySearch, const void *page, unsigned entryNum, const void *key){
+    const char *entry = getEntry(page, entryNum);
+    const unsigned char *prefix;
+    unsigned prefixLength = getLeafPrefix(page, prefix);
+    if(prefixLength == 0){
+        return keySearch.compare(entry, key);
+    }
+    VarCharKeyLength keyLength, suffixLength;
+    memcpy(&keyLength, key, sizeof(VarCharKeyLength));
+    memcpy(&suffixLength, entry, sizeof(VarCharKeyLength));
+    const char *keyBytes = (const char*)key + sizeof(VarCharKeyLength);
+    int result = memcmp(prefix, keyBytes, min<unsigned>(prefixLength, keyLength));
+    if(result != 0 || keyLength <= prefixLength){
+        return result;
+    }
+    return memcmp(entry + sizeof(VarCharKeyLength), keyBytes + prefixLength, min<unsigned>(suffixLength, keyLength - prefixLength));
+}
+
+void IndexManager::getLeafKey(const KeySearch &keySearch, const void *page, unsigned entryNum, void *nodeKey){
+    const char *entry = getEntry(page, entryNum);
+    const unsigned char *prefix;
+    unsigned prefixLength = getLeafPrefix(page, prefix);
+    if(prefixLength == 0){
+        memcpy(nodeKey, entry, keySearch.keySize(entry));
+        return;
+    }
+    VarCharKeyLength suffixLength;
+    memcpy(&suffixLength, entry, sizeof(VarCharKeyLength));
+    VarCharKeyLength keyLength = prefixLength + suffixLength;
+    memcpy(nodeKey, &keyLength, sizeof(VarCharKeyLength));
+    memcpy((char*)nodeKey + sizeof(VarCharKeyLength), prefix, prefixLength);
+    memcpy((char*)nodeKey + sizeof(VarCharKeyLength) + prefixLength, entry + sizeof(VarCharKeyLength), suffixLength);
+}
+
+//takes the leaf's prefix off the key of an entry in place
+bool IndexManager::toLeafEntry(const void *page, void *entry, unsigned &entrySize){
+    const unsigned char *prefix;
+    unsigned prefixLength = getLeafPrefix(page, prefix);
+    if(prefixLength == 0){
+        return true;
+    }
+    VarCharKeyLength keyLength;
+    memcpy(&keyLength, entry, sizeof(VarCharKeyLength));
+    char *keyBytes = (char*)entry + sizeof(VarCharKeyLength);
+    if(keyLength <= prefixLength || memcmp(keyBytes, prefix, prefixLength) != 0){
+        return false;
+    }
+    keyLength -= prefixLength;
+    memcpy(entry, &keyLength, sizeof(VarCharKeyLength));
+    entrySize -= prefixLength;
+    memmove(keyBytes, keyBytes + prefixLength, entrySize - sizeof(VarCharKeyLength));
+    return true;
+}
+
+//puts the leaf's prefix back on the key of an entry in place, returns the new entry size
+unsigned IndexManager::fromLeafEntry(const void *page, void *entry, unsigned entrySize){
+    const unsigned char *prefix;
+    unsigned prefixLength = getLeafPrefix(page, prefix);
+    if(prefixLength == 0){
+        return entrySize;
+    }
+    VarCharKeyLength keyLength;
+    memcpy(&keyLength, entry, sizeof(VarCharKeyLength));
+    keyLength += prefixLength;
+    memcpy(entry, &keyLength, sizeof(VarCharKeyLength));
+    char *keyBytes = (char*)entry + sizeof(VarCharKeyLength);
+    memmove(keyBytes + prefixLength, keyBytes, entrySize - sizeof(VarCharKeyLength));
+    memcpy(keyBytes, prefix, prefixLength);
+    return entrySize + prefixLength;
+}
+
+void IndexManager::getLeafEntries(const Attribute &attribute, const void *page, vector<string> &entries)const{
+    NodeHeader nodeHeader = getNodePageHeader(page);
+    char entry[PAGE_SIZE];
+    for(unsigned i = 0; i < nodeHeader.entryNumber; i++){
+        unsigned entrySize = getEntrySize(attribute, page, i);
+        memcpy(entry, getEntry(page, i), entrySize);
+        entrySize = fromLeafEntry(page, entry, entrySize);
+        entries.push_back(string(entry, entrySize));
+    }
+}
+
+//bytes two whole keys start with, none for 4-byte keys
+unsigned IndexManager::getCommonPrefix(const Attribute &attribute, const void *nodeKey, const void *otherKey)const{
+    if(!hasVarCharLayout(attribute.type)){
+        return 0;
+    }
+    VarCharKeyLength length, otherLength;
+    memcpy(&length, nodeKey, sizeof(VarCharKeyLength));
+    memcpy(&otherLength, otherKey, sizeof(VarCharKeyLength));
+    const char *bytes = (const char*)nodeKey + sizeof(VarCharKeyLength);
+    const char *otherBytes = (const char*)otherKey + sizeof(VarCharKeyLength);
+    unsigned common = 0;
+    while(common < length && common < otherLength && bytes[common] == otherBytes[common]){
+        common++;
+    }
+    return common;
+}
+
+//space below the header a leaf needs for entries of entriesSize bytes with whole keys, once
+//prefixLength bytes of every key are moved to the prefix
+unsigned IndexManager::getLeafSpace(unsigned entryNumber, unsigned entriesSize, unsigned prefixLength)const{
+    return entriesSize - entryNumber * prefixLength + entryNumber * sizeof(NodeSlot) + prefixLength + sizeof(VarCharKeyLength);
+}
+
+//entries are in key order, so the first and last have the prefix all of them share. A single
+//key keeps all of its bytes
+unsigned IndexManager::getLeafSpace(const Attribute &attribute, const vector<string> &entries, unsigned first, unsigned last)const{
+    unsigned entriesSize = 0;
+    for(unsigned i = first; i < last; i++){
+        entriesSize += entries[i].size();
+    }
+    unsigned prefixLength = last - first > 1 ? getCommonPrefix(attribute, entries[first].data(), entries[last - 1].data()) : 0;
+    return getLeafSpace(last - first, entriesSize, prefixLength);
+}
+
+//fills the leaf with entries [first, last), which have whole keys, under their longest common
+//prefix. The sibling links are kept
+void IndexManager::writeLeaf(const Attribute &attribute, void *page, const vector<string> &entries, unsigned first, unsigned last){
+    NodeHeader oldHeader = getNodePageHeader(page);
+    newIndexPage(page, IX_NO_PAGE);
+    VarCharKeyLength prefixLength = last - first > 1 ? getCommonPrefix(attribute, entries[first].data(), entries[last - 1].data()) : 0;
+    char *trailer = (char*)page + PAGE_SIZE - sizeof(VarCharKeyLength);
+    memcpy(trailer, &prefixLength, sizeof(VarCharKeyLength));
+    if(prefixLength > 0){
+        memcpy(trailer - prefixLength, entries[first].data() + sizeof(VarCharKeyLength), prefixLength);
+    }
+    NodeHeader nodeHeader = getNodePageHeader(page);
+    nodeHeader.freeSpaceOffset -= prefixLength;
+    nodeHeader.leftPageNum = oldHeader.leftPageNum;
+    nodeHeader.rightPageNum = oldHeader.rightPageNum;
+    setNodePageHeader(page, nodeHeader);
+
+    char entry[PAGE_SIZE];
+    for(unsigned i = first; i < last; i++){
+        unsigned entrySize = entries[i].size();
+        memcpy(entry, entries[i].data(), entrySize);
+        toLeafEntry(page, entry, entrySize);
+        appendEntry(page, entry, entrySize);
+    }
+}
+
+//where to divide the entries of an overfull leaf, which have whole keys, between two leaves:
+//the first entry of the right one. Each side gets its own prefix, so the one whose larger side
+//is smallest is taken among those where both sides fit. An append split passes the share of
+//the page the left leaf keeps as leftFill, 0 otherwise, and the left leaf is filled up to it
+unsigned IndexManager::splitLeafEntries(const Attribute &attribute, const vector<string> &entries, float leftFill)const{
+    unsigned entryNumber = entries.size();
+    //the prefix of a run of sorted keys is the shortest one between neighbours in it
+    vector<unsigned> sizes(entryNumber + 1, 0);
+    vector<unsigned> leftPrefix(entryNumber + 1, 0);
+    vector<unsigned> rightPrefix(entryNumber + 1, 0);
+    for(unsigned i = 0; i < entryNumber; i++){
+        sizes[i + 1] = sizes[i] + entries[i].size();
+    }
+    for(unsigned i = 2; i <= entryNumber; i++){
+        unsigned common = getCommonPrefix(attribute, entries[i - 2].data(), entries[i - 1].data());
+        leftPrefix[i] = i == 2 ? common : min(leftPrefix[i - 1], common);
+    }
+    for(int i = (int) entryNumber - 2; i >= 0; i--){
+        unsigned common = getCommonPrefix(attribute, entries[i].data(), entries[i + 1].data());
+        rightPrefix[i] = i == (int) entryNumber - 2 ? common : min(rightPrefix[i + 1], common);
+    }
+
+    unsigned capacity = PAGE_SIZE - sizeof(NodeHeader);
+    unsigned best = entryNumber / 2;
+    unsigned bestSize = UINT_MAX;
+    unsigned fullest = 0;
+    for(unsigned i = 1; i < entryNumber; i++){
+        unsigned leftSpace = getLeafSpace(i, sizes[i], leftPrefix[i]);
+        unsigned rightSpace = getLeafSpace(entryNumber - i, sizes[entryNumber] - sizes[i], rightPrefix[i]);
+        if(leftSpace > capacity || rightSpace > capacity){
+            continue;
+        }
+        if(max(leftSpace, rightSpace) < bestSize){
+            best = i;
+            bestSize = max(leftSpace, rightSpace);
+        }
+        if(leftSpace <= leftFill * capacity){
+            fullest = i;
+        }
+    }
+    return fullest > 0 ? fullest : best;
+}
+
+//the shortest prefix of rightKey that is greater than leftKey, or rightKey itself for 4-byte keys
+unsigned IndexManager::getSeparator(const Attribute &attribute, const void *leftKey, const void *rightKey, void *separator)const{
+    if(!hasVarCharLayout(attribute.type)){
+        unsigned keySize = getKeySize(attribute, rightKey);
+        memcpy(separator, rightKey, keySize);
+        return keySize;
+    }
+    VarCharKeyLength length = getCommonPrefix(attribute, leftKey, rightKey) + 1;
+    memcpy(separator, &length, sizeof(VarCharKeyLength));
+    memcpy((char*)separator + sizeof(VarCharKeyLength), (const char*)rightKey + sizeof(VarCharKeyLength), length);
+    return sizeof(VarCharKeyLength) + length;
+}
+
+RC IndexManager::traverse(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, bool leftmost,
+        TraverseMode mode, PageNum &leafPageNum, void *&leafData, vector<NodePathEntry> &path, bool &rootLatched,
+        unsigned splitLevel){
+    bool shared = mode != IX_TRAVERSE_DELETE;     //the root latch is taken shared
+    const KeySearch &keySearch = getKeySearch(attribute.type);
+    path.clear();
+    if(shared){
+        pthread_rwlock_rdlock(&ixfileHandle.index->rootLatch);
+    }else{
+        pthread_rwlock_wrlock(&ixfileHandle.index->rootLatch);
+    }
+    //a split that may reach the root or the cached levels changes them under the root latch
+    unsigned height = ixfileHandle.index->metadata.height;
+    if(mode == IX_TRAVERSE_INSERT && (splitLevel >= height || splitLevel + IX_CACHED_LEVELS > height)){
+        pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+        pthread_rwlock_wrlock(&ixfileHandle.index->rootLatch);
+        shared = false;
+    }
+    rootLatched = true;
+    PageNum currentPage = ixfileHandle.index->metadata.rootPage;
+    unsigned level = height;     //the tree only grows and shrinks at the root
+    PageNum parentPage = IX_NO_PAGE;
+    while(true){
+        //a reader finds its way through the upper levels in the node cache, keeping the root
+        //latch until it has latched the first node below them
+        if(mode == IX_TRAVERSE_READ && level > 1 && level + IX_CACHED_LEVELS > ixfileHandle.index->metadata.height){
+            const void *nodeData;
+            RC rc = getCachedNode(ixfileHandle, currentPage, nodeData);
+            if(rc != SUCCESS){
+                pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+                rootLatched = false;
+                return rc;
+            }
+            currentPage = getChild(attribute, nodeData, key == NULL ? 0 : findPointerEntry(nodeData, keySearch, key, leftmost));
+            level--;
+            continue;
+        }
+        //work on the cached frame instead of a private copy
+        void* pageData;
+        bool exclusive = mode == IX_TRAVERSE_DELETE || (mode == IX_TRAVERSE_WRITE_LEAF && level <= 1) ||
+                (mode == IX_TRAVERSE_INSERT && level <= splitLevel);
+        RC rc = fetchNode(ixfileHandle, currentPage, pageData, exclusive);
+        //the child is latched, or failed, so a reader's parent can go. A shared path keeps the
+        //root where it is without the root latch
+        if(mode == IX_TRAVERSE_READ && parentPage != IX_NO_PAGE){
+            releaseNode(ixfileHandle, parentPage, false);
+        }
+        if(shared && rootLatched){
+            pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+            rootLatched = false;
+        }
+        if(rc != SUCCESS){
+            releasePath(ixfileHandle, path, rootLatched);
+            path.clear();
+            rootLatched = false;
+            return rc;
+        }
+        NodeHeader nodeHeader = getNodePageHeader(pageData);
+        if(nodeHeader.isLeaf()){
+            leafPageNum = currentPage;
+            leafData = pageData;
+            return SUCCESS;
+        }
+        //find correct child
+        NodePathEntry pathEntry;
+        pathEntry.pageNum = currentPage;
+        pathEntry.childIndex = key == NULL ? 0 : findPointerEntry(pageData, keySearch, key, leftmost);
+        if(mode != IX_TRAVERSE_READ){
+            path.push_back(pathEntry);
+        }
+        parentPage = currentPage;
+        currentPage = getChild(attribute, pageData, pathEntry.childIndex);
+        level--;
+    }
+}
+
+//pins a node and waits for its latch
+RC IndexManager::fetchNode(IXFileHandle &ixfileHandle, PageNum pageNum, void *&pageData, bool exclusive){
+    if(ixfileHandle.fileHandle.fetchPage(pageNum, pageData))
+        return IX_READ_FAILED;
+    ixfileHandle.fileHandle.latchPage(pageNum, exclusive);
+    return SUCCESS;
+}
+
+void IndexManager::releaseNode(IXFileHandle &ixfileHandle, PageNum pageNum, bool dirty){
+    ixfileHandle.fileHandle.unlatchPage(pageNum);
+    ixfileHandle.fileHandle.unpinPage(pageNum, dirty);
+}
+
+//finds an upper node in the node cache, copying it in from the buffer pool the first time.
+//The caller holds the root latch, so no split or merge changes the node meanwhile. The page is
+//copied without the cache latch, which is taken inside page latches when copies are dropped
+RC IndexManager::getCachedNode(IXFileHandle &ixfileHandle, PageNum pageNum, const void *&nodeData){
+    IndexFile *index = ixfileHandle.index;
+    {
+        lock_guard<mutex> guard(index->nodeCacheLatch);
+        map<PageNum, string>::iterator it = index->nodeCache.find(pageNum);
+        if(it != index->nodeCache.end()){
+            nodeData = it->second.data();
+            return SUCCESS;
+        }
+    }
+    void *pageData;
+    RC rc = fetchNode(ixfileHandle, pageNum, pageData, false);
+    if(rc != SUCCESS){
+        return rc;
+    }
+    string copy((const char*)pageData, PAGE_SIZE);
+    releaseNode(ixfileHandle, pageNum, false);
+    //another reader may have copied the node meanwhile, either copy will do
+    lock_guard<mutex> guard(index->nodeCacheLatch);
+    nodeData = index->nodeCache.insert(make_pair(pageNum, copy)).first->second.data();
+    return SUCCESS;
+}
+
+//called with the root latch held exclusively, before a node's keys or children change
+void IndexManager::dropCachedNode(IXFileHandle &ixfileHandle, PageNum pageNum){
+    lock_guard<mutex> guard(ixfileHandle.index->nodeCacheLatch);
+    ixfileHandle.index->nodeCache.erase(pageNum);
+}
+
+//called with the root latch held exclusively when the levels move, as the root changes
+void IndexManager::clearNodeCache(IXFileHandle &ixfileHandle){
+    lock_guard<mutex> guard(ixfileHandle.index->nodeCacheLatch);
+    ixfileHandle.index->nodeCache.clear();
+}
+
+//releases the nodes a writing traverse left latched, and the root latch if it is still held.
+//Changes to them were marked dirty when they were made
+void IndexManager::releasePath(IXFileHandle &ixfileHandle, const vector<NodePathEntry> &path, bool rootLatched){
+    for(unsigned i = 0; i < path.size(); i++){
+        releaseNode(ixfileHandle, path[i].pageNum, false);
+    }
+    if(rootLatched){
+        pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+    }
+}
+
+//level of the lowest node on path with room for another separator, which takes any split from
+//below without splitting itself, or the height of the tree if none has. The nodes of path are
+//latched, so none of them fills up meanwhile. IX_MAX_KEY_SIZE needs no padding
+unsigned IndexManager::getSplitLevel(IXFileHandle &ixfileHandle, const vector<NodePathEntry> &path){
+    unsigned level = 2;
+    for(int i = (int) path.size() - 1; i >= 0; i--, level++){
+        //the path is pinned, this only finds the frame
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(path[i].pageNum, pageData) != SUCCESS){
+            continue;
+        }
+        bool room = getNodeFreeSpace(pageData) >= IX_MAX_KEY_SIZE + sizeof(PageNum) + sizeof(SubtreeCount) + sizeof(NodeSlot);
+        ixfileHandle.fileHandle.unpinPage(path[i].pageNum, false);
+        if(room){
+            return level;
+        }
+    }
+    return path.size() + 1;
+}
+
+//entries under a node: the RIDs of a leaf, or the counts of an internal node's children
+SubtreeCount IndexManager::countNode(const Attribute &attribute, const void *page)const{
+    NodeHeader nodeHeader = getNodePageHeader(page);
+    SubtreeCount count = 0;
+    if(nodeHeader.isLeaf()){
+        for(unsigned i = 0; i < nodeHeader.entryNumber; i++){
+            count += getPostingSize(attribute, page, i);
+        }
+        return count;
+    }
+    for(unsigned i = 0; i <= nodeHeader.entryNumber; i++){
+        count += __atomic_load_n(getChildCount(attribute, page, i), __ATOMIC_RELAXED);
+    }
+    return count;
+}
+
+//adds delta to the count of the child followed from each node of path. Writers on other leaves
+//may be doing the same under their shared latches
+void IndexManager::addToPathCounts(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<NodePathEntry> &path,
+        int delta){
+    for(unsigned i = 0; i < path.size(); i++){
+        //the path is pinned, this only finds the frame
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(path[i].pageNum, pageData) != SUCCESS){
+            continue;
+        }
+        __atomic_fetch_add(getChildCount(attribute, pageData, path[i].childIndex), (SubtreeCount) delta, __ATOMIC_RELAXED);
+        ixfileHandle.fileHandle.unpinPage(path[i].pageNum, true);
+    }
+}
+
+//number of entries with keys less than nodeKey, or not greater if inclusive, or all of them if
+//nodeKey is NULL. The descent takes
+//the leftmost path to the key, adding up the counts of the children left of it and then the
+//posting lists before the key in the leaf
+RC IndexManager::countBelow(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, bool inclusive,
+        uint64_t &count){
+    //entries a key is a prefix of equal it, so the ones not greater come before its successor
+    char successor[PAGE_SIZE];
+    bool bounded = nodeKey != NULL && (!inclusive || getKeySuccessor(attribute, nodeKey, successor));
+    const void *bound = inclusive ? successor : nodeKey;
+    const KeySearch &keySearch = getKeySearch(attribute.type);
+
+    count = 0;
+    pthread_rwlock_rdlock(&ixfileHandle.index->rootLatch);
+    PageNum pageNum = ixfileHandle.index->metadata.rootPage;
+    void *pageData;
+    RC rc = fetchNode(ixfileHandle, pageNum, pageData, false);
+    pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+    if(rc != SUCCESS){
+        return rc;
+    }
+    while(true){
+        NodeHeader nodeHeader = getNodePageHeader(pageData);
+        if(!bounded){
+            count += countNode(attribute, pageData);
+            break;
+        }
+        if(nodeHeader.isLeaf()){
+            unsigned end = searchLeaf(keySearch, pageData, bound, false);
+            for(unsigned i = 0; i < end; i++){
+                count += getPostingSize(attribute, pageData, i);
+            }
+            break;
+        }
+        unsigned childIndex = findPointerEntry(pageData, keySearch, bound, true);
+        for(unsigned i = 0; i < childIndex; i++){
+            count += __atomic_load_n(getChildCount(attribute, pageData, i), __ATOMIC_RELAXED);
+        }
+        PageNum child = getChild(attribute, pageData, childIndex);
+        void *childData;
+        rc = fetchNode(ixfileHandle, child, childData, false);
+        releaseNode(ixfileHandle, pageNum, false);
+        if(rc != SUCCESS){
+            return rc;
+        }
+        pageNum = child;
+        pageData = childData;
+    }
+    releaseNode(ixfileHandle, pageNum, false);
+    return SUCCESS;
+}
+
+//the least byte string greater than every key nodeKey equals: its last byte below 0xFF goes up
+//by one and the bytes after it are dropped, or for a 4-byte key set to 0. False if every byte is 0xFF
+bool IndexManager::getKeySuccessor(const Attribute &attribute, const void *nodeKey, void *successor)const{
+    unsigned keySize = getKeySize(attribute, nodeKey);
+    memcpy(successor, nodeKey, keySize);
+    unsigned char *bytes = (unsigned char*)successor;
+    unsigned first = hasVarCharLayout(attribute.type) ? sizeof(VarCharKeyLength) : 0;
+    unsigned last = keySize;
+    while(last > first && bytes[last - 1] == 0xFF){
+        last--;
+    }
+    if(last == first){
+        return false;
+    }
+    bytes[last - 1]++;
+    if(first == 0){
+        memset(bytes + last, 0, keySize - last);
+        return true;
+    }
+    VarCharKeyLength length = last - first;
+    memcpy(successor, &length, sizeof(VarCharKeyLength));
+    return true;
+}
+
+//counts with the bounds in the node key format
+RC IndexManager::countNodeKeyRange(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *lowKey,
+        const void *highKey, bool lowKeyInclusive, bool highKeyInclusive, uint64_t &count){
+    if(isHashIndex(ixfileHandle)){
+        return IX_UNORDERED_INDEX;
+    }
+    if((lowKey != NULL && getKeySize(attribute, lowKey) > IX_MAX_KEY_SIZE) ||
+            (highKey != NULL && getKeySize(attribute, highKey) > IX_MAX_KEY_SIZE)){
+        return IX_KEY_TOO_LONG;
+    }
+    //everything up to the high bound, less everything before the low one
+    uint64_t below = 0;
+    uint64_t upTo;
+    RC rc = countBelow(ixfileHandle, attribute, highKey, highKey == NULL || highKeyInclusive, upTo);
+    if(rc == SUCCESS && lowKey != NULL){
+        rc = countBelow(ixfileHandle, attribute, lowKey, !lowKeyInclusive, below);
+    }
+    if(rc != SUCCESS){
+        return rc;
+    }
+    count = upTo > below ? upTo - below : 0;
+    return SUCCESS;
+}
+
+//internal entries are a multiple of 4 bytes long, and packed from an aligned end of the page
+unsigned IndexManager::getPaddedKeySize(const Attribute &attribute, const void *nodeKey)const{
+    return (getKeySize(attribute, nodeKey) + sizeof(SubtreeCount) - 1) / sizeof(SubtreeCount) * sizeof(SubtreeCount);
+}
+
+unsigned IndexManager::getInternalEntrySize(const Attribute &attribute, const void *nodeKey)const{
+    return getPaddedKeySize(attribute, nodeKey) + sizeof(PageNum) + sizeof(SubtreeCount);
+}
+
+unsigned IndexManager::makeInternalEntry(void *entry, const Attribute &attribute, const void *nodeKey, PageNum child,
+        SubtreeCount count)const{
+    unsigned keySize = getKeySize(attribute, nodeKey);
+    unsigned paddedSize = getPaddedKeySize(attribute, nodeKey);
+    memmove(entry, nodeKey, keySize);
+    memset((char*)entry + keySize, 0, paddedSize - keySize);
+    memcpy((char*)entry + paddedSize, &child, sizeof(PageNum));
+    memcpy((char*)entry + paddedSize + sizeof(PageNum), &count, sizeof(SubtreeCount));
+    return paddedSize + sizeof(PageNum) + sizeof(SubtreeCount);
+}
+
+void IndexManager::setEntryAtOffset(void* page, unsigned entryNum, const void *entry, unsigned entrySize){
+    NodeHeader nodeHeader = getNodePageHeader(page);
+    NodeSlot *slots = getSlots(page);
+    nodeHeader.freeSpaceOffset -= entrySize;
+    memcpy((char*)page + nodeHeader.freeSpaceOffset, entry, entrySize);
+    memmove(slots + entryNum + 1, slots + entryNum, (nodeHeader.entryNumber - entryNum) * sizeof(NodeSlot));
+    slots[entryNum] = nodeHeader.freeSpaceOffset;
     //update node page header
-    nodeHeader.indexEntryNumber++;
-    nodeHeader.endOfEntries+=sizeof(NodeEntry);
+    nodeHeader.entryNumber++;
+    setNodePageHeader(page, nodeHeader);
+}
+
+void IndexManager::appendEntry(void* page, const void *entry, unsigned entrySize){
+    setEntryAtOffset(page, getNodePageHeader(page).entryNumber, entry, entrySize);
+}
+
+//removes an entry and closes the gap it leaves in the entry area
+void IndexManager::removeEntryAt(void* page, const Attribute &attribute, unsigned entryNum){
+    NodeHeader nodeHeader = getNodePageHeader(page);
+    NodeSlot *slots = getSlots(page);
+    NodeSlot offset = slots[entryNum];
+    unsigned entrySize = getEntrySize(attribute, page, entryNum);
+    memmove((char*)page + nodeHeader.freeSpaceOffset + entrySize, (char*)page + nodeHeader.freeSpaceOffset,
+            offset - nodeHeader.freeSpaceOffset);
+    for(unsigned i = 0; i < nodeHeader.entryNumber; i++){
+        if(slots[i] < offset){
+            slots[i] += entrySize;
+        }
+    }
+    memmove(slots + entryNum, slots + entryNum + 1, (nodeHeader.entryNumber - entryNum - 1) * sizeof(NodeSlot));
+    nodeHeader.entryNumber--;
+    nodeHeader.freeSpaceOffset += entrySize;
     setNodePageHeader(page, nodeHeader);
 }
 
-void IndexManager::insertInParent(void* page, const Attribute &attribute, const void *key, const RID &rid, unsigned left, unsigned right){
-    //insert in sorted order
-    //find correct place
+unsigned IndexManager::getNodeUsedSpace(const void* page)const{
+    return PAGE_SIZE - sizeof(NodeHeader) - getNodeFreeSpace(page);
+}
+
+bool IndexManager::isUnderfull(const void* page)const{
+    return getNodeUsedSpace(page) * 2 < PAGE_SIZE - sizeof(NodeHeader);
+}
+
+RC IndexManager::allocateNode(IXFileHandle &ixfileHandle, const void *page, PageNum &pageNum){
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    if(ixfileHandle.index->metadata.freePageList != IX_NO_PAGE){
+        pageNum = ixfileHandle.index->metadata.freePageList;
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(pageNum, pageData))
+            return IX_READ_FAILED;
+        FreePageHeader freePageHeader;
+        memcpy(&freePageHeader, pageData, sizeof(FreePageHeader));
+        memcpy(pageData, page, PAGE_SIZE);
+        ixfileHandle.fileHandle.unpinPage(pageNum, true);
+        ixfileHandle.index->metadata.freePageList = freePageHeader.nextFreePage;
+        return writeMetadata(ixfileHandle);
+    }
+    pageNum = ixfileHandle.fileHandle.getNumberOfPages();
+    if(ixfileHandle.fileHandle.appendPage(page))
+        return IX_APPEND_FAILED;
+    return SUCCESS;
+}
+
+RC IndexManager::freeNode(IXFileHandle &ixfileHandle, PageNum pageNum){
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    void *pageData;
+    if(ixfileHandle.fileHandle.fetchPage(pageNum, pageData))
+        return IX_READ_FAILED;
+    memset(pageData, 0, PAGE_SIZE);
+    FreePageHeader freePageHeader;
+    freePageHeader.nextFreePage = ixfileHandle.index->metadata.freePageList;
+    memcpy(pageData, &freePageHeader, sizeof(FreePageHeader));
+    ixfileHandle.fileHandle.unpinPage(pageNum, true);
+    ixfileHandle.index->metadata.freePageList = pageNum;
+    return writeMetadata(ixfileHandle);
+}
+
+bool IndexManager::ridLess(const RID &a, const RID &b){
+    if(a.pageNum != b.pageNum){
+        return a.pageNum < b.pageNum;
+    }
+    return a.slotNum < b.slotNum;
+}
+
+//varints hold 7 bits per byte, low bits first, with the high bit set on all but the last byte
+unsigned IndexManager::writeVarint(char *out, uint32_t value)const{
+    unsigned length = 0;
+    while(value >= 0x80){
+        out[length++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (char)value;
+    return length;
+}
+
+uint32_t IndexManager::readVarint(const char *in, unsigned &offset)const{
+    uint32_t value = 0;
+    unsigned shift = 0;
+    while(in[offset] & 0x80){
+        value |= (uint32_t)(in[offset++] & 0x7F) << shift;
+        shift += 7;
+    }
+    value |= (uint32_t)(unsigned char)in[offset++] << shift;
+    return value;
+}
+
+unsigned IndexManager::encodeRid(const RID &rid, const RID &previous, char *out)const{
+    unsigned length = writeVarint(out, rid.pageNum - previous.pageNum);
+    unsigned slotNum = rid.pageNum == previous.pageNum ? rid.slotNum - previous.slotNum : rid.slotNum;
+    return length + writeVarint(out + length, slotNum);
+}
+
+unsigned IndexManager::encodedRidSize(const RID &rid, const RID &previous)const{
+    char buffer[IX_MAX_RID_SIZE];
+    return encodeRid(rid, previous, buffer);
+}
+
+unsigned IndexManager::encodedRidsSize(const RID *rids, unsigned ridNumber)const{
+    unsigned length = 0;
+    RID previous = {0, 0};
+    for(unsigned i = 0; i < ridNumber; i++){
+        length += encodedRidSize(rids[i], previous);
+        previous = rids[i];
+    }
+    return length;
+}
+
+unsigned IndexManager::encodeRids(const RID *rids, unsigned ridNumber, char *out)const{
+    unsigned length = 0;
+    RID previous = {0, 0};
+    for(unsigned i = 0; i < ridNumber; i++){
+        length += encodeRid(rids[i], previous, out + length);
+        previous = rids[i];
+    }
+    return length;
+}
+
+void IndexManager::decodeRids(const char *in, unsigned length, vector<RID> &rids)const{
+    RID rid = {0, 0};
+    unsigned offset = 0;
+    while(offset < length){
+        uint32_t pageDelta = readVarint(in, offset);
+        uint32_t slotNum = readVarint(in, offset);
+        if(pageDelta == 0){
+            rid.slotNum += slotNum;
+        }else{
+            rid.pageNum += pageDelta;
+            rid.slotNum = slotNum;
+        }
+        rids.push_back(rid);
+    }
+}
+
+//builds the leaf entry for a key and its sorted RIDs, moving them to posting pages if they
+//don't fit inline
+RC IndexManager::makePostingEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const vector<RID> &rids,
+        void *entry, unsigned &entrySize){
+    unsigned keySize = getKeySize(attribute, nodeKey);
+    memmove(entry, nodeKey, keySize);
+    char *posting = (char*)entry + keySize;
+    PostingHeader postingHeader;
+    if(encodedRidsSize(rids.data(), rids.size()) <= IX_POSTING_INLINE_SIZE){
+        postingHeader = encodeRids(rids.data(), rids.size(), posting + sizeof(PostingHeader));
+        memcpy(posting, &postingHeader, sizeof(PostingHeader));
+        entrySize = keySize + sizeof(PostingHeader) + postingHeader;
+        return SUCCESS;
+    }
+
+    OverflowPosting overflow;
+    RC rc = writePostingPages(ixfileHandle, rids, overflow);
+    if(rc != SUCCESS)
+        return rc;
+    postingHeader = IX_POSTING_OVERFLOW;
+    memcpy(posting, &postingHeader, sizeof(PostingHeader));
+    memcpy(posting + sizeof(PostingHeader), &overflow, sizeof(OverflowPosting));
+    entrySize = keySize + sizeof(PostingHeader) + sizeof(OverflowPosting);
+    return SUCCESS;
+}
+
+//fills posting pages with rids in order, linking each page to the next once that is allocated
+RC IndexManager::writePostingPages(IXFileHandle &ixfileHandle, const vector<RID> &rids, OverflowPosting &overflow){
+    char page[PAGE_SIZE];
+    unsigned capacity = PAGE_SIZE - sizeof(PostingPageHeader);
+    overflow.ridNumber = rids.size();
+    overflow.firstPage = IX_NO_PAGE;
+    overflow.lastPage = IX_NO_PAGE;
+    unsigned start = 0;
+    while(start < rids.size()){
+        unsigned end = start;
+        unsigned length = 0;
+        RID previous = {0, 0};
+        while(end < rids.size() && length + encodedRidSize(rids[end], previous) <= capacity){
+            length += encodedRidSize(rids[end], previous);
+            previous = rids[end];
+            end++;
+        }
+
+        memset(page, 0, PAGE_SIZE);
+        PostingPageHeader header;
+        header.nextPage = IX_NO_PAGE;
+        header.ridNumber = end - start;
+        header.length = encodeRids(&rids[start], end - start, page + sizeof(PostingPageHeader));
+        header.lastRid = rids[end - 1];
+        memcpy(page, &header, sizeof(PostingPageHeader));
+        PageNum pageNum;
+        RC rc = allocateNode(ixfileHandle, page, pageNum);
+        if(rc != SUCCESS)
+            return rc;
+
+        if(overflow.lastPage == IX_NO_PAGE){
+            overflow.firstPage = pageNum;
+        }else{
+            void *previousData;
+            if(ixfileHandle.fileHandle.fetchPage(overflow.lastPage, previousData))
+                return IX_READ_FAILED;
+            memcpy(&header, previousData, sizeof(PostingPageHeader));
+            header.nextPage = pageNum;
+            memcpy(previousData, &header, sizeof(PostingPageHeader));
+            ixfileHandle.fileHandle.unpinPage(overflow.lastPage, true);
+        }
+        overflow.lastPage = pageNum;
+        start = end;
+    }
+    return SUCCESS;
+}
+
+//copies the RIDs of entry entryNum that come after *after, or all of them if after is NULL. An
+//overflowed list is read a posting page at a time: only the RIDs from the first page that has
+//any are copied, and complete is set if they are the last ones
+RC IndexManager::readPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+        const RID *after, vector<RID> &rids, bool &complete)const{
+    const char *entry = getEntry(page, entryNum);
+    const char *posting = entry + getKeySize(attribute, entry);
+    PostingHeader postingHeader;
+    memcpy(&postingHeader, posting, sizeof(PostingHeader));
+    if(postingHeader != IX_POSTING_OVERFLOW){
+        decodeRids(posting + sizeof(PostingHeader), postingHeader, rids);
+        if(after != NULL)
+            rids.erase(rids.begin(), upper_bound(rids.begin(), rids.end(), *after, ridLess));
+        complete = true;
+        return SUCCESS;
+    }
+
+    OverflowPosting overflow;
+    memcpy(&overflow, posting + sizeof(PostingHeader), sizeof(OverflowPosting));
+    PageNum postingPage = overflow.firstPage;
+    while(postingPage != IX_NO_PAGE && rids.empty()){
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(postingPage, pageData))
+            return IX_READ_FAILED;
+        PostingPageHeader header;
+        memcpy(&header, pageData, sizeof(PostingPageHeader));
+        if(after == NULL || ridLess(*after, header.lastRid)){
+            decodeRids((const char*)pageData + sizeof(PostingPageHeader), header.length, rids);
+            if(after != NULL)
+                rids.erase(rids.begin(), upper_bound(rids.begin(), rids.end(), *after, ridLess));
+        }
+        ixfileHandle.fileHandle.unpinPage(postingPage, false);
+        postingPage = header.nextPage;
+    }
+    complete = postingPage == IX_NO_PAGE;
+    return SUCCESS;
+}
+
+//builds in entry the new version of entry entryNum with rid added. An inline list that grows
+//too long moves to posting pages; the posting pages of an overflowed one are updated here
+RC IndexManager::insertIntoPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+        const RID &rid, void *entry, unsigned &entrySize){
+    const char *oldEntry = getEntry(page, entryNum);
+    unsigned keySize = getKeySize(attribute, oldEntry);
+    PostingHeader postingHeader;
+    memcpy(&postingHeader, oldEntry + keySize, sizeof(PostingHeader));
+    if(postingHeader != IX_POSTING_OVERFLOW){
+        vector<RID> rids;
+        decodeRids(oldEntry + keySize + sizeof(PostingHeader), postingHeader, rids);
+        rids.insert(upper_bound(rids.begin(), rids.end(), rid, ridLess), rid);
+        return makePostingEntry(ixfileHandle, attribute, oldEntry, rids, entry, entrySize);
+    }
+
+    OverflowPosting overflow;
+    memcpy(&overflow, oldEntry + keySize + sizeof(PostingHeader), sizeof(OverflowPosting));
+    RC rc = insertIntoPostingPages(ixfileHandle, overflow, rid);
+    if(rc != SUCCESS)
+        return rc;
+    entrySize = keySize + sizeof(PostingHeader) + sizeof(OverflowPosting);
+    memcpy(entry, oldEntry, entrySize);
+    memcpy((char*)entry + keySize + sizeof(PostingHeader), &overflow, sizeof(OverflowPosting));
+    return SUCCESS;
+}
+
+//adds rid to the first posting page whose RIDs reach it, or to the last page, splitting the page
+//if it is full. RIDs usually grow with the table, so the last page is tried first and appends
+//don't decode it
+RC IndexManager::insertIntoPostingPages(IXFileHandle &ixfileHandle, OverflowPosting &overflow, const RID &rid){
+    PageNum postingPage = overflow.lastPage;
+    void *pageData;
+    PostingPageHeader header;
+    if(ixfileHandle.fileHandle.fetchPage(postingPage, pageData))
+        return IX_READ_FAILED;
+    memcpy(&header, pageData, sizeof(PostingPageHeader));
+    if(ridLess(rid, header.lastRid) && postingPage != overflow.firstPage){
+        ixfileHandle.fileHandle.unpinPage(postingPage, false);
+        postingPage = overflow.firstPage;
+        while(true){
+            if(ixfileHandle.fileHandle.fetchPage(postingPage, pageData))
+                return IX_READ_FAILED;
+            memcpy(&header, pageData, sizeof(PostingPageHeader));
+            if(!ridLess(header.lastRid, rid) || header.nextPage == IX_NO_PAGE)
+                break;
+            ixfileHandle.fileHandle.unpinPage(postingPage, false);
+            postingPage = header.nextPage;
+        }
+    }
+
+    char *encoded = (char*)pageData + sizeof(PostingPageHeader);
+    unsigned capacity = PAGE_SIZE - sizeof(PostingPageHeader);
+    bool append = !ridLess(rid, header.lastRid);
+    if(append && header.length + encodedRidSize(rid, header.lastRid) <= capacity){
+        header.length += encodeRid(rid, header.lastRid, encoded + header.length);
+        header.ridNumber++;
+        header.lastRid = rid;
+        memcpy(pageData, &header, sizeof(PostingPageHeader));
+        ixfileHandle.fileHandle.unpinPage(postingPage, true);
+        overflow.ridNumber++;
+        return SUCCESS;
+    }
+
+    //RIDs that move to a new page after this one. An append to a full page starts the new page
+    //by itself, so pages filled by appends stay full
+    vector<RID> rids;
+    vector<RID> moved;
+    if(append){
+        moved.push_back(rid);
+    }else{
+        decodeRids(encoded, header.length, rids);
+        rids.insert(upper_bound(rids.begin(), rids.end(), rid, ridLess), rid);
+        if(encodedRidsSize(rids.data(), rids.size()) > capacity){
+            moved.assign(rids.begin() + rids.size() / 2, rids.end());
+            rids.resize(rids.size() / 2);
+        }
+    }
+
+    if(!moved.empty()){
+        char newPage[PAGE_SIZE];
+        memset(newPage, 0, PAGE_SIZE);
+        PostingPageHeader newHeader;
+        newHeader.nextPage = header.nextPage;
+        newHeader.ridNumber = moved.size();
+        newHeader.length = encodeRids(moved.data(), moved.size(), newPage + sizeof(PostingPageHeader));
+        newHeader.lastRid = moved.back();
+        memcpy(newPage, &newHeader, sizeof(PostingPageHeader));
+        PageNum newPageNum;
+        RC rc = allocateNode(ixfileHandle, newPage, newPageNum);
+        if(rc != SUCCESS){
+            ixfileHandle.fileHandle.unpinPage(postingPage, false);
+            return rc;
+        }
+        header.nextPage = newPageNum;
+        if(postingPage == overflow.lastPage){
+            overflow.lastPage = newPageNum;
+        }
+    }
+    if(!append){
+        header.ridNumber = rids.size();
+        header.length = encodeRids(rids.data(), rids.size(), encoded);
+        header.lastRid = rids.back();
+    }
+    memcpy(pageData, &header, sizeof(PostingPageHeader));
+    ixfileHandle.fileHandle.unpinPage(postingPage, true);
+    overflow.ridNumber++;
+    return SUCCESS;
+}
+
+//builds in entry the new version of entry entryNum without rid, or sets entrySize to 0 if rid
+//was its last one. An overflowed list that is down to one short page moves back inline if the
+//leaf has room for it
+RC IndexManager::removeFromPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+        const RID &rid, void *entry, unsigned &entrySize, bool &found){
+    const char *oldEntry = getEntry(page, entryNum);
+    unsigned keySize = getKeySize(attribute, oldEntry);
+    PostingHeader postingHeader;
+    memcpy(&postingHeader, oldEntry + keySize, sizeof(PostingHeader));
+    found = false;
+    entrySize = 0;
+    if(postingHeader != IX_POSTING_OVERFLOW){
+        vector<RID> rids;
+        decodeRids(oldEntry + keySize + sizeof(PostingHeader), postingHeader, rids);
+        vector<RID>::iterator position = lower_bound(rids.begin(), rids.end(), rid, ridLess);
+        if(position == rids.end() || ridLess(rid, *position))
+            return SUCCESS;
+        found = true;
+        rids.erase(position);
+        if(rids.empty())
+            return SUCCESS;
+        return makePostingEntry(ixfileHandle, attribute, oldEntry, rids, entry, entrySize);
+    }
+
+    OverflowPosting overflow;
+    memcpy(&overflow, oldEntry + keySize + sizeof(PostingHeader), sizeof(OverflowPosting));
+    RC rc = removeFromPostingPages(ixfileHandle, overflow, rid, found);
+    if(rc != SUCCESS || !found || overflow.ridNumber == 0)
+        return rc;
+
+    if(overflow.firstPage == overflow.lastPage){
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(overflow.firstPage, pageData))
+            return IX_READ_FAILED;
+        PostingPageHeader header;
+        memcpy(&header, pageData, sizeof(PostingPageHeader));
+        vector<RID> rids;
+        decodeRids((const char*)pageData + sizeof(PostingPageHeader), header.length, rids);
+        ixfileHandle.fileHandle.unpinPage(overflow.firstPage, false);
+        unsigned oldEntrySize = keySize + sizeof(PostingHeader) + sizeof(OverflowPosting);
+        if(header.length <= IX_POSTING_INLINE_SIZE &&
+                getNodeFreeSpace(page) + oldEntrySize >= keySize + sizeof(PostingHeader) + header.length){
+            rc = freeNode(ixfileHandle, overflow.firstPage);
+            if(rc != SUCCESS)
+                return rc;
+            return makePostingEntry(ixfileHandle, attribute, oldEntry, rids, entry, entrySize);
+        }
+    }
+    entrySize = keySize + sizeof(PostingHeader) + sizeof(OverflowPosting);
+    memcpy(entry, oldEntry, entrySize);
+    memcpy((char*)entry + keySize + sizeof(PostingHeader), &overflow, sizeof(OverflowPosting));
+    return SUCCESS;
+}
+
+//removes rid from its posting page, freeing the page if it was the last RID on it
+RC IndexManager::removeFromPostingPages(IXFileHandle &ixfileHandle, OverflowPosting &overflow, const RID &rid, bool &found){
+    PageNum previousPage = IX_NO_PAGE;
+    PageNum postingPage = overflow.firstPage;
+    void *pageData;
+    PostingPageHeader header;
+    vector<RID> rids;
+    vector<RID>::iterator position;
+    found = false;
+    while(postingPage != IX_NO_PAGE){
+        if(ixfileHandle.fileHandle.fetchPage(postingPage, pageData))
+            return IX_READ_FAILED;
+        memcpy(&header, pageData, sizeof(PostingPageHeader));
+        if(!ridLess(header.lastRid, rid)){
+            decodeRids((const char*)pageData + sizeof(PostingPageHeader), header.length, rids);
+            position = lower_bound(rids.begin(), rids.end(), rid, ridLess);
+            found = !ridLess(rid, *position);
+            break;
+        }
+        ixfileHandle.fileHandle.unpinPage(postingPage, false);
+        previousPage = postingPage;
+        postingPage = header.nextPage;
+    }
+    if(!found){
+        if(postingPage != IX_NO_PAGE)
+            ixfileHandle.fileHandle.unpinPage(postingPage, false);
+        return SUCCESS;
+    }
+
+    rids.erase(position);
+    overflow.ridNumber--;
+    if(!rids.empty()){
+        header.ridNumber = rids.size();
+        header.length = encodeRids(rids.data(), rids.size(), (char*)pageData + sizeof(PostingPageHeader));
+        header.lastRid = rids.back();
+        memcpy(pageData, &header, sizeof(PostingPageHeader));
+        ixfileHandle.fileHandle.unpinPage(postingPage, true);
+        return SUCCESS;
+    }
+
+    //unlink the empty page
+    ixfileHandle.fileHandle.unpinPage(postingPage, false);
+    if(previousPage == IX_NO_PAGE){
+        overflow.firstPage = header.nextPage;
+    }else{
+        void *previousData;
+        if(ixfileHandle.fileHandle.fetchPage(previousPage, previousData))
+            return IX_READ_FAILED;
+        PostingPageHeader previousHeader;
+        memcpy(&previousHeader, previousData, sizeof(PostingPageHeader));
+        previousHeader.nextPage = header.nextPage;
+        memcpy(previousData, &previousHeader, sizeof(PostingPageHeader));
+        ixfileHandle.fileHandle.unpinPage(previousPage, true);
+    }
+    if(overflow.lastPage == postingPage){
+        overflow.lastPage = previousPage;
+    }
+    return freeNode(ixfileHandle, postingPage);
+}
+
+//an inline list is counted from its varints, two per RID, each ending in a byte below 0x80
+unsigned IndexManager::getPostingSize(const Attribute &attribute, const void *page, unsigned entryNum)const{
+    const char *entry = getEntry(page, entryNum);
+    const char *posting = entry + getKeySize(attribute, entry);
+    PostingHeader postingHeader;
+    memcpy(&postingHeader, posting, sizeof(PostingHeader));
+    if(postingHeader == IX_POSTING_OVERFLOW){
+        OverflowPosting overflow;
+        memcpy(&overflow, posting + sizeof(PostingHeader), sizeof(OverflowPosting));
+        return overflow.ridNumber;
+    }
+    unsigned varints = 0;
+    for(unsigned i = 0; i < postingHeader; i++){
+        if(!(posting[sizeof(PostingHeader) + i] & 0x80)){
+            varints++;
+        }
+    }
+    return varints / 2;
+}
+
+//the RID ridNum places into the posting list of entry entryNum. Of an overflowed list only the
+//posting page that holds it is decoded
+RC IndexManager::readPostingRid(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+        unsigned ridNum, RID &rid)const{
+    const char *entry = getEntry(page, entryNum);
+    const char *posting = entry + getKeySize(attribute, entry);
+    PostingHeader postingHeader;
+    memcpy(&postingHeader, posting, sizeof(PostingHeader));
+    vector<RID> rids;
+    if(postingHeader != IX_POSTING_OVERFLOW){
+        decodeRids(posting + sizeof(PostingHeader), postingHeader, rids);
+        if(ridNum >= rids.size())
+            return IX_EOF;
+        rid = rids[ridNum];
+        return SUCCESS;
+    }
+
+    OverflowPosting overflow;
+    memcpy(&overflow, posting + sizeof(PostingHeader), sizeof(OverflowPosting));
+    PageNum postingPage = overflow.firstPage;
+    while(postingPage != IX_NO_PAGE){
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(postingPage, pageData))
+            return IX_READ_FAILED;
+        PostingPageHeader header;
+        memcpy(&header, pageData, sizeof(PostingPageHeader));
+        if(ridNum < header.ridNumber){
+            decodeRids((const char*)pageData + sizeof(PostingPageHeader), header.length, rids);
+            ixfileHandle.fileHandle.unpinPage(postingPage, false);
+            rid = rids[ridNum];
+            return SUCCESS;
+        }
+        ridNum -= header.ridNumber;
+        ixfileHandle.fileHandle.unpinPage(postingPage, false);
+        postingPage = header.nextPage;
+    }
+    return IX_EOF;
+}
+
+//whether an entry can be added to a node being filled to fillFactor. A node always takes one entry
+bool IndexManager::fitsInNode(const void* page, unsigned entrySize, float fillFactor)const{
     NodeHeader nodeHeader = getNodePageHeader(page);
-    unsigned entryNum = findPointerEntryInParent(page, attribute, key);
-    if(nodeHeader.indexEntryNumber!=0){
-        NodeEntry testEntry = getNodeEntry(page, entryNum);
-        if(compareInParent(attribute, testEntry, key)<=0) entryNum++;
-    }
-    unsigned offset = sizeof(NodeHeader) + entryNum * sizeof(NodeEntry);
-    //insert entry
-    NodeEntry entry;
-    entry.rid = rid;
-    if(attribute.type == TypeInt){
-        entry.key.intValue = *((int*)key);               
-    }else if(attribute.type == TypeReal){
-        entry.key.floatValue = *((float*)key);
-    }else{
-        int lengthOfVarChar = strlen((char*)key);
-        char varCharBuffer[lengthOfVarChar+1];
-        memcpy(varCharBuffer,(char*)key, lengthOfVarChar);
-        varCharBuffer[lengthOfVarChar]='\0';
-        entry.key.strValue = (char*)malloc(lengthOfVarChar + 1);
-        strcpy(entry.key.strValue, varCharBuffer);          
-    }
-    entry.leftChildPageNum = left;
-    entry.rightChildPageNum = right;
-    setEntryAtOffset(page, offset, entry);
-    //update node page header
-    nodeHeader.indexEntryNumber++;
-    nodeHeader.endOfEntries+=sizeof(NodeEntry);
+    unsigned freeSpace = getNodeFreeSpace(page);
+    if(freeSpace < entrySize + sizeof(NodeSlot)){
+        return false;
+    }
+    if(nodeHeader.entryNumber == 0){
+        return true;
+    }
+    unsigned capacity = PAGE_SIZE - sizeof(NodeHeader);
+    unsigned used = capacity - freeSpace;
+    return used + entrySize + sizeof(NodeSlot) <= fillFactor * capacity;
+}
+
+//orders entries by (key, RID), as indexes into keyOffsets and rids
+void IndexManager::sortEntries(const Attribute &attribute, const vector<char> &nodeKeys, const vector<unsigned> &keyOffsets,
+        const vector<RID> &rids, vector<unsigned> &order)const{
+    const KeySearch &keySearch = getKeySearch(attribute.type);
+    auto less = [&](unsigned a, unsigned b) {
+        int result = keySearch.compare(&nodeKeys[keyOffsets[a]], &nodeKeys[keyOffsets[b]]);
+        if (result != 0)
+            return result < 0;
+        return ridLess(rids[a], rids[b]);
+    };
+    order.resize(rids.size());
+    for (unsigned i = 0; i < order.size(); i++)
+        order[i] = i;
+    if (!is_sorted(order.begin(), order.end(), less))
+        sort(order.begin(), order.end(), less);
+}
+
+//builds a tree over sorted entries with firstLeaf as its leftmost leaf. The RIDs of each key
+//make one posting list. Leaves are packed left to right, then each internal level is built in
+//one pass over the level below. The caller points the metadata at rootPage
+RC IndexManager::buildTree(IXFileHandle &ixfileHandle, const Attribute &attribute, PageNum firstLeaf, const vector<char> &nodeKeys,
+        const vector<unsigned> &keyOffsets, const vector<RID> &rids, const vector<unsigned> &order, float fillFactor,
+        PageNum &rootPage, uint32_t &height, uint32_t &leafNumber){
+    void *pageData = malloc(PAGE_SIZE);
+    if(pageData == NULL)
+        return IX_MALLOC_FAILED;
+    newIndexPage(pageData, IX_NO_PAGE);
+
+    //a leaf's entries are collected with whole keys, the prefix they share growing shorter
+    //with each one, until the next would overfill it
+    vector<PageNum> children;
+    vector<SubtreeCount> counts;
+    vector<string> separators(1);
+    vector<string> leafEntries;
+    unsigned entriesSize = 0;
+    SubtreeCount leafCount = 0;
+    vector<RID> keyRids;
+    char entry[PAGE_SIZE];
+    char separator[PAGE_SIZE];
+    unsigned capacity = PAGE_SIZE - sizeof(NodeHeader);
+    RC rc = SUCCESS;
+    for(unsigned i = 0; i < order.size() && rc == SUCCESS;){
+        const char *nodeKey = &nodeKeys[keyOffsets[order[i]]];
+        keyRids.clear();
+        for(; i < order.size() && compare(attribute, &nodeKeys[keyOffsets[order[i]]], nodeKey) == 0; i++){
+            keyRids.push_back(rids[order[i]]);
+        }
+        unsigned entrySize;
+        rc = makePostingEntry(ixfileHandle, attribute, nodeKey, keyRids, entry, entrySize);
+        if(rc != SUCCESS)
+            break;
+        if(!leafEntries.empty()){
+            unsigned prefixLength = getCommonPrefix(attribute, leafEntries[0].data(), nodeKey);
+            if(getLeafSpace(leafEntries.size() + 1, entriesSize + entrySize, prefixLength) > fillFactor * capacity){
+                //the leaf is full, this key starts the next one
+                writeLeaf(attribute, pageData, leafEntries, 0, leafEntries.size());
+                rc = writeBuiltLeaf(ixfileHandle, pageData, firstLeaf, children);
+                counts.push_back(leafCount);
+                leafCount = 0;
+                newIndexPage(pageData, IX_NO_PAGE);
+                unsigned separatorSize = getSeparator(attribute, leafEntries.back().data(), nodeKey, separator);
+                separators.push_back(string(separator, separatorSize));
+                leafEntries.clear();
+                entriesSize = 0;
+            }
+        }
+        leafEntries.push_back(string(entry, entrySize));
+        entriesSize += entrySize;
+        leafCount += keyRids.size();
+    }
+    if(rc == SUCCESS){
+        writeLeaf(attribute, pageData, leafEntries, 0, leafEntries.size());
+        rc = writeBuiltLeaf(ixfileHandle, pageData, firstLeaf, children);
+        counts.push_back(leafCount);
+    }
+    free(pageData);
+    leafNumber = children.size();
+
+    height = 1;
+    while(rc == SUCCESS && children.size() > 1){
+        rc = buildInternalLevel(ixfileHandle, attribute, fillFactor, children, counts, separators);
+        height++;
+    }
+    if(rc == SUCCESS)
+        rootPage = children[0];
+    return rc;
+}
+
+//writes a leaf made by buildTree, the first one to firstLeaf, and links the leaf before it to it
+RC IndexManager::writeBuiltLeaf(IXFileHandle &ixfileHandle, void *page, PageNum firstLeaf, vector<PageNum> &leaves){
+    if(leaves.empty()){
+        if(ixfileHandle.fileHandle.writePage(firstLeaf, page))
+            return IX_WRITE_FAILED;
+        leaves.push_back(firstLeaf);
+        return SUCCESS;
+    }
+    NodeHeader nodeHeader = getNodePageHeader(page);
+    nodeHeader.leftPageNum = leaves.back();
     setNodePageHeader(page, nodeHeader);
+    PageNum pageNum;
+    RC rc = allocateNode(ixfileHandle, page, pageNum);
+    if(rc != SUCCESS)
+        return rc;
+
+    void *previousData;
+    if(ixfileHandle.fileHandle.fetchPage(leaves.back(), previousData))
+        return IX_READ_FAILED;
+    NodeHeader previousHeader = getNodePageHeader(previousData);
+    previousHeader.rightPageNum = pageNum;
+    setNodePageHeader(previousData, previousHeader);
+    ixfileHandle.fileHandle.unpinPage(leaves.back(), true);
+    leaves.push_back(pageNum);
+    return SUCCESS;
+}
+
+//builds the level above children, where separators[i] is the lowest key under children[i] and
+//counts[i] the number of entries. The nodes are assembled in memory so the last one can borrow
+//an entry if it would have none, then appended; children, counts and separators are replaced by
+//the new level
+RC IndexManager::buildInternalLevel(IXFileHandle &ixfileHandle, const Attribute &attribute, float fillFactor,
+        vector<PageNum> &children, vector<SubtreeCount> &counts, vector<string> &separators){
+    vector<char*> nodes;
+    vector<string> nextSeparators;
+    char entry[PAGE_SIZE];
+    for(unsigned i = 0; i < children.size(); i++){
+        PageNum child = children[i];
+        unsigned entrySize = 0;
+        if(i > 0){
+            entrySize = makeInternalEntry(entry, attribute, separators[i].data(), child, counts[i]);
+            if(fitsInNode(nodes.back(), entrySize, fillFactor)){
+                appendEntry(nodes.back(), entry, entrySize);
+                continue;
+            }
+        }
+        //start a new node with this child on its left
+        char *node = (char*)malloc(PAGE_SIZE);
+        if(node == NULL){
+            for(unsigned j = 0; j < nodes.size(); j++)
+                free(nodes[j]);
+            return IX_MALLOC_FAILED;
+        }
+        newIndexPage(node, child);
+        *getChildCount(attribute, node, 0) = counts[i];
+        nodes.push_back(node);
+        nextSeparators.push_back(separators[i]);
+    }
+
+    //a last node with only a left child takes the last entry of the one before it
+    if(nodes.size() > 1 && getNodePageHeader(nodes.back()).entryNumber == 0){
+        char *previous = nodes[nodes.size() - 2];
+        NodeHeader previousHeader = getNodePageHeader(previous);
+        unsigned lastEntry = previousHeader.entryNumber - 1;
+        const char *borrowed = getEntry(previous, lastEntry);
+        unsigned borrowedSize = getEntrySize(attribute, previous, lastEntry);
+        unsigned keySize = getKeySize(attribute, borrowed);
+
+        NodeHeader nodeHeader = getNodePageHeader(nodes.back());
+        PageNum oldLeftChild = nodeHeader.leftChild;
+        SubtreeCount *leftCount = getChildCount(attribute, nodes.back(), 0);
+        SubtreeCount oldLeftCount = *leftCount;
+        nodeHeader.leftChild = getChild(attribute, previous, lastEntry + 1);
+        *leftCount = *getChildCount(attribute, previous, lastEntry + 1);
+        setNodePageHeader(nodes.back(), nodeHeader);
+        unsigned entrySize = makeInternalEntry(entry, attribute, nextSeparators.back().data(), oldLeftChild, oldLeftCount);
+        appendEntry(nodes.back(), entry, entrySize);
+        nextSeparators.back() = string(borrowed, keySize);
+
+        //entries were appended in order, so the last one is at the start of the entry area
+        previousHeader.entryNumber--;
+        previousHeader.freeSpaceOffset += borrowedSize;
+        setNodePageHeader(previous, previousHeader);
+    }
+
+    RC rc = SUCCESS;
+    vector<PageNum> nextChildren;
+    vector<SubtreeCount> nextCounts;
+    for(unsigned i = 0; i < nodes.size(); i++){
+        PageNum pageNum;
+        if(rc == SUCCESS)
+            rc = allocateNode(ixfileHandle, nodes[i], pageNum);
+        nextChildren.push_back(pageNum);
+        nextCounts.push_back(countNode(attribute, nodes[i]));
+        free(nodes[i]);
+    }
+    children.swap(nextChildren);
+    counts.swap(nextCounts);
+    separators.swap(nextSeparators);
+    return rc;
 }
 
-unsigned IndexManager::splitPage(IXFileHandle &ixfileHandle, void* page, unsigned currentPageNum, unsigned parent, const Attribute &attribute, const void *key, const RID &rid){
+//splits the full node in page, which is pinned by the caller, while inserting entry as entry
+//entryNum. The entries are divided by size; a leaf pushes the shortest separator between its
+//halves into the parent, an internal node moves its middle key up. A leaf entry comes with its
+//whole key, and a leaf that only had to shorten its prefix for it is rebuilt without a split
+//if everything still fits. For an internal node, appending tells whether the child below was
+//split as an append; leaves work it out here
+RC IndexManager::splitPage(IXFileHandle &ixfileHandle, const Attribute &attribute, void* page, PageNum pageNum,
+        vector<NodePathEntry> &path, unsigned entryNum, const void *entry, unsigned entrySize, bool appending){
     NodeHeader nodeHeader = getNodePageHeader(page);
-    //get mid of old page
-    unsigned mid = floor((double) nodeHeader.indexEntryNumber / 2);
-    unsigned midOffset = sizeof(NodeHeader) + mid * sizeof(NodeEntry);
-    NodeEntry midEntry = getNodeEntry(page, mid);
-    //make new page
-    void * newPageData = calloc(PAGE_SIZE, 1);
-    if (newPageData == NULL)
-        return IX_MALLOC_FAILED;
-    newIndexPage(newPageData);
-
-    //redistribute entries
-    NodeHeader newNodeHeader = getNodePageHeader(newPageData);
-    if(nodeHeader.isLeaf == true){
-        newNodeHeader.isLeaf = true;
-        memcpy((char*)newPageData+sizeof(NodeHeader), (char*)page+midOffset, nodeHeader.endOfEntries - midOffset);
-        newNodeHeader.endOfEntries = sizeof(NodeHeader) + (nodeHeader.endOfEntries-midOffset);
-        if(nodeHeader.indexEntryNumber%2==0){
-            newNodeHeader.indexEntryNumber = nodeHeader.indexEntryNumber - mid;
-        }else{ 
-            newNodeHeader.indexEntryNumber = nodeHeader.indexEntryNumber - mid +1;
+    if(!nodeHeader.isLeaf()){
+        dropCachedNode(ixfileHandle, pageNum);
+    }
+    unsigned leftEntries = 0;
+    if(nodeHeader.isLeaf()){
+        appending = (entryNum == nodeHeader.entryNumber && nodeHeader.rightPageNum == IX_NO_PAGE) ||
+                (entryNum > 0 && ixfileHandle.index->lastInsert == getInsertPosition(pageNum, entryNum - 1));
+    }else{
+        appending = appending && entryNum == nodeHeader.entryNumber;
+    }
+    float leftFill = appending ? getFillFactor(ixfileHandle) : 0;
+    char separator[PAGE_SIZE];
+    void *newPageData;
+    if(nodeHeader.isLeaf()){
+        vector<string> entries;
+        getLeafEntries(attribute, page, entries);
+        entries.insert(entries.begin() + entryNum, string((const char*)entry, entrySize));
+        if(getLeafSpace(attribute, entries, 0, entries.size()) <= PAGE_SIZE - sizeof(NodeHeader)){
+            writeLeaf(attribute, page, entries, 0, entries.size());
+            ixfileHandle.index->lastInsert = getInsertPosition(pageNum, entryNum);
+            return SUCCESS;
         }
+        newPageData = malloc(PAGE_SIZE);
+        if (newPageData == NULL)
+            return IX_MALLOC_FAILED;
+        unsigned mid = splitLeafEntries(attribute, entries, leftFill);
+        leftEntries = mid;
+        getSeparator(attribute, entries[mid - 1].data(), entries[mid].data(), separator);
+        writeLeaf(attribute, page, entries, 0, mid);
+        newIndexPage(newPageData, IX_NO_PAGE);
+        writeLeaf(attribute, newPageData, entries, mid, entries.size());
     }else{
-        memcpy((char*)newPageData+sizeof(NodeHeader), (char*)page+midOffset+sizeof(NodeEntry), nodeHeader.endOfEntries - midOffset - sizeof(NodeEntry));
-        newNodeHeader.endOfEntries = sizeof(NodeHeader) + (nodeHeader.endOfEntries-midOffset- sizeof(NodeEntry));
-        if(nodeHeader.indexEntryNumber %2 == 0) {
-            newNodeHeader.indexEntryNumber = nodeHeader.indexEntryNumber - mid-1;
-        }else {
-            newNodeHeader.indexEntryNumber = nodeHeader.indexEntryNumber - mid;
+        void *oldPageData = malloc(PAGE_SIZE);
+        newPageData = malloc(PAGE_SIZE);
+        if (oldPageData == NULL || newPageData == NULL)
+        {
+            free(oldPageData);
+            free(newPageData);
+            return IX_MALLOC_FAILED;
+        }
+        memcpy(oldPageData, page, PAGE_SIZE);
+
+        //the entries of the node with the new one in place
+        vector<const char*> entries;
+        vector<unsigned> sizes;
+        unsigned totalSize = 0;
+        for(unsigned i = 0; i <= nodeHeader.entryNumber; i++){
+            if(i == entryNum){
+                entries.push_back((const char*)entry);
+                sizes.push_back(entrySize);
+            }
+            if(i < nodeHeader.entryNumber){
+                entries.push_back(getEntry(oldPageData, i));
+                sizes.push_back(getEntrySize(attribute, oldPageData, i));
+            }
+        }
+        for(unsigned i = 0; i < entries.size(); i++){
+            totalSize += sizes[i] + sizeof(NodeSlot);
+        }
+
+        //get mid of old page, or fill the left node for an append as long as the rest fits right
+        unsigned capacity = PAGE_SIZE - sizeof(NodeHeader) - sizeof(SubtreeCount);
+        unsigned leftLimit = totalSize / 2;
+        if(appending){
+            leftLimit = max((unsigned) (leftFill * capacity), totalSize > capacity ? totalSize - capacity : 0);
+        }
+        unsigned mid = 0;
+        unsigned leftSize = 0;
+        while(mid < entries.size() - 1 && leftSize + sizes[mid] + sizeof(NodeSlot) <= leftLimit){
+            leftSize += sizes[mid] + sizeof(NodeSlot);
+            mid++;
+        }
+        if(mid == 0){
+            mid = 1;
+        }
+        if(mid == entries.size() - 1){
+            mid--;
         }
+
+        //the middle key moves up and its child becomes the new node's leftmost child
+        memcpy(separator, entries[mid], getKeySize(attribute, entries[mid]));
+        newIndexPage(page, nodeHeader.leftChild);
+        *getChildCount(attribute, page, 0) = *getChildCount(attribute, oldPageData, 0);
+        for(unsigned i = 0; i < mid; i++){
+            appendEntry(page, entries[i], sizes[i]);
+        }
+        unsigned childOffset = getPaddedKeySize(attribute, entries[mid]);
+        PageNum rightLeftChild;
+        memcpy(&rightLeftChild, entries[mid] + childOffset, sizeof(PageNum));
+        newIndexPage(newPageData, rightLeftChild);
+        memcpy(getChildCount(attribute, newPageData, 0), entries[mid] + childOffset + sizeof(PageNum), sizeof(SubtreeCount));
+        for(unsigned i = mid + 1; i < entries.size(); i++){
+            appendEntry(newPageData, entries[i], sizes[i]);
+        }
+        free(oldPageData);
     }
-    nodeHeader.endOfEntries = midOffset;
-    nodeHeader.indexEntryNumber = mid;
+
     //set them as chain if leaves
-    //if exists update the node to the right of the old header
-    unsigned newNodePageNum = ixfileHandle.fileHandle.getNumberOfPages();
-    if(nodeHeader.rightPageNum >-1 ){
-        void* rightPageData = malloc(PAGE_SIZE);
-        if (ixfileHandle.fileHandle.readPage(nodeHeader.rightPageNum, rightPageData))
+    PageNum newNodePageNum;
+    SubtreeCount leftCount = countNode(attribute, page);
+    SubtreeCount rightCount = countNode(attribute, newPageData);
+    if(nodeHeader.isLeaf()){
+        NodeHeader rightHeader = getNodePageHeader(newPageData);
+        rightHeader.leftPageNum = pageNum;
+        rightHeader.rightPageNum = nodeHeader.rightPageNum;
+        setNodePageHeader(newPageData, rightHeader);
+    }
+    RC rc = allocateNode(ixfileHandle, newPageData, newNodePageNum);
+    free(newPageData);
+    if(rc != SUCCESS)
+        return rc;
+    if(nodeHeader.isLeaf()){
+        {
+            lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+            ixfileHandle.index->metadata.leafNumber++;
+            ixfileHandle.index->metadataDirty = true;
+        }
+        ixfileHandle.index->lastInsert = entryNum < leftEntries ? getInsertPosition(pageNum, entryNum)
+                : getInsertPosition(newNodePageNum, entryNum - leftEntries);
+        //if exists update the node to the right of the old one
+        if(nodeHeader.rightPageNum != IX_NO_PAGE){
+            void *rightPageData;
+            if(fetchNode(ixfileHandle, nodeHeader.rightPageNum, rightPageData, true))
+                return IX_READ_FAILED;
+            NodeHeader rightHeader = getNodePageHeader(rightPageData);
+            rightHeader.leftPageNum = newNodePageNum;
+            setNodePageHeader(rightPageData, rightHeader);
+            releaseNode(ixfileHandle, nodeHeader.rightPageNum, true);
+        }
+        NodeHeader leftHeader = getNodePageHeader(page);
+        leftHeader.leftPageNum = nodeHeader.leftPageNum;
+        leftHeader.rightPageNum = newNodePageNum;
+        setNodePageHeader(page, leftHeader);
+    }
+
+    return insertInParent(ixfileHandle, attribute, path, separator, pageNum, leftCount, newNodePageNum, rightCount, appending);
+}
+
+//moves path and leafPageNum on to the next leaf, or returns IX_EOF after the last one. The
+//nodes on path are latched as traverse leaves them for IX_TRAVERSE_DELETE; the ones left
+//behind are released and their replacements latched, left to right
+RC IndexManager::nextLeafOnPath(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path, PageNum &leafPageNum){
+    //find the lowest node on the path with a child right of the one followed
+    int level = path.size() - 1;
+    PageNum child = IX_NO_PAGE;
+    for(; level >= 0; level--){
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(path[level].pageNum, pageData))
             return IX_READ_FAILED;
-        NodeHeader rightNodeHeader = getNodePageHeader(rightPageData);
-        rightNodeHeader.leftPageNum = newNodePageNum;
-        setNodePageHeader(rightPageData, rightNodeHeader);
-        if(ixfileHandle.fileHandle.writePage(nodeHeader.rightPageNum, rightPageData))
-            return IX_WRITE_FAILED;
-        free(rightPageData);
-    }
-    newNodeHeader.rightPageNum = nodeHeader.rightPageNum;
-    //set headers
-    nodeHeader.rightPageNum = newNodePageNum;
-    newNodeHeader.leftPageNum = currentPageNum;
-    //create new page if old node is root 
-    // if(nodeHeader.isRoot == true){
-    if(currentPageNum == getRootPageNum(ixfileHandle)){
-        nodeHeader.parent = newNodePageNum +1;
-        newNodeHeader.parent = newNodePageNum +1;
-        //make new page
-        void * newRootPage = malloc(PAGE_SIZE);
-        newIndexPage(newRootPage);
-        // nodeHeader.isRoot = false;
-        if(attribute.type == TypeVarChar){
-            insertInParent(newRootPage, attribute, midEntry.key.strValue, midEntry.rid, currentPageNum, newNodePageNum);
-        }else if(attribute.type == TypeReal){
-            insertInParent(newRootPage, attribute, &(midEntry.key.floatValue), midEntry.rid, currentPageNum, newNodePageNum);
-        }else{
-            insertInParent(newRootPage, attribute, &(midEntry.key.intValue), midEntry.rid, currentPageNum, newNodePageNum);
-        }
-        NodeHeader newRootHeader = getNodePageHeader(newRootPage);
-        // newRootHeader.isRoot = true;  
-        ixfileHandle.rootPage = newNodePageNum +1;
-        setNodePageHeader(newRootPage,newRootHeader);
-        setNodePageHeader(page, nodeHeader);
-        setNodePageHeader(newPageData, newNodeHeader);
-        int result = compare(attribute, midEntry, key);
-        if(nodeHeader.isLeaf==true){
-            if(result < 0){
-                insertInSortedOrder(newPageData,attribute,key,rid,-1,-1);
-            }else{
-                insertInSortedOrder(page,attribute,key,rid,-1,-1);
+        NodeHeader nodeHeader = getNodePageHeader(pageData);
+        bool hasNext = path[level].childIndex < nodeHeader.entryNumber;
+        if(hasNext){
+            path[level].childIndex++;
+            child = getChild(attribute, pageData, path[level].childIndex);
+        }
+        ixfileHandle.fileHandle.unpinPage(path[level].pageNum, false);
+        if(hasNext){
+            break;
+        }
+    }
+    if(level < 0){
+        return IX_EOF;
+    }
+
+    //then down the left edge of that child's subtree
+    for(unsigned i = level + 1; i < path.size(); i++){
+        releaseNode(ixfileHandle, path[i].pageNum, false);
+        void *pageData;
+        if(fetchNode(ixfileHandle, child, pageData, true)){
+            path.erase(path.begin() + i);
+            return IX_READ_FAILED;
+        }
+        path[i].pageNum = child;
+        path[i].childIndex = 0;
+        child = getNodePageHeader(pageData).leftChild;
+    }
+    leafPageNum = child;
+    return SUCCESS;
+}
+
+//second pass of a delete that left leafPageNum underfull. The path is latched exclusively from
+//the root down, so no other thread is inside the subtrees that rebalancing changes. The leaf
+//is found again among those that may hold key; it may have changed since the delete
+RC IndexManager::rebalanceLeaf(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, PageNum leafPageNum){
+    PageNum pageNum;
+    void *pageData;
+    vector<NodePathEntry> path;
+    bool rootLatched;
+    RC rc = traverse(ixfileHandle, attribute, nodeKey, false, IX_TRAVERSE_DELETE, pageNum, pageData, path, rootLatched);
+    if(rc != SUCCESS)
+        return rc;
+
+    while(pageNum != leafPageNum){
+        NodeHeader nodeHeader = getNodePageHeader(pageData);
+        bool more = nodeHeader.entryNumber == 0 ||
+                compareLeafKey(getKeySearch(attribute.type), pageData, nodeHeader.entryNumber - 1, nodeKey) <= 0;
+        releaseNode(ixfileHandle, pageNum, false);
+        rc = more ? nextLeafOnPath(ixfileHandle, attribute, path, pageNum) : IX_EOF;
+        if(rc == SUCCESS)
+            rc = fetchNode(ixfileHandle, pageNum, pageData, true);
+        if(rc != SUCCESS){
+            releasePath(ixfileHandle, path, rootLatched);
+            return rc == IX_EOF ? SUCCESS : rc;
+        }
+    }
+
+    //rebalance releases the nodes it takes off path
+    if(path.empty() || !isUnderfull(pageData) || deferRebalance(ixfileHandle, attribute, nodeKey, pageNum)){
+        releaseNode(ixfileHandle, pageNum, false);
+    }else{
+        rc = rebalance(ixfileHandle, attribute, path, pageNum);
+    }
+    releasePath(ixfileHandle, path, rootLatched);
+    return rc;
+}
+
+//while scans are open an underfull leaf is only noted, to be rebalanced when the last one ends.
+//Returns whether it was
+bool IndexManager::deferRebalance(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, PageNum leafPageNum){
+    IndexFile *index = ixfileHandle.index;
+    lock_guard<mutex> guard(index->scanLatch);
+    if(index->openScans == 0)
+        return false;
+    index->underfullAttribute = attribute;
+    index->underfullLeaves[leafPageNum] = string((const char*)nodeKey, getKeySize(attribute, nodeKey));
+    return true;
+}
+
+//called as a scan lets go of its leaf. The last one rebalances the leaves deletes left underfull
+//meanwhile, unless another scan has started by then. Each leaf is looked for again by its key,
+//and one that is no longer underfull is left alone
+void IndexManager::endScan(IXFileHandle &ixfileHandle){
+    IndexFile *index = ixfileHandle.index;
+    map<PageNum, string> leaves;
+    Attribute attribute;
+    {
+        lock_guard<mutex> guard(index->scanLatch);
+        if(--index->openScans > 0)
+            return;
+        leaves.swap(index->underfullLeaves);
+        attribute = index->underfullAttribute;
+    }
+    for(map<PageNum, string>::iterator it = leaves.begin(); it != leaves.end(); it++){
+        if(rebalanceLeaf(ixfileHandle, attribute, it->second.data(), it->first) != SUCCESS)
+            break;
+    }
+}
+
+//fixes the underfull node pageNum, the child followed from the last node of path. It is merged
+//with a sibling under the same parent if both fit in one page, which may leave the parent
+//underfull in turn; otherwise entries are moved over from the sibling. The node and path are
+//pinned and latched exclusively by the caller. The node and the nodes taken off path are
+//released here, the rest of path stays with the caller
+RC IndexManager::rebalance(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path, PageNum pageNum){
+    NodePathEntry parent = path.back();
+    path.pop_back();
+    //the caller's pins keep both frames in the pool, so these are only to find them
+    void *parentData, *nodeData;
+    if(ixfileHandle.fileHandle.fetchPage(parent.pageNum, parentData) == SUCCESS)
+        ixfileHandle.fileHandle.unpinPage(parent.pageNum, false);
+    if(ixfileHandle.fileHandle.fetchPage(pageNum, nodeData) == SUCCESS)
+        ixfileHandle.fileHandle.unpinPage(pageNum, false);
+    NodeHeader parentHeader = getNodePageHeader(parentData);
+    if(parentHeader.entryNumber == 0){
+        releaseNode(ixfileHandle, pageNum, false);
+        releaseNode(ixfileHandle, parent.pageNum, false);
+        return SUCCESS;
+    }
+
+    //pair the node with its left sibling, or its right one if it is the leftmost child.
+    //Siblings are latched left to right, so the node is let go while its left sibling is taken
+    unsigned separatorNum = parent.childIndex > 0 ? parent.childIndex - 1 : 0;
+    PageNum leftPageNum = getChild(attribute, parentData, separatorNum);
+    PageNum rightPageNum = getChild(attribute, parentData, separatorNum + 1);
+    void *leftData, *rightData;
+    RC rc;
+    if(pageNum == rightPageNum){
+        ixfileHandle.fileHandle.unlatchPage(pageNum);
+        rc = fetchNode(ixfileHandle, leftPageNum, leftData, true);
+        ixfileHandle.fileHandle.latchPage(pageNum, true);
+        rightData = nodeData;
+    }else{
+        leftData = nodeData;
+        rc = fetchNode(ixfileHandle, rightPageNum, rightData, true);
+    }
+    if(rc != SUCCESS){
+        releaseNode(ixfileHandle, pageNum, false);
+        releaseNode(ixfileHandle, parent.pageNum, false);
+        return rc;
+    }
+
+    //both siblings and the parent change, or the right sibling goes
+    dropCachedNode(ixfileHandle, parent.pageNum);
+    dropCachedNode(ixfileHandle, leftPageNum);
+    dropCachedNode(ixfileHandle, rightPageNum);
+
+    char separator[PAGE_SIZE];
+    const char *separatorEntry = getEntry(parentData, separatorNum);
+    memcpy(separator, separatorEntry, getKeySize(attribute, separatorEntry));
+    NodeHeader leftHeader = getNodePageHeader(leftData);
+    bool isLeaf = leftHeader.isLeaf();
+    unsigned combinedSize;
+    if(isLeaf){
+        //the merged leaf has the prefix both leaves share
+        vector<string> entries;
+        getLeafEntries(attribute, leftData, entries);
+        getLeafEntries(attribute, rightData, entries);
+        combinedSize = getLeafSpace(attribute, entries, 0, entries.size());
+    }else{
+        //the separator comes down between the two halves with right's leftmost child and count
+        combinedSize = getNodeUsedSpace(leftData) + getNodeUsedSpace(rightData) - sizeof(SubtreeCount) +
+                getInternalEntrySize(attribute, separator) + sizeof(NodeSlot);
+    }
+
+    if(combinedSize <= PAGE_SIZE - sizeof(NodeHeader)){
+        mergeNodes(attribute, leftData, rightData, separator);
+        *getChildCount(attribute, parentData, separatorNum) += *getChildCount(attribute, parentData, separatorNum + 1);
+        PageNum afterRight = getNodePageHeader(rightData).rightPageNum;
+        if(isLeaf){
+            if(afterRight != IX_NO_PAGE){
+                void *afterRightData;
+                if(fetchNode(ixfileHandle, afterRight, afterRightData, true) == SUCCESS){
+                    NodeHeader afterRightHeader = getNodePageHeader(afterRightData);
+                    afterRightHeader.leftPageNum = leftPageNum;
+                    setNodePageHeader(afterRightData, afterRightHeader);
+                    releaseNode(ixfileHandle, afterRight, true);
+                }
             }
+            lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+            ixfileHandle.index->metadata.leafNumber--;
+            ixfileHandle.index->metadataDirty = true;
         }
-        //write pages 
-        if(ixfileHandle.fileHandle.writePage(currentPageNum, page))
-            return IX_WRITE_FAILED;
-        if(ixfileHandle.fileHandle.appendPage(newPageData))
-            return IX_APPEND_FAILED;
-        if(ixfileHandle.fileHandle.appendPage(newRootPage)){
-            free(newRootPage);
-            return IX_APPEND_FAILED;
+        //nobody can reach the right node once its latch is let go
+        rc = freeNode(ixfileHandle, rightPageNum);
+        releaseNode(ixfileHandle, leftPageNum, true);
+        releaseNode(ixfileHandle, rightPageNum, false);
+
+        removeEntryAt(parentData, attribute, separatorNum);
+        parentHeader = getNodePageHeader(parentData);
+        if(rc == SUCCESS && path.empty() && parentHeader.entryNumber == 0){
+            //the root has a single child left, which becomes the root
+            clearNodeCache(ixfileHandle);
+            {
+                lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+                ixfileHandle.index->metadata.rootPage = leftPageNum;
+                ixfileHandle.index->metadata.height--;
+                rc = writeMetadata(ixfileHandle);
+            }
+            if(rc == SUCCESS)
+                rc = freeNode(ixfileHandle, parent.pageNum);
+            releaseNode(ixfileHandle, parent.pageNum, true);
+            return rc;
+        }
+        if(rc == SUCCESS && isUnderfull(parentData) && !path.empty())
+            return rebalance(ixfileHandle, attribute, path, parent.pageNum);
+        releaseNode(ixfileHandle, parent.pageNum, true);
+        return rc;
+    }
+
+    bool toLeft = pageNum == leftPageNum;
+    redistribute(attribute, leftData, rightData, toLeft, separator);
+    *getChildCount(attribute, parentData, separatorNum) = countNode(attribute, leftData);
+    *getChildCount(attribute, parentData, separatorNum + 1) = countNode(attribute, rightData);
+    releaseNode(ixfileHandle, leftPageNum, true);
+    releaseNode(ixfileHandle, rightPageNum, true);
+    //a split of the parent works on its own copy of the path, which stays latched
+    vector<NodePathEntry> ancestors = path;
+    rc = replaceSeparator(ixfileHandle, attribute, ancestors, parentData, parent.pageNum, separatorNum, separator);
+    releaseNode(ixfileHandle, parent.pageNum, true);
+    return rc;
+}
+
+//moves right's entries into left. For internal nodes the separator comes down with right's
+//leftmost child; leaves are rebuilt under the prefix they share
+void IndexManager::mergeNodes(const Attribute &attribute, void *left, void *right, const void *separator){
+    NodeHeader leftHeader = getNodePageHeader(left);
+    NodeHeader rightHeader = getNodePageHeader(right);
+    if(leftHeader.isLeaf()){
+        vector<string> entries;
+        getLeafEntries(attribute, left, entries);
+        getLeafEntries(attribute, right, entries);
+        writeLeaf(attribute, left, entries, 0, entries.size());
+        leftHeader = getNodePageHeader(left);
+        leftHeader.rightPageNum = rightHeader.rightPageNum;
+        setNodePageHeader(left, leftHeader);
+        return;
+    }
+    char entry[PAGE_SIZE];
+    unsigned entrySize = makeInternalEntry(entry, attribute, separator, rightHeader.leftChild,
+            *getChildCount(attribute, right, 0));
+    appendEntry(left, entry, entrySize);
+    for(unsigned i = 0; i < rightHeader.entryNumber; i++){
+        appendEntry(left, getEntry(right, i), getEntrySize(attribute, right, i));
+    }
+}
+
+//evens out two siblings, one of them underfull. Leaves are rebuilt from their entries, split
+//where a leaf split would; internal entries move one at a time towards the underfull side
+//until it would hold more than the other, rotating through the parent. separator is updated
+//in place
+void IndexManager::redistribute(const Attribute &attribute, void *left, void *right, bool toLeft, char *separator){
+    if(getNodePageHeader(left).isLeaf()){
+        vector<string> entries;
+        getLeafEntries(attribute, left, entries);
+        getLeafEntries(attribute, right, entries);
+        unsigned mid = splitLeafEntries(attribute, entries, 0);
+        getSeparator(attribute, entries[mid - 1].data(), entries[mid].data(), separator);
+        writeLeaf(attribute, left, entries, 0, mid);
+        writeLeaf(attribute, right, entries, mid, entries.size());
+        return;
+    }
+
+    void *receiver = toLeft ? left : right;
+    void *donor = toLeft ? right : left;
+    char entry[PAGE_SIZE];
+    while(isUnderfull(receiver) && getNodePageHeader(donor).entryNumber > 1){
+        unsigned donorNum = toLeft ? 0 : getNodePageHeader(donor).entryNumber - 1;
+        unsigned donorSize = getEntrySize(attribute, donor, donorNum) + sizeof(NodeSlot);
+        unsigned gain = getInternalEntrySize(attribute, separator) + sizeof(NodeSlot);
+        if(getNodeUsedSpace(receiver) + gain > getNodeUsedSpace(donor) - donorSize){
+            break;
         }
+
+        const char *donorEntry = getEntry(donor, donorNum);
+        unsigned donorKeySize = getKeySize(attribute, donorEntry);
+
+        NodeHeader receiverHeader = getNodePageHeader(receiver);
+        NodeHeader donorHeader = getNodePageHeader(donor);
+        PageNum donorChild = getChild(attribute, donor, donorNum + 1);
+        SubtreeCount donorCount = *getChildCount(attribute, donor, donorNum + 1);
+        char donorKey[PAGE_SIZE];
+        memcpy(donorKey, donorEntry, donorKeySize);
+        removeEntryAt(donor, attribute, donorNum);
+        //leftChild counts travel with their children
+        if(toLeft){
+            //separator and right's leftmost child move to the end of left
+            unsigned entrySize = makeInternalEntry(entry, attribute, separator, donorHeader.leftChild,
+                    *getChildCount(attribute, donor, 0));
+            appendEntry(receiver, entry, entrySize);
+            donorHeader = getNodePageHeader(donor);
+            donorHeader.leftChild = donorChild;
+            setNodePageHeader(donor, donorHeader);
+            *getChildCount(attribute, donor, 0) = donorCount;
+        }else{
+            //separator and right's leftmost child move to the front of right
+            unsigned entrySize = makeInternalEntry(entry, attribute, separator, receiverHeader.leftChild,
+                    *getChildCount(attribute, receiver, 0));
+            setEntryAtOffset(receiver, 0, entry, entrySize);
+            receiverHeader = getNodePageHeader(receiver);
+            receiverHeader.leftChild = donorChild;
+            setNodePageHeader(receiver, receiverHeader);
+            *getChildCount(attribute, receiver, 0) = donorCount;
+        }
+        memcpy(separator, donorKey, donorKeySize);
+    }
+}
+
+//sets the key of entry entryNum in the parent, which is pinned by the caller and reached
+//through path. A longer key may not fit, so that can split the parent
+RC IndexManager::replaceSeparator(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path,
+        void *parentPage, PageNum parentPageNum, unsigned entryNum, const void *nodeKey){
+    dropCachedNode(ixfileHandle, parentPageNum);
+    PageNum child = getChild(attribute, parentPage, entryNum + 1);
+    SubtreeCount count = *getChildCount(attribute, parentPage, entryNum + 1);
+    removeEntryAt(parentPage, attribute, entryNum);
+
+    char entry[PAGE_SIZE];
+    unsigned entrySize = makeInternalEntry(entry, attribute, nodeKey, child, count);
+    if(getNodeFreeSpace(parentPage) >= entrySize + sizeof(NodeSlot)){
+        setEntryAtOffset(parentPage, entryNum, entry, entrySize);
+        return SUCCESS;
+    }
+    return splitPage(ixfileHandle, attribute, parentPage, parentPageNum, path, entryNum, entry, entrySize, false);
+}
+
+//inserts the separator between left and its new right sibling into the last node of path,
+//or grows a new root if left was the root. The counts are those of the two nodes, which share
+//what the parent counted for left. appending tells whether left was split as an append
+RC IndexManager::insertInParent(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path,
+        const void *nodeKey, PageNum left, SubtreeCount leftCount, PageNum right, SubtreeCount rightCount, bool appending){
+    char entry[PAGE_SIZE];
+    unsigned entrySize = makeInternalEntry(entry, attribute, nodeKey, right, rightCount);
+
+    if(path.empty()){
+        void *newRootPage = malloc(PAGE_SIZE);
+        if (newRootPage == NULL)
+            return IX_MALLOC_FAILED;
+        newIndexPage(newRootPage, left);
+        *getChildCount(attribute, newRootPage, 0) = leftCount;
+        appendEntry(newRootPage, entry, entrySize);
+        PageNum newRootPageNum;
+        RC rc = allocateNode(ixfileHandle, newRootPage, newRootPageNum);
         free(newRootPage);
+        if(rc != SUCCESS)
+            return rc;
+        //the new root is on disk before the metadata points at it
+        clearNodeCache(ixfileHandle);
+        lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+        ixfileHandle.index->metadata.rootPage = newRootPageNum;
+        ixfileHandle.index->metadata.height++;
+        return writeMetadata(ixfileHandle);
+    }
+
+    NodePathEntry parent = path.back();
+    path.pop_back();
+    dropCachedNode(ixfileHandle, parent.pageNum);
+    void *parentPageData;
+    if (ixfileHandle.fileHandle.fetchPage(parent.pageNum, parentPageData) != SUCCESS)
+        return IX_READ_FAILED;
+    //the new child goes right after the one that was split
+    *getChildCount(attribute, parentPageData, parent.childIndex) = leftCount;
+    RC rc = SUCCESS;
+    if(getNodeFreeSpace(parentPageData) < entrySize + sizeof(NodeSlot)){
+        rc = splitPage(ixfileHandle, attribute, parentPageData, parent.pageNum, path, parent.childIndex, entry, entrySize, appending);
     }else{
-        newNodeHeader.parent = nodeHeader.parent;
-        setNodePageHeader(page, nodeHeader);
-        setNodePageHeader(newPageData, newNodeHeader);
-        int result = compare(attribute, midEntry, key);
-        if(nodeHeader.isLeaf==true){
-            if(result < 0){
-                insertInSortedOrder(newPageData,attribute,key,rid,-1,-1);
-            }else{
-                insertInSortedOrder(page,attribute,key,rid,-1,-1);
-            }
+        setEntryAtOffset(parentPageData, parent.childIndex, entry, entrySize);
+    }
+    ixfileHandle.fileHandle.unpinPage(parent.pageNum, true);
+    return rc;
+}
+
+static_assert(sizeof(BucketHeader) == sizeof(NodeHeader) && offsetof(BucketHeader, leftChild) == offsetof(NodeHeader, leftChild),
+        "buckets are laid out like leaves");
+
+bool IndexManager::isHashIndex(IXFileHandle &ixfileHandle)const{
+    return ixfileHandle.index->metadata.indexType == IX_HASH;
+}
+
+//FNV-1a over the key, then mixed so that the low bits the directory uses depend on every byte
+uint32_t IndexManager::hashKey(const Attribute &attribute, const void *nodeKey){
+    const unsigned char *bytes = (const unsigned char*)nodeKey;
+    unsigned keySize = getKeySearch(attribute.type).keySize(nodeKey);
+    uint32_t hash = 2166136261u;
+    for(unsigned i = 0; i < keySize; i++){
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+//a hash scan goes through the buckets in the order of their hashes read from the lowest bit up
+static uint32_t reverseBits(uint32_t value){
+    uint32_t reversed = 0;
+    for(unsigned i = 0; i < 32; i++){
+        reversed = (reversed << 1) | (value & 1);
+        value >>= 1;
+    }
+    return reversed;
+}
+
+void IndexManager::newBucketPage(void *page, uint32_t localDepth){
+    newIndexPage(page, IX_NO_PAGE);
+    BucketHeader bucketHeader = getBucketHeader(page);
+    bucketHeader.localDepth = localDepth;
+    bucketHeader.overflowPage = IX_NO_PAGE;
+    setBucketHeader(page, bucketHeader);
+}
+
+BucketHeader IndexManager::getBucketHeader(const void *page)const{
+    BucketHeader bucketHeader;
+    memcpy(&bucketHeader, page, sizeof(BucketHeader));
+    return bucketHeader;
+}
+
+void IndexManager::setBucketHeader(void *page, const BucketHeader &bucketHeader){
+    memcpy(page, &bucketHeader, sizeof(BucketHeader));
+}
+
+//the caller holds the root latch
+RC IndexManager::getDirectoryEntry(IXFileHandle &ixfileHandle, unsigned dirIndex, PageNum &bucketPage)const{
+    PageNum directoryPage = ixfileHandle.index->metadata.directoryPages[dirIndex / IX_HASH_DIRECTORY_ENTRIES];
+    void *pageData;
+    if(ixfileHandle.fileHandle.fetchPage(directoryPage, pageData))
+        return IX_READ_FAILED;
+    memcpy(&bucketPage, (char*)pageData + dirIndex % IX_HASH_DIRECTORY_ENTRIES * sizeof(PageNum), sizeof(PageNum));
+    ixfileHandle.fileHandle.unpinPage(directoryPage, false);
+    return SUCCESS;
+}
+
+//the caller holds the root latch exclusive
+RC IndexManager::setDirectoryEntry(IXFileHandle &ixfileHandle, unsigned dirIndex, PageNum bucketPage){
+    PageNum directoryPage = ixfileHandle.index->metadata.directoryPages[dirIndex / IX_HASH_DIRECTORY_ENTRIES];
+    void *pageData;
+    if(ixfileHandle.fileHandle.fetchPage(directoryPage, pageData))
+        return IX_READ_FAILED;
+    memcpy((char*)pageData + dirIndex % IX_HASH_DIRECTORY_ENTRIES * sizeof(PageNum), &bucketPage, sizeof(PageNum));
+    ixfileHandle.fileHandle.unpinPage(directoryPage, true);
+    return SUCCESS;
+}
+
+//the upper half of the new directory is a copy of the lower one, so every bucket is found under
+//one more bit of its keys' hashes. The caller holds the root latch exclusive
+RC IndexManager::doubleDirectory(IXFileHandle &ixfileHandle){
+    unsigned size = 1u << ixfileHandle.index->metadata.globalDepth;
+    if(size < IX_HASH_DIRECTORY_ENTRIES){
+        PageNum directoryPage = ixfileHandle.index->metadata.directoryPages[0];
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(directoryPage, pageData))
+            return IX_READ_FAILED;
+        memcpy((char*)pageData + size * sizeof(PageNum), pageData, size * sizeof(PageNum));
+        ixfileHandle.fileHandle.unpinPage(directoryPage, true);
+    }else{
+        unsigned pages = size / IX_HASH_DIRECTORY_ENTRIES;
+        char page[PAGE_SIZE];
+        for(unsigned i = 0; i < pages; i++){
+            void *pageData;
+            if(ixfileHandle.fileHandle.fetchPage(ixfileHandle.index->metadata.directoryPages[i], pageData))
+                return IX_READ_FAILED;
+            memcpy(page, pageData, PAGE_SIZE);
+            ixfileHandle.fileHandle.unpinPage(ixfileHandle.index->metadata.directoryPages[i], false);
+            PageNum newPage;
+            RC rc = allocateNode(ixfileHandle, page, newPage);
+            if(rc != SUCCESS)
+                return rc;
+            lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+            ixfileHandle.index->metadata.directoryPages[pages + i] = newPage;
         }
-        
-    //write pages 
-        void* parentPageData = malloc(PAGE_SIZE);
-        if(ixfileHandle.fileHandle.writePage(currentPageNum, page))
-            return IX_WRITE_FAILED;
-        if(ixfileHandle.fileHandle.appendPage(newPageData))
-            return IX_APPEND_FAILED;
+    }
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    ixfileHandle.index->metadata.globalDepth++;
+    return writeMetadata(ixfileHandle);
+}
 
-        if (ixfileHandle.fileHandle.readPage(parent, parentPageData) != SUCCESS)
-        {
-            free(parentPageData);
+//follows the directory to the bucket of hash, and latches the bucket before letting the directory go
+RC IndexManager::fetchBucket(IXFileHandle &ixfileHandle, uint32_t hash, bool exclusive, unsigned &dirIndex,
+        PageNum &bucketPage, void *&bucketData){
+    pthread_rwlock_rdlock(&ixfileHandle.index->rootLatch);
+    dirIndex = hash & ((1u << ixfileHandle.index->metadata.globalDepth) - 1);
+    RC rc = getDirectoryEntry(ixfileHandle, dirIndex, bucketPage);
+    if(rc == SUCCESS){
+        rc = fetchNode(ixfileHandle, bucketPage, bucketData, exclusive);
+    }
+    pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+    return rc;
+}
+
+//on failure only the bucket itself is left pinned
+RC IndexManager::fetchChain(IXFileHandle &ixfileHandle, PageNum bucketPage, void *bucketData, vector<PageNum> &pages,
+        vector<void*> &pageData){
+    pages.assign(1, bucketPage);
+    pageData.assign(1, bucketData);
+    PageNum nextPage = getBucketHeader(bucketData).overflowPage;
+    while(nextPage != IX_NO_PAGE){
+        void *nextData;
+        if(ixfileHandle.fileHandle.fetchPage(nextPage, nextData)){
+            releaseChain(ixfileHandle, pages, false);
+            pages.resize(1);
+            pageData.resize(1);
             return IX_READ_FAILED;
         }
-        NodeHeader parentHeader = getNodePageHeader(parentPageData);
-        if(parentHeader.endOfEntries+sizeof(NodeEntry)>PAGE_SIZE){
-            splitPage(ixfileHandle, parentPageData, parent, parentHeader.parent,attribute, key, rid);
-        }else{
-            if(attribute.type == TypeVarChar){
-                insertInParent(parentPageData, attribute, midEntry.key.strValue, midEntry.rid, currentPageNum, newNodePageNum);
-            }else if(attribute.type == TypeReal){
-                insertInParent(parentPageData, attribute, &(midEntry.key.floatValue), midEntry.rid, currentPageNum, newNodePageNum);
-            }else{
-                insertInParent(parentPageData, attribute, &(midEntry.key.intValue), midEntry.rid, currentPageNum, newNodePageNum);
+        pages.push_back(nextPage);
+        pageData.push_back(nextData);
+        nextPage = getBucketHeader(nextData).overflowPage;
+    }
+    return SUCCESS;
+}
+
+//unpins the overflow pages, the bucket is released as a node
+void IndexManager::releaseChain(IXFileHandle &ixfileHandle, const vector<PageNum> &pages, bool dirty){
+    for(unsigned i = 1; i < pages.size(); i++){
+        ixfileHandle.fileHandle.unpinPage(pages[i], dirty);
+    }
+}
+
+bool IndexManager::findInChain(const Attribute &attribute, const vector<void*> &pageData, const void *nodeKey,
+        unsigned &pageIndex, unsigned &entryNum)const{
+    const KeySearch &keySearch = getKeySearch(attribute.type);
+    for(pageIndex = 0; pageIndex < pageData.size(); pageIndex++){
+        entryNum = searchLeaf(keySearch, pageData[pageIndex], nodeKey, false);
+        if(entryNum < getNodePageHeader(pageData[pageIndex]).entryNumber &&
+                compareLeafKey(keySearch, pageData[pageIndex], entryNum, nodeKey) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+//puts an entry whose key isn't in the bucket on the first page of the chain with room for it. If
+//there is none, full is set while the bucket can still split; a bucket that can't gets a new
+//overflow page right after its first
+RC IndexManager::placeInChain(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<PageNum> &pages,
+        vector<void*> &pageData, const void *entry, unsigned entrySize, bool &full){
+    full = false;
+    for(unsigned i = 0; i < pages.size(); i++){
+        if(getNodeFreeSpace(pageData[i]) >= entrySize + sizeof(NodeSlot)){
+            setEntryAtOffset(pageData[i], lowerBound(pageData[i], attribute, entry), entry, entrySize);
+            return SUCCESS;
+        }
+    }
+    BucketHeader bucketHeader = getBucketHeader(pageData[0]);
+    if(bucketHeader.localDepth < IX_HASH_MAX_DEPTH){
+        full = true;
+        return SUCCESS;
+    }
+
+    char page[PAGE_SIZE];
+    newBucketPage(page, bucketHeader.localDepth);
+    appendEntry(page, entry, entrySize);
+    BucketHeader overflowHeader = getBucketHeader(page);
+    overflowHeader.overflowPage = bucketHeader.overflowPage;
+    setBucketHeader(page, overflowHeader);
+    PageNum pageNum;
+    RC rc = allocateNode(ixfileHandle, page, pageNum);
+    if(rc != SUCCESS)
+        return rc;
+    bucketHeader.overflowPage = pageNum;
+    setBucketHeader(pageData[0], bucketHeader);
+    return SUCCESS;
+}
+
+//adds the RID to its key's entry in the bucket, or starts one. A bucket with no room splits and
+//the insert starts over from the directory
+RC IndexManager::insertHashKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid){
+    uint32_t hash = hashKey(attribute, nodeKey);
+    while(true){
+        unsigned dirIndex;
+        PageNum bucketPage;
+        void *bucketData;
+        RC rc = fetchBucket(ixfileHandle, hash, true, dirIndex, bucketPage, bucketData);
+        if(rc != SUCCESS)
+            return rc;
+        vector<PageNum> pages;
+        vector<void*> pageData;
+        rc = fetchChain(ixfileHandle, bucketPage, bucketData, pages, pageData);
+
+        //an entry only grows while its list is inline, and then nothing is written until it is
+        //placed, so a full bucket leaves no change behind
+        bool full = false;
+        char entry[PAGE_SIZE];
+        unsigned entrySize;
+        unsigned pageIndex, entryNum;
+        if(rc == SUCCESS && findInChain(attribute, pageData, nodeKey, pageIndex, entryNum)){
+            void *page = pageData[pageIndex];
+            unsigned oldSize = getEntrySize(attribute, page, entryNum);
+            rc = insertIntoPosting(ixfileHandle, attribute, page, entryNum, rid, entry, entrySize);
+            if(rc == SUCCESS && getNodeFreeSpace(page) + oldSize >= entrySize){
+                removeEntryAt(page, attribute, entryNum);
+                setEntryAtOffset(page, entryNum, entry, entrySize);
+            }else if(rc == SUCCESS){
+                rc = placeInChain(ixfileHandle, attribute, pages, pageData, entry, entrySize, full);
+                if(rc == SUCCESS && !full){
+                    removeEntryAt(page, attribute, entryNum);
+                }
+            }
+        }else if(rc == SUCCESS){
+            rc = makePostingEntry(ixfileHandle, attribute, nodeKey, vector<RID>(1, rid), entry, entrySize);
+            if(rc == SUCCESS){
+                rc = placeInChain(ixfileHandle, attribute, pages, pageData, entry, entrySize, full);
+            }
+        }
+        uint32_t localDepth = getBucketHeader(bucketData).localDepth;
+        releaseChain(ixfileHandle, pages, !full);
+        releaseNode(ixfileHandle, bucketPage, !full);
+        if(rc != SUCCESS)
+            return rc;
+        if(!full)
+            break;
+        rc = splitBucket(ixfileHandle, attribute, hash, bucketPage, localDepth);
+        if(rc != SUCCESS)
+            return rc;
+    }
+
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    ixfileHandle.index->metadata.entryNumber++;
+    ixfileHandle.index->metadataDirty = true;
+    return SUCCESS;
+}
+
+//an overflow page emptied by the delete leaves the chain; buckets themselves stay
+RC IndexManager::deleteHashKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid){
+    unsigned dirIndex;
+    PageNum bucketPage;
+    void *bucketData;
+    RC rc = fetchBucket(ixfileHandle, hashKey(attribute, nodeKey), true, dirIndex, bucketPage, bucketData);
+    if(rc != SUCCESS)
+        return rc;
+    vector<PageNum> pages;
+    vector<void*> pageData;
+    rc = fetchChain(ixfileHandle, bucketPage, bucketData, pages, pageData);
+
+    bool found = false;
+    PageNum emptiedPage = IX_NO_PAGE;
+    unsigned pageIndex, entryNum;
+    if(rc == SUCCESS && findInChain(attribute, pageData, nodeKey, pageIndex, entryNum)){
+        void *page = pageData[pageIndex];
+        char entry[PAGE_SIZE];
+        unsigned entrySize;
+        rc = removeFromPosting(ixfileHandle, attribute, page, entryNum, rid, entry, entrySize, found);
+        if(rc == SUCCESS && found){
+            removeEntryAt(page, attribute, entryNum);
+            if(entrySize > 0){
+                setEntryAtOffset(page, entryNum, entry, entrySize);
             }
-            if(ixfileHandle.fileHandle.writePage(parent, parentPageData)){
-                return IX_WRITE_FAILED;
+        }
+        if(rc == SUCCESS && found && pageIndex > 0 && getNodePageHeader(page).entryNumber == 0){
+            BucketHeader previousHeader = getBucketHeader(pageData[pageIndex - 1]);
+            previousHeader.overflowPage = getBucketHeader(page).overflowPage;
+            setBucketHeader(pageData[pageIndex - 1], previousHeader);
+            emptiedPage = pages[pageIndex];
+        }
+    }
+    releaseChain(ixfileHandle, pages, found);
+    if(emptiedPage != IX_NO_PAGE){
+        rc = freeNode(ixfileHandle, emptiedPage);
+    }
+    releaseNode(ixfileHandle, bucketPage, found);
+    if(rc != SUCCESS)
+        return rc;
+    if(!found)
+        return IX_DELETION_DNE;
+
+    lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+    ixfileHandle.index->metadata.entryNumber--;
+    ixfileHandle.index->metadataDirty = true;
+    return SUCCESS;
+}
+
+//splits the bucket of hash by the next bit of its keys' hashes, doubling the directory first if
+//the bucket is as deep as it. Nothing is done if another thread split the bucket since the insert
+//found it full at localDepth
+RC IndexManager::splitBucket(IXFileHandle &ixfileHandle, const Attribute &attribute, uint32_t hash, PageNum bucketPage,
+        uint32_t localDepth){
+    pthread_rwlock_wrlock(&ixfileHandle.index->rootLatch);
+    unsigned dirIndex = hash & ((1u << ixfileHandle.index->metadata.globalDepth) - 1);
+    PageNum currentPage;
+    RC rc = getDirectoryEntry(ixfileHandle, dirIndex, currentPage);
+    if(rc != SUCCESS || currentPage != bucketPage){
+        pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+        return rc;
+    }
+    void *bucketData;
+    rc = fetchNode(ixfileHandle, bucketPage, bucketData, true);
+    if(rc != SUCCESS){
+        pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+        return rc;
+    }
+    if(getBucketHeader(bucketData).localDepth != localDepth){
+        releaseNode(ixfileHandle, bucketPage, false);
+        pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+        return SUCCESS;
+    }
+    if(localDepth == ixfileHandle.index->metadata.globalDepth){
+        rc = doubleDirectory(ixfileHandle);
+    }
+
+    //the whole entries of the chain, in key order, shared out by the new bit
+    vector<PageNum> pages;
+    vector<void*> pageData;
+    vector<string> entries;
+    if(rc == SUCCESS){
+        rc = fetchChain(ixfileHandle, bucketPage, bucketData, pages, pageData);
+    }
+    for(unsigned i = 0; rc == SUCCESS && i < pageData.size(); i++){
+        getLeafEntries(attribute, pageData[i], entries);
+    }
+    releaseChain(ixfileHandle, pages, false);
+    const KeySearch &keySearch = getKeySearch(attribute.type);
+    sort(entries.begin(), entries.end(), [&](const string &a, const string &b) {
+        return keySearch.compare(a.data(), b.data()) < 0;
+    });
+    vector<string> lowEntries, highEntries;
+    for(unsigned i = 0; i < entries.size(); i++){
+        if((hashKey(attribute, entries[i].data()) >> localDepth) & 1){
+            highEntries.push_back(entries[i]);
+        }else{
+            lowEntries.push_back(entries[i]);
+        }
+    }
+    vector<PageNum> newPages;
+    if(rc == SUCCESS){
+        rc = writeBucket(ixfileHandle, attribute, pages, localDepth + 1, lowEntries);
+    }
+    if(rc == SUCCESS){
+        rc = writeBucket(ixfileHandle, attribute, newPages, localDepth + 1, highEntries);
+    }
+
+    //the directory entries of the old bucket with the new bit set go to the new one
+    unsigned first = (dirIndex & ((1u << localDepth) - 1)) | (1u << localDepth);
+    for(unsigned i = first; rc == SUCCESS && i < (1u << ixfileHandle.index->metadata.globalDepth); i += 2u << localDepth){
+        rc = setDirectoryEntry(ixfileHandle, i, newPages[0]);
+    }
+    if(rc == SUCCESS){
+        lock_guard<mutex> guard(ixfileHandle.index->metadataLatch);
+        ixfileHandle.index->metadata.leafNumber++;
+        ixfileHandle.index->metadataDirty = true;
+    }
+    releaseNode(ixfileHandle, bucketPage, false);
+    pthread_rwlock_unlock(&ixfileHandle.index->rootLatch);
+    return rc;
+}
+
+//lays entries out in order over the pages of a bucket's chain, the pages it has first, then new
+//overflow pages, and frees the pages left over. A bucket keeps at least its first page
+RC IndexManager::writeBucket(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<PageNum> &pages,
+        uint32_t localDepth, const vector<string> &entries){
+    unsigned capacity = PAGE_SIZE - sizeof(BucketHeader) - sizeof(VarCharKeyLength);
+    vector<unsigned> ends;
+    unsigned used = 0;
+    for(unsigned i = 0; i < entries.size(); i++){
+        unsigned size = entries[i].size() + sizeof(NodeSlot);
+        if(used + size > capacity){
+            ends.push_back(i);
+            used = 0;
+        }
+        used += size;
+    }
+    ends.push_back(entries.size());
+
+    char page[PAGE_SIZE];
+    newBucketPage(page, localDepth);
+    while(pages.size() < ends.size()){
+        PageNum pageNum;
+        RC rc = allocateNode(ixfileHandle, page, pageNum);
+        if(rc != SUCCESS)
+            return rc;
+        pages.push_back(pageNum);
+    }
+    for(unsigned i = pages.size(); i > ends.size(); i--){
+        RC rc = freeNode(ixfileHandle, pages[i - 1]);
+        if(rc != SUCCESS)
+            return rc;
+    }
+    pages.resize(ends.size());
+
+    unsigned first = 0;
+    for(unsigned i = 0; i < pages.size(); i++){
+        newBucketPage(page, localDepth);
+        for(unsigned j = first; j < ends[i]; j++){
+            appendEntry(page, entries[j].data(), entries[j].size());
+        }
+        BucketHeader bucketHeader = getBucketHeader(page);
+        bucketHeader.overflowPage = i + 1 < pages.size() ? pages[i + 1] : IX_NO_PAGE;
+        setBucketHeader(page, bucketHeader);
+        void *pageData;
+        if(ixfileHandle.fileHandle.fetchPage(pages[i], pageData))
+            return IX_READ_FAILED;
+        memcpy(pageData, page, PAGE_SIZE);
+        ixfileHandle.fileHandle.unpinPage(pages[i], true);
+        first = ends[i];
+    }
+    return SUCCESS;
+}
+
+//the RIDs of nodeKey as readPosting copies them, none if the key isn't in the index
+RC IndexManager::readHashPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey,
+        const RID *after, vector<RID> &rids, bool &complete){
+    complete = true;
+    unsigned dirIndex;
+    PageNum bucketPage;
+    void *bucketData;
+    RC rc = fetchBucket(ixfileHandle, hashKey(attribute, nodeKey), false, dirIndex, bucketPage, bucketData);
+    if(rc != SUCCESS)
+        return rc;
+    vector<PageNum> pages;
+    vector<void*> pageData;
+    rc = fetchChain(ixfileHandle, bucketPage, bucketData, pages, pageData);
+    unsigned pageIndex, entryNum;
+    if(rc == SUCCESS && findInChain(attribute, pageData, nodeKey, pageIndex, entryNum)){
+        rc = readPosting(ixfileHandle, attribute, pageData[pageIndex], entryNum, after, rids, complete);
+    }
+    releaseChain(ixfileHandle, pages, false);
+    releaseNode(ixfileHandle, bucketPage, false);
+    return rc;
+}
+
+//the keys of the bucket position falls in, then position moves on to where the bucket ends. The
+//low localDepth bits of the hashes in a bucket are the same, and reversed they are the top bits
+//of position
+RC IndexManager::readHashBucket(IXFileHandle &ixfileHandle, const Attribute &attribute, uint64_t &position,
+        vector<string> &keys){
+    unsigned dirIndex;
+    PageNum bucketPage;
+    void *bucketData;
+    RC rc = fetchBucket(ixfileHandle, reverseBits(position), false, dirIndex, bucketPage, bucketData);
+    if(rc != SUCCESS)
+        return rc;
+    vector<PageNum> pages;
+    vector<void*> pageData;
+    rc = fetchChain(ixfileHandle, bucketPage, bucketData, pages, pageData);
+    const KeySearch &keySearch = getKeySearch(attribute.type);
+    char nodeKey[PAGE_SIZE];
+    for(unsigned i = 0; rc == SUCCESS && i < pageData.size(); i++){
+        NodeHeader nodeHeader = getNodePageHeader(pageData[i]);
+        for(unsigned j = 0; j < nodeHeader.entryNumber; j++){
+            getLeafKey(keySearch, pageData[i], j, nodeKey);
+            keys.push_back(string(nodeKey, keySearch.keySize(nodeKey)));
+        }
+    }
+    unsigned shift = 32 - getBucketHeader(bucketData).localDepth;
+    releaseChain(ixfileHandle, pages, false);
+    releaseNode(ixfileHandle, bucketPage, false);
+    position = ((position >> shift) + 1) << shift;
+    return rc;
+}
+
+//each bucket once, at the lowest directory entry that points at it, with its overflow pages
+void IndexManager::printBuckets(IXFileHandle &ixfileHandle, const Attribute &attribute)const{
+    cout<<"{\"buckets\": ["<<endl;
+    bool first = true;
+    for(unsigned i = 0; i < (1u << ixfileHandle.index->metadata.globalDepth); i++){
+        PageNum pageNum;
+        void *pageData;
+        if(getDirectoryEntry(ixfileHandle, i, pageNum) != SUCCESS ||
+                ixfileHandle.fileHandle.fetchPage(pageNum, pageData) != SUCCESS){
+            return;
+        }
+        BucketHeader bucketHeader = getBucketHeader(pageData);
+        ixfileHandle.fileHandle.unpinPage(pageNum, false);
+        if(i >> bucketHeader.localDepth){
+            continue;
+        }
+        while(pageNum != IX_NO_PAGE){
+            if(!first) cout<<","<<endl;
+            printRecursively(ixfileHandle, attribute, pageNum, 1);
+            first = false;
+            if(ixfileHandle.fileHandle.fetchPage(pageNum, pageData) != SUCCESS){
+                return;
             }
+            PageNum nextPage = getBucketHeader(pageData).overflowPage;
+            ixfileHandle.fileHandle.unpinPage(pageNum, false);
+            pageNum = nextPage;
         }
-        free(newPageData);
-        free(parentPageData);
     }
-}
\ No newline at end of file
+    cout<<endl<<"]}";
+}
@@ -3,9 +3,14 @@
 
 #include <vector>
 #include <string>
+#include <map>
+#include <unordered_map>
 #include <cstring>
 #include <cmath>
 #include <iostream>
+#include <mutex>
+#include <atomic>
+#include <pthread.h>
 
 #include "../rbf/rbfm.h"
 
@@ -21,37 +26,259 @@
 # define  IX_DELETION_DNE 8
 # define  IX_FILE_DNE 9
 # define  IX_SCANNER_CLOSED 10
+# define  IX_KEY_TOO_LONG 11
+# define  IX_KEY_TYPE_MISMATCH 12
+# define  IX_BAD_FORMAT 13
+# define  IX_INVALID_ARGUMENT 14
+# define  IX_UNORDERED_INDEX 15     // Counting and positions need the key order of a B+ tree
+# define  IX_SCAN_OPEN 16           // closeFile is refused while a scan through the handle holds a leaf
+
+// Largest key, in its node format, that an index accepts. A node always has room for three
+// entries with keys this long, so splits can always leave a key on either side
+# define  IX_MAX_KEY_SIZE (PAGE_SIZE / 4)
 
 class IX_ScanIterator;
 class IXFileHandle;
 
+// Index metadata page
+// Page 0 of an index file describes the tree, so opening an index reads one page and every
+// lookup starts from the real root. A root split writes the new root first and then switches
+// rootPage here with a single page write. The counts are kept in the IndexFile and written
+// back when its last handle is closed. Pages freed by merges are chained through their first bytes
+// from freePageList and reused before the file is extended.
+# define  IX_METADATA_PAGE 0
+# define  IX_NO_PAGE ((PageNum) -1)
+# define  IX_MAGIC 0x49584254       // "IXBT"
+# define  IX_FORMAT_VERSION 1      // openFile refuses files of any other version
+# define  IX_NO_KEY_TYPE (-1)       // Set by the first insertEntry
+# define  IX_COMPOSITE_KEY ((AttrType) 3)   // Key type of an index over several attributes
+# define  IX_MAX_KEY_FIELDS 8
+# define  IX_DEFAULT_FILL_FACTOR 0.9f    // Share of a node kept by an append split
+# define  IX_CACHED_LEVELS 2        // Levels from the root that lookups search in the node cache
+
+// Structures an index file can hold, chosen when it is created
+typedef enum {
+    IX_BTREE = 0,       // Ordered: ranges, counts and positions
+    IX_HASH             // Extendible hashing: a lookup reads a directory page and a bucket
+} IndexType;
+
+// Hash directory
+// The directory of a hash index is an array of 2^globalDepth bucket page numbers, indexed by the
+// low globalDepth bits of a key's hash, laid over directory pages of IX_HASH_DIRECTORY_ENTRIES
+// each. The directory pages are listed in the metadata, so a lookup reads one of them and then
+// the bucket. Doubling the directory copies it into new pages; it never shrinks.
+# define  IX_HASH_DIRECTORY_ENTRIES (PAGE_SIZE / sizeof(PageNum))
+# define  IX_HASH_MAX_DIRECTORY_PAGES 64
+# define  IX_HASH_MAX_DEPTH 16     // 2^16 entries fill IX_HASH_MAX_DIRECTORY_PAGES
+
+typedef struct IndexMetadata
+{
+    uint32_t magic;
+    uint32_t version;
+    PageNum rootPage;           // IX_NO_PAGE in a hash index
+    uint32_t height;            // Levels including the leaves
+    int32_t keyType;            // AttrType of the key, or IX_NO_KEY_TYPE
+    uint64_t entryNumber;
+    uint32_t leafNumber;        // Leaves, or buckets of a hash index
+    PageNum freePageList;       // First free page, or IX_NO_PAGE
+    uint32_t keyFieldNumber;    // Fields of a composite key, 0 for other key types
+    int32_t keyFieldTypes[IX_MAX_KEY_FIELDS];
+    float fillFactor;           // Set by setFillFactor or bulkLoad, 0 for IX_DEFAULT_FILL_FACTOR
+    uint32_t indexType;         // IndexType
+    uint32_t globalDepth;       // Hash bits the directory is indexed by
+    PageNum directoryPages[IX_HASH_MAX_DIRECTORY_PAGES];
+} IndexMetadata;
+
+// A page on the free page list
+typedef struct FreePageHeader
+{
+    PageNum nextFreePage;
+} FreePageHeader;
+
+// Offset of an entry within its node page
+typedef uint16_t NodeSlot;
+
+// Keys in a node are normalized so that any two compare with memcmp. An Int is stored big-endian
+// with its sign bit flipped, a Real big-endian with its sign bit flipped if it is positive and
+// all its bits flipped if it is negative. A VarChar is a VarCharKeyLength followed by its
+// characters with every 0x00 escaped as 0x00 0xFF, ending in 0x00 0x00. No encoded VarChar is a
+// prefix of another, so memcmp over the shorter one decides.
+typedef uint16_t VarCharKeyLength;      // Bytes of the encoded characters
+
+// A composite key is laid out like a VarChar key: a VarCharKeyLength, then for each field 0x00
+// if it is null, or 0x01 and its value encoded as above, a VarChar without its length. Every
+// value has a fixed length or a terminator, so a key over the leading fields is a prefix of the
+// full key and compares equal to every key that starts with those values.
+
+// Posting lists
+// A leaf has one entry per key, holding every RID with that key in (pageNum, slotNum) order.
+// RIDs are delta encoded as varints: the difference to the previous page number, then the slot
+// number, as a difference too if the page is the same. Lists longer than IX_POSTING_INLINE_SIZE
+// bytes move to a chain of posting pages and the entry keeps an OverflowPosting instead.
+typedef uint16_t PostingHeader;     // Length of the inline list, or IX_POSTING_OVERFLOW
+# define  IX_POSTING_OVERFLOW 0xFFFF
+# define  IX_POSTING_INLINE_SIZE (PAGE_SIZE / 16)
+# define  IX_MAX_RID_SIZE 10        // Two 5-byte varints
+
+typedef struct OverflowPosting
+{
+    uint32_t ridNumber;
+    PageNum firstPage;
+    PageNum lastPage;           // Appends go straight to the last page
+} OverflowPosting;
+
+// Posting page
+// [PostingPageHeader][RIDs encoded as in an inline list]
+// Each page starts the delta encoding over, so it can be read by itself.
+typedef struct PostingPageHeader
+{
+    PageNum nextPage;           // IX_NO_PAGE on the last page
+    uint16_t ridNumber;
+    uint16_t length;            // Bytes of encoded RIDs
+    RID lastRid;                // Lets appends and lookups skip decoding the page
+} PostingPageHeader;
+
+// B+ tree node page
+// [NodeHeader][slot 0][slot 1]...        free space        ...[entry 1][entry 0]([key prefix][VarCharKeyLength])
+//                                                                               ([SubtreeCount])
+// Slots are kept in key order and point at entries packed against the end of the page.
+// A leaf entry is a key followed by its posting list, and the leaf ends in its key prefix. An
+// internal entry is a key padded to 4 bytes, the page number of the child to its right and that
+// child's SubtreeCount; leftChild is the child left of the first key, and the node ends in its
+// count. Keys left of a separator are less than it and keys right of it are not.
+//
+// Leaf key prefixes
+// A leaf ends in the bytes all of its keys start with and their VarCharKeyLength, and each entry
+// keeps only the rest of its key, itself as a VarCharKeyLength and the bytes. The prefix is only
+// worked out again when the leaf is rebuilt by a split or merge, or by an insert of a key that
+// doesn't start with it. 4-byte keys always have an empty prefix.
+//
+// Separators
+// A leaf split pushes up the shortest prefix of the right leaf's first key that is still greater
+// than the left leaf's last key. Separators are compared as plain byte strings, a prefix before
+// any longer string, so they needn't be whole keys and may be prefixes of one another.
+//
+// Subtree counts
+// Every child of an internal node comes with the number of entries, one per RID, in its subtree,
+// so a range is counted, or an entry found by its position, on the way down from the root
+// without reading the leaves in between. Inserts and deletes add to the counts on their path
+// while holding it latched shared, so the counts are aligned in the page and changed atomically;
+// splits, merges and redistributions work out those of the nodes they rebuild.
+typedef uint32_t SubtreeCount;
+
+// Split points
+// A node splits into halves of about the same size, unless inserts are appends: the new entry
+// is the last of the rightmost leaf, or comes right after the key last added to its leaf. Then
+// the leaf keeps the index's fill factor of its entries and the rest moves right, so increasing
+// keys leave full leaves behind instead of half empty ones. An internal node above an append
+// split splits the same way if the new separator is its last.
 typedef struct NodeHeader      //page header
 {
-    uint32_t endOfEntries;
-    uint32_t indexEntryNumber;
-    bool isLeaf;
-    int16_t leftPageNum;
-    int16_t rightPageNum;
-    int16_t parent;
-    // uint32_t endOfEntries;
-    // uint32_t indexEntryNumber;
-    // bool isLeaf;
-    // int leftPageNum;
-    // int rightPageNum;
-    // int parent;
+    uint16_t freeSpaceOffset;   // start of the entry area
+    uint16_t entryNumber;
+    PageNum leftPageNum;        // leaf siblings, IX_NO_PAGE at either end of the leaf level
+    PageNum rightPageNum;
+    PageNum leftChild;          // IX_NO_PAGE in leaves
+
+    // Every internal node has a leftmost child
+    bool isLeaf() const
+    {
+        return leftChild == IX_NO_PAGE;
+    }
 } NodeHeader;
 
-typedef struct NodeEntry {
-    RID rid;
-    //need key value
-    union{
-        int intValue;
-        float floatValue;
-        char* strValue;
-    }key;
-    int leftChildPageNum;
-    int rightChildPageNum;
-} NodeEntry;
+// Hash bucket page
+// A bucket is laid out like a leaf with an empty key prefix, so the leaf code searches its entries
+// and keeps their posting lists. The sibling links of a leaf hold the bucket's local depth, the
+// low hash bits its keys share, and its chain of overflow pages instead. Buckets split as long as
+// the directory can double; past IX_HASH_MAX_DEPTH a full bucket gets another overflow page.
+// Buckets are not merged, so a hash index keeps its size after deletes.
+typedef struct BucketHeader
+{
+    uint16_t freeSpaceOffset;
+    uint16_t entryNumber;
+    uint32_t localDepth;        // Only meaningful on the bucket's first page
+    PageNum overflowPage;       // Next page of the chain, or IX_NO_PAGE
+    PageNum leftChild;          // IX_NO_PAGE, as in a leaf
+} BucketHeader;
+
+// A node passed on the way from the root to a leaf and the child that was followed,
+// so splits can insert into the parent without storing parent pointers in the nodes
+typedef struct NodePathEntry
+{
+    PageNum pageNum;
+    unsigned childIndex;        // 0 is leftChild, i + 1 the child of entry i
+} NodePathEntry;
+
+// How traverse latches the nodes it passes. Threads share an index by latch crabbing: a
+// child's latch is taken before its parent's is let go, and siblings on one level are always
+// latched left to right. Reads hold shared latches on internal nodes. Most inserts and deletes
+// change only their leaf and the subtree counts above it, so they keep the path latched shared;
+// an operation that must split or merge starts over with exclusive latches on every node it
+// may change. A split stops at the lowest node with room for another separator, and above that
+// node an insert only adds to the counts, which it does atomically under shared latches.
+typedef enum {
+    IX_TRAVERSE_READ = 0,       // Leaf latched shared, no path
+    IX_TRAVERSE_WRITE_LEAF,     // Leaf latched exclusive, path shared
+    IX_TRAVERSE_INSERT,         // Path latched exclusive from the lowest node a split can't pass, shared above
+    IX_TRAVERSE_DELETE          // Whole path latched exclusive
+} TraverseMode;
+
+// Key handling compiled for one key layout, 4-byte or VarChar. Every operation picks the table
+// for its key type once, so the searches run specialized code with no type checks per compare.
+// lowerBound and upperBound search the keys as a leaf stores them, after its prefix
+typedef struct KeySearch
+{
+    unsigned (*keySize)(const void *nodeKey);
+    int (*compare)(const void *entryKey, const void *key);
+    unsigned (*lowerBound)(const void *page, const void *key);
+    unsigned (*upperBound)(const void *page, const void *key);
+    unsigned (*separatorLowerBound)(const void *page, const void *key);
+    unsigned (*separatorUpperBound)(const void *page, const void *key);
+} KeySearch;
+
+// An open index. Every IXFileHandle opened on the same file shares one, the way FileHandles
+// share an OpenFile, so all of them descend from the same root and keep the same counts. It is
+// read from the metadata page by the first openFile and written back by the last closeFile.
+typedef struct IndexFile
+{
+    FileId id;
+    unsigned handleCount;
+
+    IndexMetadata metadata;     // Copy of the metadata page
+    bool metadataDirty;         // The counts changed since it was last written
+
+    // Several threads may use the index. rootLatch guards rootPage and height and is taken
+    // before the root node, or guards the directory of a hash index; metadataLatch guards the
+    // rest of metadata and metadataDirty.
+    pthread_rwlock_t rootLatch;
+    mutex metadataLatch;
+
+    // Scans that may still return entries. Each keeps a leaf pinned, so deletes don't merge
+    // or redistribute nodes while there are any. The leaves they leave underfull are kept in
+    // underfullLeaves, with a key each leaf may hold, and rebalanced when the last scan ends.
+    // scanLatch guards underfullLeaves and is held while the last scan takes them, so none
+    // is added after that.
+    atomic<unsigned> openScans;
+    map<PageNum, string> underfullLeaves;
+    Attribute underfullAttribute;
+    mutex scanLatch;
+
+    // Leaf page and entry number of the last key added, so a split can tell that inserts follow
+    // one another through a leaf, as a run of increasing keys inside the index does.
+    atomic<uint64_t> lastInsert;
+
+    // Copies of the internal nodes in the top IX_CACHED_LEVELS levels, so a lookup through any
+    // handle only reads the pages below them. Copies are made and searched under rootLatch; a
+    // split or merge through any handle drops the copies of the nodes it changes while holding
+    // rootLatch exclusively. Their subtree counts go stale and are never read. nodeCacheLatch
+    // guards the map and is never held while a page is latched.
+    map<PageNum, string> nodeCache;
+    mutex nodeCacheLatch;
+
+    IndexFile();
+    ~IndexFile();
+} IndexFile;
 
 class IndexManager {
 
@@ -62,6 +289,12 @@ class IndexManager {
         // Create an index file.
         RC createFile(const string &fileName);
 
+        // Create an index file holding indexType. Every operation below works on either kind,
+        // except that a hash index has no key order: its range scans return entries in no
+        // particular order after reading every bucket, and countRange, rank and select fail with
+        // IX_UNORDERED_INDEX. A scan whose bounds are the same whole key reads one bucket.
+        RC createFile(const string &fileName, IndexType indexType);
+
         // Delete an index file.
         RC destroyFile(const string &fileName);
 
@@ -74,6 +307,19 @@ class IndexManager {
         // Insert an entry into the given index that is indicated by the given ixfileHandle.
         RC insertEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid);
 
+        // Insert a batch of entries, sorting them by (key, RID) first if they aren't already.
+        // An empty index is built bottom-up: leaves are packed left to right with one posting
+        // list per key, then each internal level is built in one pass over the level below.
+        // fillFactor, in (0, 1], is the fraction of each node filled, leaving room for later
+        // inserts, and becomes the index's fill factor as setFillFactor sets it. Entries for an
+        // index that already has some are inserted one at a time.
+        RC bulkLoad(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<const void*> &keys,
+                const vector<RID> &rids, float fillFactor);
+
+        // Set how full, in (0, 1], a node is left when it splits under inserts at the end of the
+        // index, such as increasing keys. 1 moves only the new entry to the new node. Kept in the file.
+        RC setFillFactor(IXFileHandle &ixfileHandle, float fillFactor);
+
         // Delete an entry from the given index that is indicated by the given ixfileHandle.
         RC deleteEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, const RID &rid);
 
@@ -86,7 +332,52 @@ class IndexManager {
                 bool highKeyInclusive,
                 IX_ScanIterator &ix_ScanIterator);
 
-        // Print the B+ tree in pre-order (in a JSON record format)
+        // Composite indexes. A key is a tuple over attributes in the record format: a null indicator
+        // bitmap followed by the fields that are not null. The first insert fixes the attribute
+        // types of the index. Scan bounds may cover only the leading lowKeyFields and highKeyFields
+        // attributes, so a scan can fix the leading attributes and give a range on the next one.
+        // Scans return the whole key tuple.
+        RC insertEntry(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const void *key, const RID &rid);
+        RC bulkLoad(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const vector<const void*> &keys,
+                const vector<RID> &rids, float fillFactor);
+        RC deleteEntry(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const void *key, const RID &rid);
+        RC scan(IXFileHandle &ixfileHandle,
+                const vector<Attribute> &attributes,
+                const void *lowKey,
+                unsigned lowKeyFields,
+                const void *highKey,
+                unsigned highKeyFields,
+                bool lowKeyInclusive,
+                bool highKeyInclusive,
+                IX_ScanIterator &ix_ScanIterator);
+
+        // Number of entries with keys between lowKey and highKey, as many as a scan with the same
+        // bounds would return. It takes two descents from the root whatever the range holds.
+        RC countRange(IXFileHandle &ixfileHandle,
+                const Attribute &attribute,
+                const void *lowKey,
+                const void *highKey,
+                bool lowKeyInclusive,
+                bool highKeyInclusive,
+                uint64_t &count);
+        RC countRange(IXFileHandle &ixfileHandle,
+                const vector<Attribute> &attributes,
+                const void *lowKey,
+                unsigned lowKeyFields,
+                const void *highKey,
+                unsigned highKeyFields,
+                bool lowKeyInclusive,
+                bool highKeyInclusive,
+                uint64_t &count);
+
+        // Position of key in the order a full scan returns entries: the number of entries with
+        // smaller keys, whether or not key is in the index.
+        RC rank(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, uint64_t &position);
+
+        // The entry a full scan returns at position, counting from 0. IX_EOF past the last one.
+        RC select(IXFileHandle &ixfileHandle, const Attribute &attribute, uint64_t position, void *key, RID &rid);
+
+        // Print the B+ tree in pre-order (in a JSON record format), or the buckets of a hash index
         void printBtree(IXFileHandle &ixfileHandle, const Attribute &attribute) const;
 
         friend class IX_ScanIterator;
@@ -98,31 +389,196 @@ class IndexManager {
     private:
         static IndexManager *_index_manager;
 
-        void newIndexPage(void * page);     //creates a new Index Page
-
-        NodeHeader getNodePageHeader(void * page)const;      //returns the node page header
-        void setNodePageHeader(void * page, NodeHeader nodeHeader);     //sets the node page header
-
-        NodeEntry getNodeEntry(void* page, unsigned entryNum)const;   //returns the node entry on the page corresponding to the pageNum
-        unsigned getRootPageNum(IXFileHandle ixfileHandle)const;     //returns the page number of the root of the tree
-
-        unsigned traverse(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key); //finds the correct leaf based on the key
-        unsigned findPointerEntry(void* page, const Attribute &attribute, const void *key);     //returns the entry number of the first entry with a key not
-                                                                                                //less than the specified key
-        unsigned findPointerEntryInParent(void* page, const Attribute &attribute, const void *key);
+        // Indexes with at least one open IXFileHandle
+        unordered_map<FileId, IndexFile*, FileIdHash> openIndexes;
+        mutex openIndexesLatch;
 
-        int compare(const Attribute &attribute, NodeEntry &entry, const void *key);      //returns -1 if entry.key is less, 1 otherwise
-        int compareInParent(const Attribute &attribute, NodeEntry &entry, const void *key);
+        void newIndexPage(void * page, PageNum leftChild);     //creates a new Index Page, a leaf if leftChild is IX_NO_PAGE
 
-        void setEntryAtOffset(void* page, unsigned offset, NodeEntry &entry);        //moves all the entries after the entry and inserts the entry at the offset
-                                                                                    //does not update the page header
-        void insertInSortedOrder(void* page,const Attribute &attribute, const void *key, const RID &rid, unsigned left, unsigned right);
-        void insertInParent(void* page, const Attribute &attribute, const void *key, const RID &rid, unsigned left, unsigned right);
-
-        unsigned splitPage(IXFileHandle &ixfileHandle, void* page, unsigned currentPageNum, 
-                unsigned parent, const Attribute &attribute, const void *key,const RID &rid);
+        NodeHeader getNodePageHeader(const void * page)const;      //returns the node page header
+        void setNodePageHeader(void * page, NodeHeader nodeHeader);     //sets the node page header
 
-        void printRecursively(IXFileHandle &ixfileHandle, const Attribute &attribute, unsigned pageNum, unsigned tabs)const;
+        static NodeSlot* getSlots(const void* page);                 //the slot array, read and updated in place
+        static char* getEntry(const void* page, unsigned entryNum);  //points at an entry inside the page, its key comes first
+        unsigned getEntrySize(const Attribute &attribute, const void* page, unsigned entryNum)const;
+        unsigned getNodeFreeSpace(const void* page)const;
+        PageNum getChild(const Attribute &attribute, const void* page, unsigned childIndex)const;
+        SubtreeCount* getChildCount(const Attribute &attribute, const void* page, unsigned childIndex)const;   //updated in place
+        unsigned getRootPageNum(IXFileHandle &ixfileHandle)const;     //returns the page number of the root of the tree
+
+        RC readMetadata(IXFileHandle &ixfileHandle);
+        RC writeMetadata(IXFileHandle &ixfileHandle);
+        RC checkKeyType(IXFileHandle &ixfileHandle, const Attribute &attribute);
+        int32_t getKeyType(IXFileHandle &ixfileHandle);
+        RC checkKeyFields(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes);
+        bool hasKeyFields(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes);
+        float getFillFactor(IXFileHandle &ixfileHandle);
+        static Attribute getCompositeAttribute();      //stands for every composite key inside the tree
+
+        //the public operations once the key is in the node format. They go to the hash index
+        //functions below for a hash index
+        RC insertNodeKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid);
+        RC deleteNodeKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid);
+        RC bulkLoadNodeKeys(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<char> &nodeKeys,
+                const vector<unsigned> &keyOffsets, const vector<RID> &rids, float fillFactor);
+
+        //keys are converted to the node format once on the way in and compared in place
+        unsigned getKeySize(const Attribute &attribute, const void *nodeKey)const;
+        void toNodeKey(const Attribute &attribute, const void *key, void *nodeKey)const;
+        void fromNodeKey(const Attribute &attribute, const void *nodeKey, void *key)const;
+        void toCompositeNodeKey(const vector<Attribute> &attributes, unsigned fieldNumber, const void *key, void *nodeKey)const;
+        void fromCompositeNodeKey(const vector<Attribute> &attributes, const void *nodeKey, void *key)const;
+        //a single value, a VarChar without its VarCharKeyLength. valueSize is the size of the value as
+        //the record manager stores it, the return value that of its encoding
+        unsigned encodeKeyValue(AttrType type, const void *value, unsigned &valueSize, unsigned char *out)const;
+        unsigned decodeKeyValue(AttrType type, const unsigned char *in, void *value, unsigned &valueSize)const;
+        int compare(const Attribute &attribute, const void *entryKey, const void *key)const;     //<0, 0, >0 as entryKey is less, equal or greater
+
+        //binary searches over the entries of a leaf
+        unsigned lowerBound(const void* page, const Attribute &attribute, const void *key)const;   //first entry with a key not less than key
+        unsigned upperBound(const void* page, const Attribute &attribute, const void *key)const;   //first entry with a key greater than key
+        unsigned findPointerEntry(const void* page, const KeySearch &keySearch, const void *key, bool leftmost)const;  //child to descend into
+
+        //the key handling above, instantiated for each key type
+        static const KeySearch &getKeySearch(AttrType type);
+        template<class Key> static unsigned lowerBoundOf(const void *page, const void *key);
+        template<class Key> static unsigned upperBoundOf(const void *page, const void *key);
+
+        //leaf key prefixes. Leaf entries are passed around with their whole key while a leaf is rebuilt
+        static unsigned getLeafPrefix(const void *page, const unsigned char *&prefix);
+        static unsigned searchLeaf(const KeySearch &keySearch, const void *page, const void *key, bool upper);
+        static int compareLeafKey(const KeySearch &keySearch, const void *page, unsigned entryNum, const void *key);
+        static void getLeafKey(const KeySearch &keySearch, const void *page, unsigned entryNum, void *nodeKey);
+        static bool toLeafEntry(const void *page, void *entry, unsigned &entrySize);   //false if the key doesn't start with the prefix
+        static unsigned fromLeafEntry(const void *page, void *entry, unsigned entrySize);
+        void getLeafEntries(const Attribute &attribute, const void *page, vector<string> &entries)const;   //appended with their whole keys
+        unsigned getCommonPrefix(const Attribute &attribute, const void *nodeKey, const void *otherKey)const;
+        unsigned getLeafSpace(unsigned entryNumber, unsigned entriesSize, unsigned prefixLength)const;
+        unsigned getLeafSpace(const Attribute &attribute, const vector<string> &entries, unsigned first, unsigned last)const;
+        void writeLeaf(const Attribute &attribute, void *page, const vector<string> &entries, unsigned first, unsigned last);
+        unsigned splitLeafEntries(const Attribute &attribute, const vector<string> &entries, float leftFill)const;
+        unsigned getSeparator(const Attribute &attribute, const void *leftKey, const void *rightKey, void *separator)const;
+
+        //posting lists
+        static bool ridLess(const RID &a, const RID &b);
+        unsigned writeVarint(char *out, uint32_t value)const;
+        uint32_t readVarint(const char *in, unsigned &offset)const;
+        unsigned encodeRid(const RID &rid, const RID &previous, char *out)const;
+        unsigned encodedRidSize(const RID &rid, const RID &previous)const;
+        unsigned encodedRidsSize(const RID *rids, unsigned ridNumber)const;
+        unsigned encodeRids(const RID *rids, unsigned ridNumber, char *out)const;
+        void decodeRids(const char *in, unsigned length, vector<RID> &rids)const;
+        RC makePostingEntry(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const vector<RID> &rids,
+                void *entry, unsigned &entrySize);
+        RC writePostingPages(IXFileHandle &ixfileHandle, const vector<RID> &rids, OverflowPosting &overflow);
+        RC readPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+                const RID *after, vector<RID> &rids, bool &complete)const;
+        RC insertIntoPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+                const RID &rid, void *entry, unsigned &entrySize);
+        RC insertIntoPostingPages(IXFileHandle &ixfileHandle, OverflowPosting &overflow, const RID &rid);
+        RC removeFromPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+                const RID &rid, void *entry, unsigned &entrySize, bool &found);
+        RC removeFromPostingPages(IXFileHandle &ixfileHandle, OverflowPosting &overflow, const RID &rid, bool &found);
+        unsigned getPostingSize(const Attribute &attribute, const void *page, unsigned entryNum)const;     //RIDs in the list
+        RC readPostingRid(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *page, unsigned entryNum,
+                unsigned ridNum, RID &rid)const;
+
+        //subtree counts
+        SubtreeCount countNode(const Attribute &attribute, const void *page)const;
+        void addToPathCounts(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<NodePathEntry> &path, int delta);
+        RC countBelow(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, bool inclusive, uint64_t &count);
+        bool getKeySuccessor(const Attribute &attribute, const void *nodeKey, void *successor)const;
+        RC countNodeKeyRange(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *lowKey, const void *highKey,
+                bool lowKeyInclusive, bool highKeyInclusive, uint64_t &count);
+
+        //finds the leaf for key and the internal nodes passed on the way. leftmost selects the first
+        //leaf that may hold key rather than the one a new entry for key is inserted into. A NULL
+        //key finds the leftmost leaf. The leaf is returned pinned and latched as mode says; path
+        //holds the nodes still latched, and rootLatched whether the root latch is still held. For
+        //IX_TRAVERSE_INSERT, splitLevel is the level a split may reach, counted from 1 at the leaves
+        RC traverse(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *key, bool leftmost,
+                TraverseMode mode, PageNum &leafPageNum, void *&leafData, vector<NodePathEntry> &path, bool &rootLatched,
+                unsigned splitLevel = 0);
+        RC fetchNode(IXFileHandle &ixfileHandle, PageNum pageNum, void *&pageData, bool exclusive);     //pin and latch
+        void releaseNode(IXFileHandle &ixfileHandle, PageNum pageNum, bool dirty);
+        void releasePath(IXFileHandle &ixfileHandle, const vector<NodePathEntry> &path, bool rootLatched);
+        unsigned getSplitLevel(IXFileHandle &ixfileHandle, const vector<NodePathEntry> &path);     //where a split on path stops
+        RC getCachedNode(IXFileHandle &ixfileHandle, PageNum pageNum, const void *&nodeData);     //copy of an upper node
+        void dropCachedNode(IXFileHandle &ixfileHandle, PageNum pageNum);
+        void clearNodeCache(IXFileHandle &ixfileHandle);
+
+        unsigned getPaddedKeySize(const Attribute &attribute, const void *nodeKey)const;     //key of an internal entry
+        unsigned getInternalEntrySize(const Attribute &attribute, const void *nodeKey)const;
+        unsigned makeInternalEntry(void *entry, const Attribute &attribute, const void *nodeKey, PageNum child, SubtreeCount count)const;
+        void setEntryAtOffset(void* page, unsigned entryNum, const void *entry, unsigned entrySize);   //inserts the entry as entry entryNum, the caller checks for space
+        void appendEntry(void* page, const void *entry, unsigned entrySize);
+        void removeEntryAt(void* page, const Attribute &attribute, unsigned entryNum);
+        unsigned getNodeUsedSpace(const void* page)const;
+        bool isUnderfull(const void* page)const;
+
+        RC allocateNode(IXFileHandle &ixfileHandle, const void *page, PageNum &pageNum);     //reuses a free page if there is one
+        RC freeNode(IXFileHandle &ixfileHandle, PageNum pageNum);
+
+        bool fitsInNode(const void* page, unsigned entrySize, float fillFactor)const;
+        void sortEntries(const Attribute &attribute, const vector<char> &nodeKeys, const vector<unsigned> &keyOffsets,
+                const vector<RID> &rids, vector<unsigned> &order)const;
+        RC buildTree(IXFileHandle &ixfileHandle, const Attribute &attribute, PageNum firstLeaf, const vector<char> &nodeKeys,
+                const vector<unsigned> &keyOffsets, const vector<RID> &rids, const vector<unsigned> &order, float fillFactor,
+                PageNum &rootPage, uint32_t &height, uint32_t &leafNumber);
+        RC writeBuiltLeaf(IXFileHandle &ixfileHandle, void *page, PageNum firstLeaf, vector<PageNum> &leaves);
+        RC buildInternalLevel(IXFileHandle &ixfileHandle, const Attribute &attribute, float fillFactor,
+                vector<PageNum> &children, vector<SubtreeCount> &counts, vector<string> &separators);
+
+        RC splitPage(IXFileHandle &ixfileHandle, const Attribute &attribute, void* page, PageNum pageNum,
+                vector<NodePathEntry> &path, unsigned entryNum, const void *entry, unsigned entrySize, bool appending);
+        RC insertInParent(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path,
+                const void *nodeKey, PageNum left, SubtreeCount leftCount, PageNum right, SubtreeCount rightCount,
+                bool appending);
+
+        //deletion
+        RC nextLeafOnPath(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path, PageNum &leafPageNum);
+        RC rebalanceLeaf(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, PageNum leafPageNum);
+        bool deferRebalance(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, PageNum leafPageNum);
+        void endScan(IXFileHandle &ixfileHandle);      //rebalances the deferred leaves after the last scan
+        RC rebalance(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path, PageNum pageNum);
+        void mergeNodes(const Attribute &attribute, void *left, void *right, const void *separator);
+        void redistribute(const Attribute &attribute, void *left, void *right, bool toLeft, char *separator);
+        RC replaceSeparator(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<NodePathEntry> &path,
+                void *parentPage, PageNum parentPageNum, unsigned entryNum, const void *nodeKey);
+
+        //hash indexes. A bucket is latched like a leaf, through the latch of its first page, which
+        //covers its overflow pages. The root latch guards the directory: lookups hold it shared
+        //until their bucket is latched, and splits hold it exclusive
+        bool isHashIndex(IXFileHandle &ixfileHandle)const;
+        static uint32_t hashKey(const Attribute &attribute, const void *nodeKey);
+        void newBucketPage(void *page, uint32_t localDepth);     //an empty bucket, or overflow page
+        BucketHeader getBucketHeader(const void *page)const;
+        void setBucketHeader(void *page, const BucketHeader &bucketHeader);
+        RC getDirectoryEntry(IXFileHandle &ixfileHandle, unsigned dirIndex, PageNum &bucketPage)const;
+        RC setDirectoryEntry(IXFileHandle &ixfileHandle, unsigned dirIndex, PageNum bucketPage);
+        RC doubleDirectory(IXFileHandle &ixfileHandle);
+        RC fetchBucket(IXFileHandle &ixfileHandle, uint32_t hash, bool exclusive, unsigned &dirIndex, PageNum &bucketPage,
+                void *&bucketData);      //pin and latch the bucket of hash
+        RC fetchChain(IXFileHandle &ixfileHandle, PageNum bucketPage, void *bucketData, vector<PageNum> &pages,
+                vector<void*> &pageData);    //pins the overflow pages, pages[0] is the bucket
+        void releaseChain(IXFileHandle &ixfileHandle, const vector<PageNum> &pages, bool dirty);
+        bool findInChain(const Attribute &attribute, const vector<void*> &pageData, const void *nodeKey, unsigned &pageIndex,
+                unsigned &entryNum)const;
+        RC placeInChain(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<PageNum> &pages, vector<void*> &pageData,
+                const void *entry, unsigned entrySize, bool &full);
+        RC insertHashKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid);
+        RC deleteHashKey(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID &rid);
+        RC splitBucket(IXFileHandle &ixfileHandle, const Attribute &attribute, uint32_t hash, PageNum bucketPage,
+                uint32_t localDepth);
+        RC writeBucket(IXFileHandle &ixfileHandle, const Attribute &attribute, vector<PageNum> &pages, uint32_t localDepth,
+                const vector<string> &entries);
+        RC readHashPosting(IXFileHandle &ixfileHandle, const Attribute &attribute, const void *nodeKey, const RID *after,
+                vector<RID> &rids, bool &complete);
+        RC readHashBucket(IXFileHandle &ixfileHandle, const Attribute &attribute, uint64_t &position, vector<string> &keys);
+        void printBuckets(IXFileHandle &ixfileHandle, const Attribute &attribute)const;
+
+        void printKey(const Attribute &attribute, const void *nodeKey)const;
+        void printRecursively(IXFileHandle &ixfileHandle, const Attribute &attribute, PageNum pageNum, unsigned tabs)const;
     
 };
 
@@ -145,13 +601,56 @@ class IX_ScanIterator {
         friend class IndexManager;
     private:
         IndexManager *_ix_manager;
-        int currentPage;
-        unsigned currentEntry;
-        unsigned maxPage;
-        unsigned maxEntry;
         IXFileHandle *ixfileHandle;
         Attribute attribute;
+        vector<Attribute> keyFields;    // Attributes of a composite key, empty otherwise
+        const KeySearch *keySearch;
+
+        // Bounds in the node key format
+        char lowKey[IX_MAX_KEY_SIZE];
+        char highKey[IX_MAX_KEY_SIZE];
+        bool hasLowKey;
+        bool hasHighKey;
+        bool lowKeyInclusive;
+        bool highKeyInclusive;
+
+        // The current leaf stays pinned while its entries are returned, and is latched shared
+        // inside getNextEntry
+        PageNum currentPage;
+        void *pageData;
+
+        // Last entry returned, to find our place again if the leaf changed under us
+        char lastKey[IX_MAX_KEY_SIZE];
+        RID lastRid;
+        bool returnedEntry;
+        unsigned lastEntry;     // Where lastKey was, checked before searching the leaf for it
+        bool lastComplete;      // No RIDs of lastKey come after the buffered ones
+
+        // RIDs of lastKey not returned yet, copied out of its posting list
+        vector<RID> rids;
+        unsigned nextRid;
+
+        // A scan of a hash index goes through the keys of one bucket at a time, and looks each key
+        // up again for every page of its RIDs. Buckets are taken in the order of their hash values
+        // with the bits reversed, which splits only divide further, so each is read once however
+        // the directory grows meanwhile
+        bool hashScan;
+        vector<string> hashKeys;    // Keys of the current bucket within the bounds
+        unsigned nextKey;
+        uint64_t hashPosition;      // Where the next bucket starts in that order, 2^32 at the end
+
         bool closed;
+        bool active;        // Counted in ixfileHandle->openScans and ixfileHandle->index->openScans
+
+        // Takes the bounds in the node key format. wholeKeys says they cover every field of the key
+        RC scanInit(IXFileHandle &fh, const Attribute &attr, const vector<Attribute> &fields, const void *low,
+                const void *high, bool lowInclusive, bool highInclusive, bool wholeKeys);
+        void copyKey(void *key);
+        void release();
+        RC nextEntry(RID &rid, void *key);
+        RC nextLeaf(bool &atEnd);
+        RC nextHashEntry(RID &rid, void *key);
+        bool inBounds(const void *nodeKey)const;
 };
 
 
@@ -164,7 +663,6 @@ class IXFileHandle {
     unsigned ixWritePageCounter;
     unsigned ixAppendPageCounter;
     
-    int rootPage;
     // Constructor
     IXFileHandle();
 
@@ -180,6 +678,14 @@ class IXFileHandle {
 
     FileHandle fileHandle;
 
+    // Shared with the other handles open on the index. A handle that is not open points at an
+    // IndexFile whose metadata is all zeros, which every operation turns down.
+    IndexFile *index;
+
+    // Scans through this handle counted in index->openScans. Each keeps a leaf pinned through
+    // fileHandle, so closeFile turns the handle down until they are closed.
+    unsigned openScans;
+
 };
 
 #endif
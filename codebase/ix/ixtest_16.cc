@@ -0,0 +1,176 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+int testCase_16(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks whether an index larger than 32767 pages keeps its sibling and child links.
+    // Older node headers stored page numbers in 16 bits and silently wrapped past that size.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Bulk load entries into sparse leaves so the file grows past 32767 pages **
+    // 4. Insert entries that split leaves at the end of the file
+    // 5. Scan all entries and a range at the end of the file
+    // 6. Close Index File
+    // 7. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 16 *****" << endl;
+
+    RID rid;
+    IXFileHandle ixfileHandle;
+    IX_ScanIterator ix_ScanIterator;
+    unsigned numOfTuples = 500000;
+    unsigned numOfMoreTuples = 20000;
+    float fillFactor = 0.04;        // about 13 int entries per leaf
+    unsigned readPageCount = 0;
+    unsigned writePageCount = 0;
+    unsigned appendPageCount = 0;
+    int key;
+
+    // create index file
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+
+    // open index file
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // bulk load even keys
+    vector<int> keyValues(numOfTuples);
+    vector<const void*> keys(numOfTuples);
+    vector<RID> rids(numOfTuples);
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        keyValues[i] = 2 * i;
+        keys[i] = &keyValues[i];
+        rids[i].pageNum = 2 * i;
+        rids[i].slotNum = i % 100;
+    }
+    rc = indexManager->bulkLoad(ixfileHandle, attribute, keys, rids, fillFactor);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+
+    rc = ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    cerr << "Pages appended by the bulk load: " << appendPageCount << endl;
+    if (appendPageCount <= 32767)
+    {
+        cerr << "The index should have grown past 32767 pages. The test failed." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // insert odd keys at the end of the key range, splitting leaves past the old limit
+    for(unsigned i = numOfTuples - numOfMoreTuples; i < numOfTuples; i++)
+    {
+        key = 2 * i + 1;
+        rid.pageNum = key;
+        rid.slotNum = i % 100;
+
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    // reopen so every link is read back from disk
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // scan everything: keys must come back in order and none may be lost
+    rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    unsigned count = 0;
+    int previous = -1;
+    while(ix_ScanIterator.getNextEntry(rid, &key) == success)
+    {
+        if (key <= previous || rid.pageNum != (unsigned) key)
+        {
+            cerr << "Wrong entry returned: " << key << " after " << previous << " --- The test failed." << endl;
+            ix_ScanIterator.close();
+            indexManager->closeFile(ixfileHandle);
+            indexManager->destroyFile(indexFileName);
+            return fail;
+        }
+        previous = key;
+        count++;
+    }
+    rc = ix_ScanIterator.close();
+    assert(rc == success && "IX_ScanIterator::close() should not fail.");
+
+    if (count != numOfTuples + numOfMoreTuples)
+    {
+        cerr << "Wrong entries output... The test failed." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // scan a range that lives in leaves beyond page 32767
+    int lowKey = 2 * (numOfTuples - numOfMoreTuples);
+    int highKey = lowKey + 999;
+    rc = indexManager->scan(ixfileHandle, attribute, &lowKey, &highKey, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    count = 0;
+    while(ix_ScanIterator.getNextEntry(rid, &key) == success)
+    {
+        assert(key >= lowKey && key <= highKey && "the returned key is out of range.");
+        count++;
+    }
+    rc = ix_ScanIterator.close();
+    assert(rc == success && "IX_ScanIterator::close() should not fail.");
+
+    if (count != 1000)
+    {
+        cerr << "Wrong entries output... The test failed." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // Close Index
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Destroy Index
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    return success;
+
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "large_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    remove("large_idx");
+
+    RC result = testCase_16(indexFileName, attrAge);
+    if (result == success) {
+        cerr << "***** IX Test Case 16 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 16 failed. *****" << endl;
+        return fail;
+    }
+
+}
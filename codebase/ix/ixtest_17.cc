@@ -0,0 +1,194 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+int testCase_17(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks whether deletes shrink the tree and whether the pages they free are used again.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Insert entries
+    // 4. Delete most of them so leaves and internal nodes merge, also while a scan is open **
+    // 5. Scan the remaining entries
+    // 6. Insert the deleted entries again without growing the file **
+    // 7. Close Index File
+    // 8. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 17 *****" << endl;
+
+    RID rid;
+    IXFileHandle ixfileHandle;
+    IX_ScanIterator ix_ScanIterator;
+    unsigned numOfTuples = 100000;
+    unsigned readPageCount = 0;
+    unsigned writePageCount = 0;
+    unsigned appendPageCount = 0;
+    unsigned insertAppendCount = 0;
+    int key;
+
+    // create index file
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+
+    // open index file
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // insert entries
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        key = i;
+        rid.pageNum = i;
+        rid.slotNum = i % 100;
+
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    rc = ixfileHandle.collectCounterValues(readPageCount, writePageCount, insertAppendCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+
+    // delete all but every 100th entry, the second half while a scan is open. The leaves it
+    // leaves underfull are merged when the scan is closed
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        if (i == numOfTuples / 2)
+        {
+            rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+            assert(rc == success && "indexManager::scan() should not fail.");
+            rc = ix_ScanIterator.getNextEntry(rid, &key);
+            assert(rc == success && "IX_ScanIterator::getNextEntry() should not fail.");
+        }
+        if (i % 100 == 0)
+            continue;
+        key = i;
+        rid.pageNum = i;
+        rid.slotNum = i % 100;
+
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+
+    // the file stays open while the scan holds its leaf
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc != success && "indexManager::closeFile() should fail while a scan is open.");
+    rc = ix_ScanIterator.close();
+    assert(rc == success && "IX_ScanIterator::close() should not fail.");
+
+    // reopen so the tree is read back from disk
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    unsigned scanReadCount;
+    rc = ixfileHandle.collectCounterValues(scanReadCount, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    unsigned count = 0;
+    while(ix_ScanIterator.getNextEntry(rid, &key) == success)
+    {
+        if (key != (int) (count * 100) || rid.pageNum != (unsigned) key)
+        {
+            cerr << "Wrong entry returned: " << key << " --- The test failed." << endl;
+            ix_ScanIterator.close();
+            indexManager->closeFile(ixfileHandle);
+            indexManager->destroyFile(indexFileName);
+            return fail;
+        }
+        count++;
+    }
+    rc = ix_ScanIterator.close();
+    assert(rc == success && "IX_ScanIterator::close() should not fail.");
+
+    if (count != numOfTuples / 100)
+    {
+        cerr << "Wrong entries output... The test failed." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // the remaining entries fit in a few leaves
+    rc = ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    cerr << "Pages read by the scan: " << readPageCount - scanReadCount << endl;
+    if (readPageCount - scanReadCount > insertAppendCount / 10)
+    {
+        cerr << "Underfull leaves were not merged... The test failed." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // the emptied nodes were merged away, so inserting the entries again should reuse them
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        if (i % 100 == 0)
+            continue;
+        key = i;
+        rid.pageNum = i;
+        rid.slotNum = i % 100;
+
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    rc = ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    appendPageCount -= insertAppendCount;     // the counters keep running across reopens
+    cerr << "Pages appended by the first inserts: " << insertAppendCount << ", by inserting again: "
+         << appendPageCount << endl;
+    if (appendPageCount > insertAppendCount / 10)
+    {
+        cerr << "Freed pages were not reused... The test failed." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // Close Index
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Destroy Index
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    return success;
+
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "shrink_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    remove("shrink_idx");
+
+    RC result = testCase_17(indexFileName, attrAge);
+    if (result == success) {
+        cerr << "***** IX Test Case 17 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 17 failed. *****" << endl;
+        return fail;
+    }
+
+}
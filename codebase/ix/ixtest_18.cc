@@ -0,0 +1,168 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <chrono>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// Entries each run inserts, split evenly between its threads
+const unsigned numOfTuples = 40000;
+
+// Each thread inserts every threadCount-th key starting at its own number, looks each one up
+// after inserting it, and finally deletes the odd keys among its own. The keys of different
+// threads interleave, so they keep running into the same leaves.
+void worker(IXFileHandle *ixfileHandle, const Attribute *attribute, unsigned threadNum, unsigned threadCount,
+        unsigned *errors)
+{
+    RID rid;
+    int key;
+    for(unsigned i = threadNum; i < numOfTuples; i += threadCount)
+    {
+        key = i;
+        rid.pageNum = i;
+        rid.slotNum = i % 100;
+        if (indexManager->insertEntry(*ixfileHandle, *attribute, &key, rid) != success)
+            (*errors)++;
+
+        IX_ScanIterator ix_ScanIterator;
+        if (indexManager->scan(*ixfileHandle, *attribute, &key, &key, true, true, ix_ScanIterator) != success)
+        {
+            (*errors)++;
+            continue;
+        }
+        int foundKey;
+        RID foundRid;
+        if (ix_ScanIterator.getNextEntry(foundRid, &foundKey) != success || foundKey != key ||
+                foundRid.pageNum != i)
+            (*errors)++;
+        ix_ScanIterator.close();
+    }
+
+    for(unsigned i = threadNum; i < numOfTuples; i += threadCount)
+    {
+        if (i % 2 == 0)
+            continue;
+        key = i;
+        rid.pageNum = i;
+        rid.slotNum = i % 100;
+        if (indexManager->deleteEntry(*ixfileHandle, *attribute, &key, rid) != success)
+            (*errors)++;
+    }
+}
+
+int runThreads(const string &indexFileName, const Attribute &attribute, unsigned threadCount)
+{
+    IXFileHandle ixfileHandle;
+    IX_ScanIterator ix_ScanIterator;
+    RID rid;
+    int key;
+
+    // create index file
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+
+    // open index file
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    vector<thread> threads;
+    vector<unsigned> errors(threadCount, 0);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for(unsigned t = 0; t < threadCount; t++)
+        threads.push_back(thread(worker, &ixfileHandle, &attribute, t, threadCount, &errors[t]));
+    for(unsigned t = 0; t < threadCount; t++)
+        threads[t].join();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    unsigned errorCount = 0;
+    for(unsigned t = 0; t < threadCount; t++)
+        errorCount += errors[t];
+    cerr << threadCount << " thread(s): " << (unsigned) (numOfTuples * 2.5 / seconds)
+         << " operations/s, " << errorCount << " failed" << endl;
+
+    // only the even keys are left, in order
+    rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    unsigned count = 0;
+    while(ix_ScanIterator.getNextEntry(rid, &key) == success)
+    {
+        if (key != (int) (count * 2) || rid.pageNum != (unsigned) key)
+        {
+            cerr << "Wrong entry returned: " << key << " --- The test failed." << endl;
+            errorCount++;
+            break;
+        }
+        count++;
+    }
+    rc = ix_ScanIterator.close();
+    assert(rc == success && "IX_ScanIterator::close() should not fail.");
+    if (count != numOfTuples / 2)
+    {
+        cerr << "Wrong number of entries: " << count << " --- The test failed." << endl;
+        errorCount++;
+    }
+
+    // Close Index
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Destroy Index
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    return errorCount == 0 ? success : fail;
+}
+
+int testCase_18(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks that several threads can use one index at the same time.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Insert entries and look them up from several threads **
+    // 4. Delete entries from several threads **
+    // 5. Scan the remaining entries
+    // 6. Close Index File
+    // 7. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 18 *****" << endl;
+
+    unsigned threadCounts[] = {1, 2, 4, 8};
+    for(unsigned i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]); i++)
+    {
+        if (runThreads(indexFileName, attribute, threadCounts[i]) != success)
+            return fail;
+    }
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "threads_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    remove("threads_idx");
+
+    RC result = testCase_18(indexFileName, attrAge);
+    if (result == success) {
+        cerr << "***** IX Test Case 18 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 18 failed. *****" << endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,200 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+const unsigned numOfKeys = 10;
+const unsigned numOfTuples = 100000;
+const unsigned slotsPerPage = 50;
+
+// Scans the whole index and checks that every key has its expected number of RIDs, returned in
+// RID order, and that none of them was deleted (only RIDs numbered by a multiple of 3 are)
+int checkEntries(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<unsigned> &expected, bool deleted)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RID rid;
+    int key;
+    RC rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    int lastKey = -1;
+    unsigned lastValue = 0;
+    unsigned count = 0;
+    while(ix_ScanIterator.getNextEntry(rid, &key) == success)
+    {
+        unsigned value = rid.pageNum * slotsPerPage + rid.slotNum;
+        if (key != lastKey)
+        {
+            if (key != lastKey + 1 || (lastKey >= 0 && count != expected[lastKey]))
+            {
+                cerr << "Wrong number of entries before key " << key << " --- The test failed." << endl;
+                ix_ScanIterator.close();
+                return fail;
+            }
+            lastKey = key;
+            count = 0;
+        }
+        else if (value <= lastValue)
+        {
+            cerr << "RIDs of key " << key << " out of order --- The test failed." << endl;
+            ix_ScanIterator.close();
+            return fail;
+        }
+        if (deleted && value % 3 == 0)
+        {
+            cerr << "Deleted entry returned: " << key << " --- The test failed." << endl;
+            ix_ScanIterator.close();
+            return fail;
+        }
+        lastValue = value;
+        count++;
+    }
+    rc = ix_ScanIterator.close();
+    assert(rc == success && "IX_ScanIterator::close() should not fail.");
+
+    if (lastKey != (int) numOfKeys - 1 || count != expected[lastKey])
+    {
+        cerr << "Wrong number of entries for the last key --- The test failed." << endl;
+        return fail;
+    }
+    return success;
+}
+
+int testCase_19(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks whether duplicate keys share a posting list instead of an entry each.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Insert many RIDs for each of a few keys, in and out of RID order **
+    // 4. Scan all entries
+    // 5. Delete a third of them and scan again after reopening **
+    // 6. Close Index File
+    // 7. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 19 *****" << endl;
+
+    RID rid;
+    IXFileHandle ixfileHandle;
+    unsigned readPageCount = 0;
+    unsigned writePageCount = 0;
+    unsigned appendPageCount = 0;
+    int key;
+
+    // create index file
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+
+    // open index file
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // even keys get their RIDs in ascending order, odd keys in descending order
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        key = i % numOfKeys;
+        unsigned value = key % 2 == 0 ? i : numOfTuples - 1 - i;
+        rid.pageNum = value / slotsPerPage;
+        rid.slotNum = value % slotsPerPage;
+
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    // an entry per RID would take about 14 bytes, so the posting lists should take far fewer pages
+    rc = ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    cerr << "Pages appended for " << numOfTuples << " entries: " << appendPageCount << endl;
+    if (appendPageCount > numOfTuples * 14 / PAGE_SIZE / 2)
+    {
+        cerr << "Duplicate keys take too much space... The test failed." << endl;
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    vector<unsigned> expected(numOfKeys, numOfTuples / numOfKeys);
+    if (checkEntries(ixfileHandle, attribute, expected, false) != success)
+    {
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // delete every RID numbered by a multiple of 3
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        key = i % numOfKeys;
+        unsigned value = key % 2 == 0 ? i : numOfTuples - 1 - i;
+        if (value % 3 != 0)
+            continue;
+        expected[key]--;
+        rid.pageNum = value / slotsPerPage;
+        rid.slotNum = value % slotsPerPage;
+
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, &key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+
+    // deleting one of them again should fail
+    key = 0;
+    rid.pageNum = 0;
+    rid.slotNum = 0;
+    rc = indexManager->deleteEntry(ixfileHandle, attribute, &key, rid);
+    assert(rc != success && "Deleting an entry twice should fail.");
+
+    // reopen so the tree is read back from disk
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    if (checkEntries(ixfileHandle, attribute, expected, true) != success)
+    {
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        return fail;
+    }
+
+    // Close Index
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    // Destroy Index
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    return success;
+
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "duplicates_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    remove("duplicates_idx");
+
+    RC result = testCase_19(indexFileName, attrAge);
+    if (result == success) {
+        cerr << "***** IX Test Case 19 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 19 failed. *****" << endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,258 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cfloat>
+#include <climits>
+#include <algorithm>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// Inserts keys in the given order, then checks that a full scan returns them sorted and that a
+// range scan between two of them returns exactly the keys in between
+template<class T>
+int checkOrder(const string &indexFileName, const Attribute &attribute, const vector<T> &values,
+        void (*toKey)(const T &value, void *key), void (*fromKey)(const void *key, T &value))
+{
+    IXFileHandle ixfileHandle;
+    IX_ScanIterator ix_ScanIterator;
+    RID rid;
+    char key[PAGE_SIZE];
+
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    for(unsigned i = 0; i < values.size(); i++)
+    {
+        toKey(values[i], key);
+        rid.pageNum = i;
+        rid.slotNum = 0;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    vector<T> sorted(values);
+    sort(sorted.begin(), sorted.end());
+
+    int result = success;
+    rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    unsigned count = 0;
+    while(ix_ScanIterator.getNextEntry(rid, key) == success)
+    {
+        T value;
+        fromKey(key, value);
+        if (count >= sorted.size() || !(value == sorted[count]) || !(values[rid.pageNum] == value))
+        {
+            cerr << "Entry " << count << " returned out of order --- The test failed." << endl;
+            result = fail;
+            break;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    if (result == success && count != sorted.size())
+    {
+        cerr << "Wrong number of entries: " << count << " --- The test failed." << endl;
+        result = fail;
+    }
+
+    // keys strictly between the second and the second to last
+    char lowKey[PAGE_SIZE];
+    char highKey[PAGE_SIZE];
+    toKey(sorted[1], lowKey);
+    toKey(sorted[sorted.size() - 2], highKey);
+    rc = indexManager->scan(ixfileHandle, attribute, lowKey, highKey, false, false, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    count = 0;
+    while(result == success && ix_ScanIterator.getNextEntry(rid, key) == success)
+    {
+        T value;
+        fromKey(key, value);
+        if (!(value == sorted[count + 2]))
+        {
+            cerr << "Range scan returned the wrong entry --- The test failed." << endl;
+            result = fail;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    if (result == success && count != sorted.size() - 4)
+    {
+        cerr << "Range scan returned " << count << " entries --- The test failed." << endl;
+        result = fail;
+    }
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return result;
+}
+
+void intToKey(const int &value, void *key)
+{
+    memcpy(key, &value, sizeof(int));
+}
+
+void intFromKey(const void *key, int &value)
+{
+    memcpy(&value, key, sizeof(int));
+}
+
+void realToKey(const float &value, void *key)
+{
+    memcpy(key, &value, sizeof(float));
+}
+
+void realFromKey(const void *key, float &value)
+{
+    memcpy(&value, key, sizeof(float));
+}
+
+void varCharToKey(const string &value, void *key)
+{
+    int length = value.size();
+    memcpy(key, &length, sizeof(int));
+    memcpy((char*)key + sizeof(int), value.data(), length);
+}
+
+void varCharFromKey(const void *key, string &value)
+{
+    int length;
+    memcpy(&length, key, sizeof(int));
+    value.assign((const char*)key + sizeof(int), length);
+}
+
+int testCase_20(const string &indexFileName)
+{
+    // Checks whether keys of every type come back in order now that nodes compare them bytewise.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Insert Int, Real and VarChar keys around the edges of their encodings **
+    // 4. Scan all entries and a range **
+    // 5. Close Index File
+    // 6. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 20 *****" << endl;
+
+    Attribute attribute;
+    attribute.name = "key";
+
+    // negative and positive numbers, both ends of the range and a few thousand in between
+    vector<int> ints;
+    ints.push_back(INT_MIN);
+    ints.push_back(INT_MAX);
+    ints.push_back(-1);
+    ints.push_back(0);
+    ints.push_back(1);
+    for(int i = 0; i < 3000; i++)
+        ints.push_back((int) ((i * 2654435761u) % 2000000) - 1000000);
+    sort(ints.begin(), ints.end());
+    ints.erase(unique(ints.begin(), ints.end()), ints.end());
+    random_shuffle(ints.begin(), ints.end());
+    attribute.type = TypeInt;
+    attribute.length = 4;
+    if (checkOrder(indexFileName, attribute, ints, intToKey, intFromKey) != success)
+        return fail;
+
+    vector<float> reals;
+    reals.push_back(-FLT_MAX);
+    reals.push_back(FLT_MAX);
+    reals.push_back(-FLT_MIN);
+    reals.push_back(FLT_MIN);
+    reals.push_back(0.0f);
+    for(int i = 0; i < 3000; i++)
+        reals.push_back(((int) ((i * 2654435761u) % 2000000) - 1000000) / 37.0f);
+    sort(reals.begin(), reals.end());
+    reals.erase(unique(reals.begin(), reals.end()), reals.end());
+    random_shuffle(reals.begin(), reals.end());
+    attribute.type = TypeReal;
+    if (checkOrder(indexFileName, attribute, reals, realToKey, realFromKey) != success)
+        return fail;
+
+    // -0.0 is the same key as 0.0
+    {
+        IXFileHandle ixfileHandle;
+        IX_ScanIterator ix_ScanIterator;
+        RID rid = {1, 1};
+        float zero = 0.0f;
+        float negativeZero = -0.0f;
+        RC rc = indexManager->createFile(indexFileName);
+        assert(rc == success && "indexManager::createFile() should not fail.");
+        rc = indexManager->openFile(indexFileName, ixfileHandle);
+        assert(rc == success && "indexManager::openFile() should not fail.");
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &negativeZero, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+        rc = indexManager->scan(ixfileHandle, attribute, &zero, &zero, true, true, ix_ScanIterator);
+        assert(rc == success && "indexManager::scan() should not fail.");
+        float found;
+        bool matched = ix_ScanIterator.getNextEntry(rid, &found) == success;
+        ix_ScanIterator.close();
+        indexManager->closeFile(ixfileHandle);
+        indexManager->destroyFile(indexFileName);
+        if (!matched)
+        {
+            cerr << "-0.0 was not found as 0.0 --- The test failed." << endl;
+            return fail;
+        }
+    }
+
+    // prefixes of each other, embedded and trailing NULs and bytes above 0x7F
+    vector<string> strings;
+    strings.push_back("");
+    strings.push_back(string(1, '\0'));
+    strings.push_back(string(2, '\0'));
+    strings.push_back(string("a\0", 2));
+    strings.push_back(string("a\0b", 3));
+    strings.push_back(string("a\xff", 2));
+    strings.push_back("a");
+    strings.push_back("ab");
+    strings.push_back("b");
+    strings.push_back("\x7f");
+    strings.push_back("\x80");
+    strings.push_back("\xff\xff");
+    for(int i = 0; i < 3000; i++)
+    {
+        char buffer[32];
+        sprintf(buffer, "key%u", (unsigned) ((i * 2654435761u) % 100000));
+        strings.push_back(buffer);
+    }
+    sort(strings.begin(), strings.end());
+    strings.erase(unique(strings.begin(), strings.end()), strings.end());
+    random_shuffle(strings.begin(), strings.end());
+    attribute.type = TypeVarChar;
+    attribute.length = 32;
+    if (checkOrder(indexFileName, attribute, strings, varCharToKey, varCharFromKey) != success)
+        return fail;
+
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "order_idx";
+
+    remove("order_idx");
+
+    RC result = testCase_20(indexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 20 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 20 failed. *****" << endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,312 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// An entry of a composite index over (region:int, city:varchar, score:real), city may be null
+typedef struct Row
+{
+    int region;
+    bool cityNull;
+    string city;
+    float score;
+    RID rid;
+} Row;
+
+// Compares the first fields of two rows the way the index orders keys: null before any city,
+// cities bytewise with a prefix first
+int compareFields(const Row &a, const Row &b, unsigned fields)
+{
+    if (a.region != b.region)
+        return a.region < b.region ? -1 : 1;
+    if (fields == 1)
+        return 0;
+    if (a.cityNull != b.cityNull)
+        return a.cityNull ? -1 : 1;
+    if (!a.cityNull && a.city != b.city)
+        return a.city < b.city ? -1 : 1;
+    if (fields == 2)
+        return 0;
+    if (a.score != b.score)
+        return a.score < b.score ? -1 : 1;
+    return 0;
+}
+
+bool rowLess(const Row &a, const Row &b)
+{
+    int result = compareFields(a, b, 3);
+    if (result != 0)
+        return result < 0;
+    if (a.rid.pageNum != b.rid.pageNum)
+        return a.rid.pageNum < b.rid.pageNum;
+    return a.rid.slotNum < b.rid.slotNum;
+}
+
+// A key tuple over the first fields of a row
+void toKey(const Row &row, unsigned fields, void *key)
+{
+    unsigned char nulls = 0;
+    unsigned offset = 1;
+    memcpy((char*)key + offset, &row.region, sizeof(int));
+    offset += sizeof(int);
+    if (fields > 1 && row.cityNull)
+        nulls |= 0x40;
+    else if (fields > 1)
+    {
+        int length = row.city.size();
+        memcpy((char*)key + offset, &length, sizeof(int));
+        memcpy((char*)key + offset + sizeof(int), row.city.data(), length);
+        offset += sizeof(int) + length;
+    }
+    if (fields > 2)
+        memcpy((char*)key + offset, &row.score, sizeof(float));
+    memcpy(key, &nulls, 1);
+}
+
+void fromKey(const void *key, Row &row)
+{
+    unsigned char nulls;
+    memcpy(&nulls, key, 1);
+    unsigned offset = 1;
+    memcpy(&row.region, (const char*)key + offset, sizeof(int));
+    offset += sizeof(int);
+    row.cityNull = (nulls & 0x40) != 0;
+    row.city.clear();
+    if (!row.cityNull)
+    {
+        int length;
+        memcpy(&length, (const char*)key + offset, sizeof(int));
+        row.city.assign((const char*)key + offset + sizeof(int), length);
+        offset += sizeof(int) + length;
+    }
+    memcpy(&row.score, (const char*)key + offset, sizeof(float));
+}
+
+// Scans between two bounds over their leading fields (0 for no bound) and checks the entries
+// against the rows that fall between them
+int checkScan(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const vector<Row> &rows,
+        const Row &low, unsigned lowFields, const Row &high, unsigned highFields, bool lowInclusive, bool highInclusive)
+{
+    vector<Row> expected;
+    for(unsigned i = 0; i < rows.size(); i++)
+    {
+        int lowResult = lowFields == 0 ? 1 : compareFields(rows[i], low, lowFields);
+        int highResult = highFields == 0 ? -1 : compareFields(rows[i], high, highFields);
+        if ((lowResult > 0 || (lowResult == 0 && lowInclusive)) && (highResult < 0 || (highResult == 0 && highInclusive)))
+            expected.push_back(rows[i]);
+    }
+    sort(expected.begin(), expected.end(), rowLess);
+
+    char lowKey[PAGE_SIZE];
+    char highKey[PAGE_SIZE];
+    toKey(low, lowFields, lowKey);
+    toKey(high, highFields, highKey);
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attributes, lowFields == 0 ? NULL : lowKey, lowFields,
+            highFields == 0 ? NULL : highKey, highFields, lowInclusive, highInclusive, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    RID rid;
+    char key[PAGE_SIZE];
+    unsigned count = 0;
+    int result = success;
+    while(ix_ScanIterator.getNextEntry(rid, key) == success)
+    {
+        Row row;
+        fromKey(key, row);
+        row.rid = rid;
+        if (count >= expected.size() || rowLess(row, expected[count]) || rowLess(expected[count], row))
+        {
+            cerr << "Entry " << count << " of the scan is wrong --- The test failed." << endl;
+            result = fail;
+            break;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    if (result == success && count != expected.size())
+    {
+        cerr << "The scan returned " << count << " entries instead of " << expected.size() << " --- The test failed." << endl;
+        result = fail;
+    }
+    return result;
+}
+
+// A mix of scans: everything, one region, a range of cities in a region, scores above one
+// value for a city, and the regions after one
+int checkScans(IXFileHandle &ixfileHandle, const vector<Attribute> &attributes, const vector<Row> &rows)
+{
+    Row low = rows[0];
+    Row high = rows[0];
+    if (checkScan(ixfileHandle, attributes, rows, low, 0, high, 0, true, true) != success)
+        return fail;
+
+    low.region = high.region = 3;
+    if (checkScan(ixfileHandle, attributes, rows, low, 1, high, 1, true, true) != success)
+        return fail;
+
+    low.cityNull = high.cityNull = false;
+    low.city = "San";
+    high.city = "San Jose";
+    if (checkScan(ixfileHandle, attributes, rows, low, 2, high, 2, true, true) != success)
+        return fail;
+    if (checkScan(ixfileHandle, attributes, rows, low, 2, high, 2, false, false) != success)
+        return fail;
+
+    // null cities come first in a region
+    low.cityNull = true;
+    if (checkScan(ixfileHandle, attributes, rows, low, 2, high, 2, true, false) != success)
+        return fail;
+
+    low.cityNull = high.cityNull = false;
+    low.city = high.city = "Oakland";
+    low.score = 10.5f;
+    if (checkScan(ixfileHandle, attributes, rows, low, 3, high, 2, false, true) != success)
+        return fail;
+
+    low.region = 7;
+    return checkScan(ixfileHandle, attributes, rows, low, 1, high, 0, false, true);
+}
+
+int testCase_21(const string &indexFileName)
+{
+    // Checks an index over several attributes and scans over a prefix of them.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Bulk load and insert composite keys with null fields **
+    // 4. Scan with bounds on the leading attributes **
+    // 5. Delete composite keys **
+    // 6. Close and reopen the Index File
+    // 7. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 21 *****" << endl;
+
+    vector<Attribute> attributes(3);
+    attributes[0].name = "region";
+    attributes[0].type = TypeInt;
+    attributes[0].length = 4;
+    attributes[1].name = "city";
+    attributes[1].type = TypeVarChar;
+    attributes[1].length = 20;
+    attributes[2].name = "score";
+    attributes[2].type = TypeReal;
+    attributes[2].length = 4;
+
+    const char *cities[] = {"", "Oakland", "San", "San Francisco", "San Jose", "Santa Cruz", "Fresno"};
+    const unsigned cityNumber = sizeof(cities) / sizeof(cities[0]);
+    const unsigned numOfTuples = 6000;
+    vector<Row> rows;
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        Row row;
+        row.region = (int) (i * 7 % 11) - 2;
+        row.cityNull = i % 13 == 0;
+        row.city = row.cityNull ? "" : cities[i * 5 % cityNumber];
+        row.score = (float) (i * 31 % 40) / 2 - 5;
+        row.rid.pageNum = i;
+        row.rid.slotNum = i % 7;
+        rows.push_back(row);
+    }
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    // The first half is bulk loaded, the rest inserted one at a time
+    vector<char> keyData(numOfTuples / 2 * 64);
+    vector<const void*> keys;
+    vector<RID> rids;
+    for(unsigned i = 0; i < numOfTuples / 2; i++)
+    {
+        toKey(rows[i], 3, &keyData[i * 64]);
+        keys.push_back(&keyData[i * 64]);
+        rids.push_back(rows[i].rid);
+    }
+    rc = indexManager->bulkLoad(ixfileHandle, attributes, keys, rids, 0.7f);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+    char key[PAGE_SIZE];
+    for(unsigned i = numOfTuples / 2; i < numOfTuples; i++)
+    {
+        toKey(rows[i], 3, key);
+        rc = indexManager->insertEntry(ixfileHandle, attributes, key, rows[i].rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    if (checkScans(ixfileHandle, attributes, rows) != success)
+        return fail;
+
+    // The index only takes keys of its own attribute types
+    Attribute single = attributes[0];
+    int value = 3;
+    rc = indexManager->insertEntry(ixfileHandle, single, &value, rows[0].rid);
+    assert(rc != success && "Inserting a single attribute key into a composite index should fail.");
+    vector<Attribute> other(attributes);
+    other[2].type = TypeInt;
+    rc = indexManager->insertEntry(ixfileHandle, other, key, rows[0].rid);
+    assert(rc != success && "Inserting a key of other attribute types should fail.");
+    IX_ScanIterator ix_ScanIterator;
+    rc = indexManager->scan(ixfileHandle, attributes, key, 0, NULL, 0, true, true, ix_ScanIterator);
+    assert(rc != success && "A bound over no attributes should fail.");
+
+    // Delete every third entry
+    vector<Row> remaining;
+    for(unsigned i = 0; i < numOfTuples; i++)
+    {
+        if (i % 3 != 0)
+        {
+            remaining.push_back(rows[i]);
+            continue;
+        }
+        toKey(rows[i], 3, key);
+        rc = indexManager->deleteEntry(ixfileHandle, attributes, key, rows[i].rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+    toKey(rows[0], 3, key);
+    rc = indexManager->deleteEntry(ixfileHandle, attributes, key, rows[0].rid);
+    assert(rc != success && "Deleting an entry twice should fail.");
+
+    // The attribute types are kept in the file
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (checkScans(ixfileHandle, attributes, remaining) != success)
+        return fail;
+    rc = indexManager->insertEntry(ixfileHandle, single, &value, rows[0].rid);
+    assert(rc != success && "Inserting a single attribute key into a composite index should fail.");
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "composite_idx";
+    remove("composite_idx");
+
+    RC result = testCase_21(indexFileName);
+    if (result == success) {
+        cerr << "***** IX Test Case 21 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 21 failed. *****" << endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,284 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// A VarChar key as the record manager passes it
+int prepareKey(const string &value, char *key)
+{
+    int length = value.size();
+    memcpy(key, &length, sizeof(int));
+    memcpy(key + sizeof(int), value.data(), length);
+    return sizeof(int) + length;
+}
+
+// Scans [low, high] (empty for no bound) and compares the keys and RIDs with those of the sorted
+// values that fall in it. Every value has the RID of its position in values
+int checkScan(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<string> &values,
+        const vector<bool> &deleted, const string &low, const string &high, bool lowInclusive, bool highInclusive)
+{
+    vector<unsigned> expected;
+    for(unsigned i = 0; i < values.size(); i++)
+    {
+        if (deleted[i])
+            continue;
+        if (!low.empty() && (values[i] < low || (values[i] == low && !lowInclusive)))
+            continue;
+        if (!high.empty() && (values[i] > high || (values[i] == high && !highInclusive)))
+            continue;
+        expected.push_back(i);
+    }
+    sort(expected.begin(), expected.end(), [&](unsigned a, unsigned b) { return values[a] < values[b]; });
+
+    char lowKey[PAGE_SIZE];
+    char highKey[PAGE_SIZE];
+    prepareKey(low, lowKey);
+    prepareKey(high, highKey);
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, low.empty() ? NULL : lowKey, high.empty() ? NULL : highKey,
+            lowInclusive, highInclusive, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    RID rid;
+    char key[PAGE_SIZE];
+    unsigned count = 0;
+    int result = success;
+    while(ix_ScanIterator.getNextEntry(rid, key) == success)
+    {
+        int length;
+        memcpy(&length, key, sizeof(int));
+        if (count >= expected.size() || rid.pageNum != expected[count] ||
+                string(key + sizeof(int), length) != values[expected[count]])
+        {
+            cerr << "Entry " << count << " of the scan is wrong: " << string(key + sizeof(int), length)
+                 << " --- The test failed." << endl;
+            result = fail;
+            break;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    if (result == success && count != expected.size())
+    {
+        cerr << "The scan returned " << count << " entries instead of " << expected.size() << " --- The test failed." << endl;
+        result = fail;
+    }
+    return result;
+}
+
+// Reads the metadata page of a closed index
+IndexMetadata readMetadata(const string &indexFileName)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    FileHandle fileHandle;
+    char page[PAGE_SIZE];
+    RC rc = pfm->openFile(indexFileName, fileHandle);
+    assert(rc == success && "PagedFileManager::openFile() should not fail.");
+    rc = fileHandle.readPage(IX_METADATA_PAGE, page);
+    assert(rc == success && "FileHandle::readPage() should not fail.");
+    pfm->closeFile(fileHandle);
+    IndexMetadata metadata;
+    memcpy(&metadata, page, sizeof(IndexMetadata));
+    return metadata;
+}
+
+int testPrefixes(const string &indexFileName, const Attribute &attribute)
+{
+    // URLs and e-mail addresses that share long prefixes, inserted in no particular order
+    const unsigned numOfKeys = 20000;
+    vector<string> values;
+    char value[100];
+    unsigned keyBytes = 0;
+    for(unsigned i = 0; i < numOfKeys; i++)
+    {
+        unsigned n = (i * 7919) % numOfKeys;
+        if (n % 4 == 0)
+            sprintf(value, "mailto:customer%06u@mail.example.org", n);
+        else
+            sprintf(value, "https://shop.example.com/catalog/products/sku-%06u", n);
+        values.push_back(value);
+        keyBytes += values.back().size();
+    }
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    char key[PAGE_SIZE];
+    RID rid;
+    for(unsigned i = 0; i < numOfKeys; i++)
+    {
+        prepareKey(values[i], key);
+        rid.pageNum = i;
+        rid.slotNum = i % 50;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    // The characters of the keys alone take more pages than the tree should
+    unsigned readPageCount, writePageCount, appendPageCount;
+    rc = ixfileHandle.collectCounterValues(readPageCount, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    cerr << "Pages for " << keyBytes << " bytes of keys: " << appendPageCount << endl;
+    if (appendPageCount >= keyBytes / PAGE_SIZE)
+    {
+        cerr << "The leaves don't share the prefixes of their keys --- The test failed." << endl;
+        return fail;
+    }
+
+    vector<bool> deleted(numOfKeys, false);
+    if (checkScan(ixfileHandle, attribute, values, deleted, "", "", true, true) != success ||
+            checkScan(ixfileHandle, attribute, values, deleted, "https://shop.example.com/catalog/products/sku-0012",
+                "https://shop.example.com/catalog/products/sku-001299", true, true) != success ||
+            checkScan(ixfileHandle, attribute, values, deleted, "https://shop.example.com/catalog/products/sku-001201",
+                "https://shop.example.com/catalog/products/sku-001299", false, false) != success ||
+            checkScan(ixfileHandle, attribute, values, deleted, "mailto:customer", "mailto:customer01", true, true) != success ||
+            checkScan(ixfileHandle, attribute, values, deleted, "https://", "https://shop.example.com/catalog/products/sku-",
+                true, false) != success)
+        return fail;
+
+    // Deleting most keys merges leaves under shorter prefixes
+    for(unsigned i = 0; i < numOfKeys; i++)
+    {
+        if (i % 5 == 0)
+            continue;
+        prepareKey(values[i], key);
+        rid.pageNum = i;
+        rid.slotNum = i % 50;
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+        deleted[i] = true;
+    }
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (checkScan(ixfileHandle, attribute, values, deleted, "", "", true, true) != success ||
+            checkScan(ixfileHandle, attribute, values, deleted, "m", "", true, true) != success)
+        return fail;
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int testSeparators(const string &indexFileName, const Attribute &attribute)
+{
+    // Long keys that differ in their first bytes. Whole keys as separators would leave only a
+    // few in each internal node and make the tree several levels high
+    const unsigned numOfKeys = 600;
+    vector<string> values;
+    vector<char> keyData(numOfKeys * 700);
+    vector<const void*> keys;
+    vector<RID> rids;
+    char value[16];
+    for(unsigned i = 0; i < numOfKeys; i++)
+    {
+        sprintf(value, "%06u", i * 2);
+        values.push_back(string(value) + string(600, 'x'));
+        prepareKey(values[i], &keyData[i * 700]);
+        keys.push_back(&keyData[i * 700]);
+        RID rid;
+        rid.pageNum = i;
+        rid.slotNum = 0;
+        rids.push_back(rid);
+    }
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager->bulkLoad(ixfileHandle, attribute, keys, rids, 1.0f);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+
+    // Keys between the loaded ones split the full leaves
+    char key[PAGE_SIZE];
+    for(unsigned i = 0; i < numOfKeys / 4; i++)
+    {
+        sprintf(value, "%06u", i * 8 + 1);
+        values.push_back(string(value) + string(600, 'x'));
+        prepareKey(values.back(), key);
+        RID rid;
+        rid.pageNum = values.size() - 1;
+        rid.slotNum = 0;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, key, rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+
+    vector<bool> deleted(values.size(), false);
+    if (checkScan(ixfileHandle, attribute, values, deleted, "", "", true, true) != success ||
+            checkScan(ixfileHandle, attribute, values, deleted, "000100", "0002", true, false) != success ||
+            checkScan(ixfileHandle, attribute, values, deleted, values[10], values[numOfKeys + 20], false, true) != success)
+        return fail;
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    IndexMetadata metadata = readMetadata(indexFileName);
+    cerr << "Leaves: " << metadata.leafNumber << ", height: " << metadata.height << endl;
+    if (metadata.height > 2)
+    {
+        cerr << "The separators are whole keys --- The test failed." << endl;
+        return fail;
+    }
+
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int testCase_22(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks that leaves store the prefix their keys share once, and that splits push up
+    // separators no longer than needed.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Insert and bulk load VarChar keys with long common prefixes **
+    // 4. Scan with bounds inside and outside the leaves' prefixes **
+    // 5. Delete entries so leaves merge **
+    // 6. Close Index File
+    // 7. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 22 *****" << endl;
+
+    if (testPrefixes(indexFileName, attribute) != success)
+        return fail;
+    return testSeparators(indexFileName, attribute);
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "url_idx";
+    Attribute attrUrl;
+    attrUrl.length = PAGE_SIZE / 4;
+    attrUrl.name = "url";
+    attrUrl.type = TypeVarChar;
+
+    remove("url_idx");
+
+    RC result = testCase_22(indexFileName, attrUrl);
+    if (result == success) {
+        cerr << "***** IX Test Case 22 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 22 failed. *****" << endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,241 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+// Reads the metadata page of a closed index
+IndexMetadata readMetadata(const string &indexFileName)
+{
+    PagedFileManager *pfm = PagedFileManager::instance();
+    FileHandle fileHandle;
+    char page[PAGE_SIZE];
+    RC rc = pfm->openFile(indexFileName, fileHandle);
+    assert(rc == success && "PagedFileManager::openFile() should not fail.");
+    rc = fileHandle.readPage(IX_METADATA_PAGE, page);
+    assert(rc == success && "FileHandle::readPage() should not fail.");
+    pfm->closeFile(fileHandle);
+    IndexMetadata metadata;
+    memcpy(&metadata, page, sizeof(IndexMetadata));
+    return metadata;
+}
+
+RID makeRid(int key)
+{
+    RID rid;
+    rid.pageNum = key;
+    rid.slotNum = key % 100;
+    return rid;
+}
+
+// Inserts the keys first, first + step, ... one at a time
+void insertKeys(IXFileHandle &ixfileHandle, const Attribute &attribute, int first, int number, int step)
+{
+    for(int i = 0; i < number; i++)
+    {
+        int key = first + i * step;
+        RC rc = indexManager->insertEntry(ixfileHandle, attribute, &key, makeRid(key));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+}
+
+// Scans every entry and checks that the keys are the sorted ones given
+int checkKeys(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<int> &keys)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    RID rid;
+    int key;
+    unsigned count = 0;
+    while(ix_ScanIterator.getNextEntry(rid, &key) == success)
+    {
+        if (count >= keys.size() || key != keys[count] || rid.pageNum != (unsigned) key)
+        {
+            cerr << "Entry " << count << " of the scan is wrong: " << key << " --- The test failed." << endl;
+            ix_ScanIterator.close();
+            return fail;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+    if (count != keys.size())
+    {
+        cerr << "The scan returned " << count << " entries instead of " << keys.size() << " --- The test failed." << endl;
+        return fail;
+    }
+    return success;
+}
+
+// Leaves of an index of the keys 0 .. numOfKeys - 1, bulk loaded with fillFactor
+unsigned bulkLoadedLeaves(const string &indexFileName, const Attribute &attribute, int numOfKeys, float fillFactor)
+{
+    vector<int> keyValues(numOfKeys);
+    vector<const void*> keys;
+    vector<RID> rids;
+    for(int i = 0; i < numOfKeys; i++)
+    {
+        keyValues[i] = i;
+        keys.push_back(&keyValues[i]);
+        rids.push_back(makeRid(i));
+    }
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager->bulkLoad(ixfileHandle, attribute, keys, rids, fillFactor);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    unsigned leaves = readMetadata(indexFileName).leafNumber;
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return leaves;
+}
+
+// Leaves of an index of the keys 0 .. numOfKeys - 1 inserted in increasing order, or in no
+// particular order if shuffled, with the fill factor given, or the default if it is 0
+unsigned insertedLeaves(const string &indexFileName, const Attribute &attribute, int numOfKeys, float fillFactor,
+        bool shuffled)
+{
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (fillFactor > 0)
+    {
+        // The fill factor is kept in the file
+        rc = indexManager->setFillFactor(ixfileHandle, fillFactor);
+        assert(rc == success && "indexManager::setFillFactor() should not fail.");
+        rc = indexManager->closeFile(ixfileHandle);
+        assert(rc == success && "indexManager::closeFile() should not fail.");
+        rc = indexManager->openFile(indexFileName, ixfileHandle);
+        assert(rc == success && "indexManager::openFile() should not fail.");
+    }
+
+    vector<int> keys;
+    for(int i = 0; i < numOfKeys; i++)
+    {
+        int key = shuffled ? (int) ((i * 7919LL) % numOfKeys) : i;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &key, makeRid(key));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+        keys.push_back(i);
+    }
+    if (checkKeys(ixfileHandle, attribute, keys) != success)
+        return 0;
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    unsigned leaves = readMetadata(indexFileName).leafNumber;
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return leaves;
+}
+
+int testCase_23(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks that increasing keys leave leaves as full as the fill factor rather than half full.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Set the fill factor **
+    // 3. Insert increasing keys at the end of the index and inside it **
+    // 4. Bulk load with a fill factor
+    // 5. Scan
+    // 6. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 23 *****" << endl;
+
+    const int numOfKeys = 30000;
+
+    // Appends at the default fill factor end up like a bulk load at it
+    unsigned bulkLeaves = bulkLoadedLeaves(indexFileName, attribute, numOfKeys, IX_DEFAULT_FILL_FACTOR);
+    unsigned appendLeaves = insertedLeaves(indexFileName, attribute, numOfKeys, 0, false);
+    unsigned randomLeaves = insertedLeaves(indexFileName, attribute, numOfKeys, 0, true);
+    cerr << "Leaves bulk loaded: " << bulkLeaves << ", appended: " << appendLeaves << ", inserted in no order: "
+         << randomLeaves << endl;
+    if (appendLeaves == 0 || randomLeaves == 0)
+        return fail;
+    if (appendLeaves > bulkLeaves * 1.05 + 1 || appendLeaves >= randomLeaves)
+    {
+        cerr << "Appends leave the leaves half empty --- The test failed." << endl;
+        return fail;
+    }
+
+    // A fill factor of 1 moves only the new entry to the new leaf
+    bulkLeaves = bulkLoadedLeaves(indexFileName, attribute, numOfKeys, 1.0f);
+    appendLeaves = insertedLeaves(indexFileName, attribute, numOfKeys, 1.0f, false);
+    cerr << "Leaves bulk loaded full: " << bulkLeaves << ", appended: " << appendLeaves << endl;
+    if (appendLeaves == 0 || appendLeaves > bulkLeaves * 1.02 + 1)
+    {
+        cerr << "Appends don't fill the leaves --- The test failed." << endl;
+        return fail;
+    }
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager->setFillFactor(ixfileHandle, 0);
+    assert(rc != success && "A fill factor of 0 should fail.");
+    rc = indexManager->setFillFactor(ixfileHandle, 1.5f);
+    assert(rc != success && "A fill factor above 1 should fail.");
+
+    // A run of increasing keys in the middle of the index, as a timestamp after a prefix would be
+    insertKeys(ixfileHandle, attribute, 0, 10, 1);
+    insertKeys(ixfileHandle, attribute, 10 * numOfKeys, 10, 1);
+    insertKeys(ixfileHandle, attribute, 10, numOfKeys - 10, 1);
+    vector<int> keys;
+    for(int i = 0; i < numOfKeys; i++)
+        keys.push_back(i);
+    for(int i = 0; i < 10; i++)
+        keys.push_back(10 * numOfKeys + i);
+    if (checkKeys(ixfileHandle, attribute, keys) != success)
+        return fail;
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    unsigned innerLeaves = readMetadata(indexFileName).leafNumber;
+    appendLeaves = insertedLeaves(indexFileName + "_end", attribute, numOfKeys, 0, false);
+    cerr << "Leaves appended inside the index: " << innerLeaves << endl;
+    if (innerLeaves > appendLeaves * 1.05 + 2)
+    {
+        cerr << "Appends inside the index leave the leaves half empty --- The test failed." << endl;
+        return fail;
+    }
+
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "sequence_idx";
+    Attribute attrSequence;
+    attrSequence.length = 4;
+    attrSequence.name = "sequence";
+    attrSequence.type = TypeInt;
+
+    remove("sequence_idx");
+    remove("sequence_idx_end");
+
+    RC result = testCase_23(indexFileName, attrSequence);
+    if (result == success) {
+        cerr << "***** IX Test Case 23 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 23 failed. *****" << endl;
+        return fail;
+    }
+
+}
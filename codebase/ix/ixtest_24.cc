@@ -0,0 +1,280 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+typedef struct Entry
+{
+    int key;
+    RID rid;
+} Entry;
+
+bool entryLess(const Entry &a, const Entry &b)
+{
+    if (a.key != b.key)
+        return a.key < b.key;
+    if (a.rid.pageNum != b.rid.pageNum)
+        return a.rid.pageNum < b.rid.pageNum;
+    return a.rid.slotNum < b.rid.slotNum;
+}
+
+bool keyLess(const Entry &a, int key)
+{
+    return a.key < key;
+}
+
+bool lessKey(int key, const Entry &a)
+{
+    return key < a.key;
+}
+
+// Entries of the sorted ones between two bounds, NULL for no bound
+uint64_t expectedCount(const vector<Entry> &entries, const int *low, const int *high, bool lowInclusive,
+        bool highInclusive)
+{
+    vector<Entry>::const_iterator first = entries.begin();
+    vector<Entry>::const_iterator last = entries.end();
+    if (low != NULL)
+        first = lowInclusive ? lower_bound(entries.begin(), entries.end(), *low, keyLess)
+                : upper_bound(entries.begin(), entries.end(), *low, lessKey);
+    if (high != NULL)
+        last = highInclusive ? upper_bound(entries.begin(), entries.end(), *high, lessKey)
+                : lower_bound(entries.begin(), entries.end(), *high, keyLess);
+    return first < last ? last - first : 0;
+}
+
+// Compares countRange, rank and select with the sorted entries
+int checkCounts(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<Entry> &entries)
+{
+    const int bounds[] = {-1, 0, 1, 17, 1000, 2499, 2500, 2501, 3333, 4998, 4999, 5000};
+    const unsigned boundNumber = sizeof(bounds) / sizeof(bounds[0]);
+    uint64_t count;
+    RC rc = indexManager->countRange(ixfileHandle, attribute, NULL, NULL, true, true, count);
+    assert(rc == success && "indexManager::countRange() should not fail.");
+    if (count != entries.size())
+    {
+        cerr << "The index counts " << count << " entries instead of " << entries.size() << " --- The test failed." << endl;
+        return fail;
+    }
+
+    for (unsigned i = 0; i < boundNumber; i++)
+    {
+        for (unsigned j = i; j < boundNumber; j++)
+        {
+            for (unsigned inclusive = 0; inclusive < 4; inclusive++)
+            {
+                bool lowInclusive = inclusive & 1;
+                bool highInclusive = inclusive & 2;
+                rc = indexManager->countRange(ixfileHandle, attribute, &bounds[i], &bounds[j], lowInclusive,
+                        highInclusive, count);
+                assert(rc == success && "indexManager::countRange() should not fail.");
+                uint64_t expected = expectedCount(entries, &bounds[i], &bounds[j], lowInclusive, highInclusive);
+                if (count != expected)
+                {
+                    cerr << "Range " << bounds[i] << " to " << bounds[j] << " counts " << count << " entries instead of "
+                         << expected << " --- The test failed." << endl;
+                    return fail;
+                }
+            }
+        }
+        rc = indexManager->countRange(ixfileHandle, attribute, &bounds[i], NULL, false, true, count);
+        assert(rc == success && "indexManager::countRange() should not fail.");
+        if (count != expectedCount(entries, &bounds[i], NULL, false, true))
+        {
+            cerr << "Keys above " << bounds[i] << " are counted wrong --- The test failed." << endl;
+            return fail;
+        }
+
+        uint64_t position;
+        rc = indexManager->rank(ixfileHandle, attribute, &bounds[i], position);
+        assert(rc == success && "indexManager::rank() should not fail.");
+        if (position != expectedCount(entries, NULL, &bounds[i], true, false))
+        {
+            cerr << "The rank of " << bounds[i] << " is wrong: " << position << " --- The test failed." << endl;
+            return fail;
+        }
+    }
+
+    int key;
+    RID rid;
+    for (unsigned i = 0; i < entries.size(); i += 97)
+    {
+        rc = indexManager->select(ixfileHandle, attribute, i, &key, rid);
+        assert(rc == success && "indexManager::select() should not fail.");
+        if (key != entries[i].key || rid.pageNum != entries[i].rid.pageNum || rid.slotNum != entries[i].rid.slotNum)
+        {
+            cerr << "Entry " << i << " is " << key << " (" << rid.pageNum << "," << rid.slotNum << ") instead of "
+                 << entries[i].key << " --- The test failed." << endl;
+            return fail;
+        }
+    }
+    rc = indexManager->select(ixfileHandle, attribute, entries.size(), &key, rid);
+    assert(rc == IX_EOF && "indexManager::select() past the last entry should return IX_EOF.");
+    return success;
+}
+
+int testCase_24(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks that internal nodes count the entries under them, so ranges are counted and
+    // entries found by position without reading the leaves in between.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Insert entries, with keys that overflow their posting lists
+    // 4. Count ranges, rank and select **
+    // 5. Delete entries so nodes merge
+    // 6. Close and reopen the Index File
+    // 7. Bulk load
+    // 8. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 24 *****" << endl;
+
+    const unsigned numOfTuples = 20000;
+    const unsigned numOfKeys = 5000;
+    vector<Entry> entries;
+    for (unsigned i = 0; i < numOfTuples; i++)
+    {
+        Entry entry;
+        entry.key = (i * 7919) % numOfKeys;
+        entry.rid.pageNum = i;
+        entry.rid.slotNum = i % 50;
+        entries.push_back(entry);
+    }
+    // one key with more RIDs than a leaf entry holds
+    for (unsigned i = 0; i < 3000; i++)
+    {
+        Entry entry;
+        entry.key = 2500;
+        entry.rid.pageNum = numOfTuples + i;
+        entry.rid.slotNum = i % 7;
+        entries.push_back(entry);
+    }
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &entries[i].key, entries[i].rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    sort(entries.begin(), entries.end(), entryLess);
+    if (checkCounts(ixfileHandle, attribute, entries) != success)
+        return fail;
+
+    // Two paths from the root, however many leaves the range covers
+    unsigned readBefore, readAfter, writePageCount, appendPageCount;
+    rc = ixfileHandle.collectCounterValues(readBefore, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    int low = 10;
+    int high = 4990;
+    uint64_t count;
+    rc = indexManager->countRange(ixfileHandle, attribute, &low, &high, true, true, count);
+    assert(rc == success && "indexManager::countRange() should not fail.");
+    rc = ixfileHandle.collectCounterValues(readAfter, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    cerr << "Pages read to count " << count << " entries: " << readAfter - readBefore << endl;
+    if (readAfter - readBefore > 8)
+    {
+        cerr << "Counting reads the leaves --- The test failed." << endl;
+        return fail;
+    }
+
+    // Deleting most entries merges nodes and shrinks the overflowed posting list
+    vector<Entry> remaining;
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        if (i % 4 == 0)
+        {
+            remaining.push_back(entries[i]);
+            continue;
+        }
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, &entries[i].key, entries[i].rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+    rc = indexManager->deleteEntry(ixfileHandle, attribute, &entries[1].key, entries[1].rid);
+    assert(rc != success && "Deleting an entry twice should fail.");
+    if (checkCounts(ixfileHandle, attribute, remaining) != success)
+        return fail;
+
+    // The counts are kept in the file
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (checkCounts(ixfileHandle, attribute, remaining) != success)
+        return fail;
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    // A bulk loaded tree is counted as it is built, and kept counted by later inserts
+    rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    vector<const void*> keys;
+    vector<RID> rids;
+    for (unsigned i = 0; i < entries.size(); i += 2)
+    {
+        keys.push_back(&entries[i].key);
+        rids.push_back(entries[i].rid);
+    }
+    rc = indexManager->bulkLoad(ixfileHandle, attribute, keys, rids, 0.8f);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+    for (unsigned i = 1; i < entries.size(); i += 4)
+    {
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &entries[i].key, entries[i].rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    vector<Entry> loaded;
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        if (i % 2 == 0 || i % 4 == 1)
+            loaded.push_back(entries[i]);
+    }
+    if (checkCounts(ixfileHandle, attribute, loaded) != success)
+        return fail;
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "age_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    remove("age_idx");
+
+    RC result = testCase_24(indexFileName, attrAge);
+    if (result == success) {
+        cerr << "***** IX Test Case 24 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 24 failed. *****" << endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,317 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+typedef struct Entry
+{
+    int key;
+    RID rid;
+} Entry;
+
+bool entryLess(const Entry &a, const Entry &b)
+{
+    if (a.key != b.key)
+        return a.key < b.key;
+    if (a.rid.pageNum != b.rid.pageNum)
+        return a.rid.pageNum < b.rid.pageNum;
+    return a.rid.slotNum < b.rid.slotNum;
+}
+
+bool entryEqual(const Entry &a, const Entry &b)
+{
+    return !entryLess(a, b) && !entryLess(b, a);
+}
+
+// Scans between two bounds, NULL for no bound, and returns the entries sorted
+vector<Entry> scanEntries(IXFileHandle &ixfileHandle, const Attribute &attribute, const int *low, const int *high,
+        bool lowInclusive, bool highInclusive)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, low, high, lowInclusive, highInclusive, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    vector<Entry> found;
+    Entry entry;
+    while (ix_ScanIterator.getNextEntry(entry.rid, &entry.key) == success)
+        found.push_back(entry);
+    ix_ScanIterator.close();
+    sort(found.begin(), found.end(), entryLess);
+    return found;
+}
+
+// Compares scans for single keys, ranges and the whole index with the sorted entries
+int checkEntries(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<Entry> &entries)
+{
+    vector<Entry> found = scanEntries(ixfileHandle, attribute, NULL, NULL, true, true);
+    if (found.size() != entries.size() || !equal(found.begin(), found.end(), entries.begin(), entryEqual))
+    {
+        cerr << "A full scan returned " << found.size() << " entries instead of " << entries.size()
+             << " --- The test failed." << endl;
+        return fail;
+    }
+
+    for (int key = -3; key < 5003; key += 7)
+    {
+        found = scanEntries(ixfileHandle, attribute, &key, &key, true, true);
+        vector<Entry> expected;
+        for (unsigned i = 0; i < entries.size(); i++)
+        {
+            if (entries[i].key == key)
+                expected.push_back(entries[i]);
+        }
+        if (found.size() != expected.size() || !equal(found.begin(), found.end(), expected.begin(), entryEqual))
+        {
+            cerr << "Key " << key << " has " << found.size() << " entries instead of " << expected.size()
+                 << " --- The test failed." << endl;
+            return fail;
+        }
+    }
+
+    int low = 1000;
+    int high = 2000;
+    found = scanEntries(ixfileHandle, attribute, &low, &high, false, true);
+    vector<Entry> expected;
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        if (entries[i].key > low && entries[i].key <= high)
+            expected.push_back(entries[i]);
+    }
+    if (found.size() != expected.size() || !equal(found.begin(), found.end(), expected.begin(), entryEqual))
+    {
+        cerr << "A range scan returned " << found.size() << " entries instead of " << expected.size()
+             << " --- The test failed." << endl;
+        return fail;
+    }
+    return success;
+}
+
+int testCase_25(const string &indexFileName, const Attribute &attribute, const string &nameIndexFileName,
+        const Attribute &nameAttribute)
+{
+    // Checks that a hash index answers through the same calls as a B+ tree, finding a key
+    // with a directory page and a bucket.
+    //
+    // Functions tested
+    // 1. Create a hash Index File **
+    // 2. Open Index File
+    // 3. Insert entries, with keys that overflow their posting lists **
+    // 4. Scan single keys, ranges and the whole index **
+    // 5. Insert entries while a scan goes on **
+    // 6. Delete entries
+    // 7. Close and reopen the Index File
+    // 8. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 25 *****" << endl;
+
+    const unsigned numOfTuples = 20000;
+    const unsigned numOfKeys = 5000;
+    vector<Entry> entries;
+    for (unsigned i = 0; i < numOfTuples; i++)
+    {
+        Entry entry;
+        entry.key = (i * 7919) % numOfKeys;
+        entry.rid.pageNum = i;
+        entry.rid.slotNum = i % 50;
+        entries.push_back(entry);
+    }
+    // one key with more RIDs than a bucket entry holds
+    for (unsigned i = 0; i < 3000; i++)
+    {
+        Entry entry;
+        entry.key = 2500;
+        entry.rid.pageNum = numOfTuples + i;
+        entry.rid.slotNum = i % 7;
+        entries.push_back(entry);
+    }
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName, IX_HASH);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &entries[i].key, entries[i].rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+    }
+    sort(entries.begin(), entries.end(), entryLess);
+    if (checkEntries(ixfileHandle, attribute, entries) != success)
+        return fail;
+
+    // A directory page and a bucket for a key
+    unsigned readBefore, readAfter, writePageCount, appendPageCount;
+    rc = ixfileHandle.collectCounterValues(readBefore, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    int key = 4321;
+    vector<Entry> found = scanEntries(ixfileHandle, attribute, &key, &key, true, true);
+    rc = ixfileHandle.collectCounterValues(readAfter, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    cerr << "Pages read to look up " << found.size() << " entries: " << readAfter - readBefore << endl;
+    if (found.size() != 4 || readAfter - readBefore > 2)
+    {
+        cerr << "A lookup reads more than a directory page and a bucket --- The test failed." << endl;
+        return fail;
+    }
+
+    // Without a key order there is nothing to count by
+    uint64_t count;
+    rc = indexManager->countRange(ixfileHandle, attribute, NULL, NULL, true, true, count);
+    assert(rc == IX_UNORDERED_INDEX && "indexManager::countRange() on a hash index should fail.");
+    RID rid;
+    rc = indexManager->select(ixfileHandle, attribute, 0, &key, rid);
+    assert(rc == IX_UNORDERED_INDEX && "indexManager::select() on a hash index should fail.");
+
+    // Buckets split under a scan are not read twice, and none of the entries from before is missed
+    IX_ScanIterator ix_ScanIterator;
+    rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    vector<Entry> scanned;
+    vector<Entry> added;
+    Entry entry;
+    while (ix_ScanIterator.getNextEntry(entry.rid, &entry.key) == success)
+    {
+        scanned.push_back(entry);
+        if (scanned.size() % 2 != 0 || added.size() >= 20000)
+            continue;
+        Entry newEntry;
+        newEntry.key = numOfKeys + added.size();
+        newEntry.rid.pageNum = added.size();
+        newEntry.rid.slotNum = 1;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &newEntry.key, newEntry.rid);
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+        added.push_back(newEntry);
+    }
+    ix_ScanIterator.close();
+    sort(scanned.begin(), scanned.end(), entryLess);
+    if (adjacent_find(scanned.begin(), scanned.end(), entryEqual) != scanned.end() ||
+            !includes(scanned.begin(), scanned.end(), entries.begin(), entries.end(), entryLess))
+    {
+        cerr << "A scan during splits returned entries twice or missed some --- The test failed." << endl;
+        return fail;
+    }
+    for (unsigned i = 0; i < added.size(); i++)
+    {
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, &added[i].key, added[i].rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+
+    // Deleting most entries empties overflow pages and shrinks the overflowed posting list
+    vector<Entry> remaining;
+    for (unsigned i = 0; i < entries.size(); i++)
+    {
+        if (i % 4 == 0)
+        {
+            remaining.push_back(entries[i]);
+            continue;
+        }
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, &entries[i].key, entries[i].rid);
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+    }
+    rc = indexManager->deleteEntry(ixfileHandle, attribute, &entries[1].key, entries[1].rid);
+    assert(rc != success && "Deleting an entry twice should fail.");
+    if (checkEntries(ixfileHandle, attribute, remaining) != success)
+        return fail;
+
+    // The directory is kept in the file
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (checkEntries(ixfileHandle, attribute, remaining) != success)
+        return fail;
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+
+    // VarChar keys, bulk loaded
+    rc = indexManager->createFile(nameIndexFileName, IX_HASH);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(nameIndexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    const unsigned numOfNames = 3000;
+    vector<string> names(numOfNames);
+    vector<const void*> keys;
+    vector<RID> rids;
+    for (unsigned i = 0; i < numOfNames; i++)
+    {
+        string name = string(i % 40 + 1, 'a' + i % 26) + to_string(i);
+        int length = name.size();
+        names[i] = string((char *)&length, sizeof(int)) + name;
+        RID nameRid;
+        nameRid.pageNum = i;
+        nameRid.slotNum = 0;
+        rids.push_back(nameRid);
+    }
+    for (unsigned i = 0; i < numOfNames; i++)
+        keys.push_back(names[i].data());
+    rc = indexManager->bulkLoad(ixfileHandle, nameAttribute, keys, rids, 0.8f);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+    for (unsigned i = 0; i < numOfNames; i += 3)
+    {
+        rc = indexManager->scan(ixfileHandle, nameAttribute, names[i].data(), names[i].data(), true, true, ix_ScanIterator);
+        assert(rc == success && "indexManager::scan() should not fail.");
+        char nameKey[PAGE_SIZE];
+        unsigned matches = 0;
+        while (ix_ScanIterator.getNextEntry(rid, nameKey) == success)
+        {
+            if (rid.pageNum != i || memcmp(nameKey, names[i].data(), names[i].size()) != 0)
+            {
+                cerr << "Name " << i << " found the wrong entry --- The test failed." << endl;
+                return fail;
+            }
+            matches++;
+        }
+        ix_ScanIterator.close();
+        if (matches != 1)
+        {
+            cerr << "Name " << i << " has " << matches << " entries --- The test failed." << endl;
+            return fail;
+        }
+    }
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(nameIndexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "age_hash_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    const string nameIndexFileName = "name_hash_idx";
+    Attribute attrName;
+    attrName.length = 60;
+    attrName.name = "name";
+    attrName.type = TypeVarChar;
+
+    remove("age_hash_idx");
+    remove("name_hash_idx");
+
+    RC result = testCase_25(indexFileName, attrAge, nameIndexFileName, attrName);
+    if (result == success) {
+        cerr << "***** IX Test Case 25 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 25 failed. *****" << endl;
+        return fail;
+    }
+
+}
@@ -0,0 +1,212 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+RID ridOf(int key)
+{
+    RID rid;
+    rid.pageNum = key;
+    rid.slotNum = key % 50;
+    return rid;
+}
+
+// Looks up one key, checks that it has its RID if present and nothing otherwise, and returns
+// the pages read to do it
+int lookUp(IXFileHandle &ixfileHandle, const Attribute &attribute, int key, bool present, unsigned &pagesRead)
+{
+    unsigned readBefore, readAfter, writePageCount, appendPageCount;
+    RC rc = ixfileHandle.collectCounterValues(readBefore, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+
+    IX_ScanIterator ix_ScanIterator;
+    rc = indexManager->scan(ixfileHandle, attribute, &key, &key, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+    unsigned count = 0;
+    int returnedKey;
+    RID rid;
+    RID expected = ridOf(key);
+    while (ix_ScanIterator.getNextEntry(rid, &returnedKey) == success)
+    {
+        if (returnedKey != key || rid.pageNum != expected.pageNum || rid.slotNum != expected.slotNum)
+        {
+            cerr << "Wrong entry " << returnedKey << " (" << rid.pageNum << "," << rid.slotNum << ") for key "
+                 << key << " --- The test failed." << endl;
+            ix_ScanIterator.close();
+            return fail;
+        }
+        count++;
+    }
+    ix_ScanIterator.close();
+
+    rc = ixfileHandle.collectCounterValues(readAfter, writePageCount, appendPageCount);
+    assert(rc == success && "indexManager::collectCounterValues() should not fail.");
+    pagesRead = readAfter - readBefore;
+    if (count != (present ? 1u : 0u))
+    {
+        cerr << "Key " << key << " has " << count << " entries --- The test failed." << endl;
+        return fail;
+    }
+    return success;
+}
+
+// Looks up keys spread over [0, keyNumber) and fails if a lookup reads more than its leaf and
+// the next one
+int checkLookups(IXFileHandle &ixfileHandle, const Attribute &attribute, unsigned keyNumber, const vector<bool> &present)
+{
+    const unsigned lookups = 1000;
+    unsigned totalRead = 0;
+    for (unsigned i = 0; i < lookups; i++)
+    {
+        int key = (i * 7919) % keyNumber;
+        unsigned pagesRead;
+        if (lookUp(ixfileHandle, attribute, key, present[key], pagesRead) != success)
+            return fail;
+        if (pagesRead > 2)
+        {
+            cerr << "Looking up " << key << " read " << pagesRead << " pages --- The test failed." << endl;
+            return fail;
+        }
+        totalRead += pagesRead;
+    }
+    cerr << "Pages read by " << lookups << " lookups: " << totalRead << endl;
+    return success;
+}
+
+int testCase_26(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks that lookups find their way through the upper levels of the tree in memory, and
+    // that splits and merges keep those copies up to date, also for another handle on the index.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File
+    // 3. Bulk load a tree of three levels
+    // 4. Look up keys, reading only their leaves **
+    // 5. Insert and delete entries so nodes split and merge, looking up keys in between
+    //    through a second handle **
+    // 6. Close and reopen the Index File
+    // 7. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 26 *****" << endl;
+
+    const unsigned loadedKeys = 150000;
+    const unsigned insertedKeys = 60000;
+    const unsigned keyNumber = loadedKeys + insertedKeys;
+    vector<int> keys(keyNumber);
+    vector<bool> present(keyNumber, false);
+    for (unsigned i = 0; i < keyNumber; i++)
+        keys[i] = i;
+
+    IXFileHandle ixfileHandle;
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    IXFileHandle otherHandle;
+    rc = indexManager->openFile(indexFileName, otherHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+
+    vector<const void*> loadKeys;
+    vector<RID> loadRids;
+    for (unsigned i = 0; i < loadedKeys; i++)
+    {
+        loadKeys.push_back(&keys[i]);
+        loadRids.push_back(ridOf(i));
+        present[i] = true;
+    }
+    rc = indexManager->bulkLoad(ixfileHandle, attribute, loadKeys, loadRids, 0.9f);
+    assert(rc == success && "indexManager::bulkLoad() should not fail.");
+
+    // The first lookup reads the path from the root, the others only their leaves
+    unsigned pagesRead;
+    if (lookUp(ixfileHandle, attribute, 0, true, pagesRead) != success)
+        return fail;
+    cerr << "Pages read by the first lookup: " << pagesRead << endl;
+    if (pagesRead < 3)
+    {
+        cerr << "The tree should have at least three levels --- The test failed." << endl;
+        return fail;
+    }
+    if (checkLookups(ixfileHandle, attribute, keyNumber, present) != success ||
+            checkLookups(otherHandle, attribute, keyNumber, present) != success)
+        return fail;
+
+    // Inserts split leaves and internal nodes, and may grow a new root
+    for (unsigned i = 0; i < insertedKeys; i++)
+    {
+        int key = loadedKeys + (i * 7) % insertedKeys;
+        rc = indexManager->insertEntry(ixfileHandle, attribute, &key, ridOf(key));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+        present[key] = true;
+        if (i % 500 == 0 && (lookUp(ixfileHandle, attribute, key, true, pagesRead) != success ||
+                lookUp(otherHandle, attribute, key, true, pagesRead) != success))
+            return fail;
+    }
+    if (checkLookups(ixfileHandle, attribute, keyNumber, present) != success ||
+            checkLookups(otherHandle, attribute, keyNumber, present) != success)
+        return fail;
+
+    // Deletes merge and redistribute nodes, and shrink the tree
+    for (unsigned i = 0; i < keyNumber; i++)
+    {
+        if (i % 10 == 0)
+            continue;
+        rc = indexManager->deleteEntry(ixfileHandle, attribute, &keys[i], ridOf(i));
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+        present[i] = false;
+        if (i % 500 == 1 && (lookUp(ixfileHandle, attribute, keys[i], false, pagesRead) != success ||
+                lookUp(otherHandle, attribute, keys[i], false, pagesRead) != success ||
+                lookUp(otherHandle, attribute, keys[i - 1], true, pagesRead) != success))
+            return fail;
+    }
+    if (checkLookups(ixfileHandle, attribute, keyNumber, present) != success ||
+            checkLookups(otherHandle, attribute, keyNumber, present) != success)
+        return fail;
+
+    // A reopened index starts with no copies
+    rc = indexManager->closeFile(otherHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, ixfileHandle);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (checkLookups(ixfileHandle, attribute, keyNumber, present) != success)
+        return fail;
+
+    rc = indexManager->closeFile(ixfileHandle);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "age_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    remove("age_idx");
+
+    RC result = testCase_26(indexFileName, attrAge);
+    if (result == success) {
+        cerr << "***** IX Test Case 26 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 26 failed. *****" << endl;
+        return fail;
+    }
+
+}
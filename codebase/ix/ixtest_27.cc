@@ -0,0 +1,160 @@
+#include <iostream>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+#include "ix.h"
+#include "ix_test_util.h"
+
+IndexManager *indexManager;
+
+RID ridOf(int key)
+{
+    RID rid;
+    rid.pageNum = key;
+    rid.slotNum = key % 50;
+    return rid;
+}
+
+// Scans the whole index through ixfileHandle and checks that it returns exactly the present keys
+int checkEntries(IXFileHandle &ixfileHandle, const Attribute &attribute, const vector<bool> &present)
+{
+    IX_ScanIterator ix_ScanIterator;
+    RC rc = indexManager->scan(ixfileHandle, attribute, NULL, NULL, true, true, ix_ScanIterator);
+    assert(rc == success && "indexManager::scan() should not fail.");
+
+    vector<bool> seen(present.size(), false);
+    unsigned count = 0;
+    int key;
+    RID rid;
+    while (ix_ScanIterator.getNextEntry(rid, &key) == success)
+    {
+        RID expected = ridOf(key);
+        if (key < 0 || key >= (int) present.size() || !present[key] || seen[key] ||
+                rid.pageNum != expected.pageNum || rid.slotNum != expected.slotNum)
+        {
+            cerr << "Unexpected entry " << key << " (" << rid.pageNum << "," << rid.slotNum << ") --- The test failed." << endl;
+            ix_ScanIterator.close();
+            return fail;
+        }
+        seen[key] = true;
+        count++;
+    }
+    ix_ScanIterator.close();
+
+    unsigned expectedCount = 0;
+    for (unsigned i = 0; i < present.size(); i++)
+        expectedCount += present[i] ? 1 : 0;
+    if (count != expectedCount)
+    {
+        cerr << "The scan returned " << count << " entries instead of " << expectedCount << " --- The test failed." << endl;
+        return fail;
+    }
+    return success;
+}
+
+int testCase_27(const string &indexFileName, const Attribute &attribute)
+{
+    // Checks that handles opened on the same index see one tree: the root one of them grows is
+    // the root the other descends from, and closing them in any order keeps every change.
+    //
+    // Functions tested
+    // 1. Create Index File
+    // 2. Open Index File twice **
+    // 3. Insert and delete entries through either handle, scanning through the other **
+    // 4. Close the handles and reopen the Index File **
+    // 5. Destroy Index File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cerr << endl << "***** In IX Test Case 27 *****" << endl;
+
+    const unsigned keyNumber = 40000;
+    vector<bool> present(keyNumber, false);
+
+    RC rc = indexManager->createFile(indexFileName);
+    assert(rc == success && "indexManager::createFile() should not fail.");
+    IXFileHandle first;
+    IXFileHandle second;
+    rc = indexManager->openFile(indexFileName, first);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    rc = indexManager->openFile(indexFileName, second);
+    assert(rc == success && "Opening an index that is already open should not fail.");
+
+    // The first handle grows the tree from a single leaf, the second one must find all of it
+    for (unsigned i = 0; i < keyNumber / 2; i++)
+    {
+        int key = i * 2;
+        rc = indexManager->insertEntry(first, attribute, &key, ridOf(key));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+        present[key] = true;
+    }
+    if (checkEntries(second, attribute, present) != success)
+        return fail;
+
+    // And the other way round, with deletes that merge nodes and shrink the tree
+    for (unsigned i = 0; i < keyNumber / 2; i++)
+    {
+        int key = i * 2 + 1;
+        rc = indexManager->insertEntry(second, attribute, &key, ridOf(key));
+        assert(rc == success && "indexManager::insertEntry() should not fail.");
+        present[key] = true;
+    }
+    if (checkEntries(first, attribute, present) != success)
+        return fail;
+    for (unsigned i = 0; i < keyNumber; i++)
+    {
+        if (i % 8 == 0)
+            continue;
+        int key = i;
+        rc = indexManager->deleteEntry(i % 2 == 0 ? first : second, attribute, &key, ridOf(key));
+        assert(rc == success && "indexManager::deleteEntry() should not fail.");
+        present[key] = false;
+    }
+    if (checkEntries(first, attribute, present) != success ||
+            checkEntries(second, attribute, present) != success)
+        return fail;
+
+    // Closing the handle that made the first changes last must not undo the later ones
+    rc = indexManager->closeFile(second);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    if (checkEntries(first, attribute, present) != success)
+        return fail;
+    rc = indexManager->closeFile(first);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+    rc = indexManager->closeFile(first);
+    assert(rc != success && "Closing a closed handle should fail.");
+
+    rc = indexManager->openFile(indexFileName, first);
+    assert(rc == success && "indexManager::openFile() should not fail.");
+    if (checkEntries(first, attribute, present) != success)
+        return fail;
+    rc = indexManager->closeFile(first);
+    assert(rc == success && "indexManager::closeFile() should not fail.");
+
+    rc = indexManager->destroyFile(indexFileName);
+    assert(rc == success && "indexManager::destroyFile() should not fail.");
+    return success;
+}
+
+int main()
+{
+    // Global Initialization
+    indexManager = IndexManager::instance();
+
+    const string indexFileName = "age_idx";
+    Attribute attrAge;
+    attrAge.length = 4;
+    attrAge.name = "age";
+    attrAge.type = TypeInt;
+
+    remove("age_idx");
+
+    RC result = testCase_27(indexFileName, attrAge);
+    if (result == success) {
+        cerr << "***** IX Test Case 27 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cerr << "***** [FAIL] IX Test Case 27 failed. *****" << endl;
+        return fail;
+    }
+}
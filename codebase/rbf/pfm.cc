@@ -1,12 +1,30 @@
+#include <cerrno>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
 #include "pfm.h"
 
 PagedFileManager* PagedFileManager::_pf_manager = NULL;
+BufferManager* BufferManager::_bf_manager = NULL;
+
+// Get the number of pages in a file from its size
+static bool getFileSize(int fd, PageNum &numPages)
+{
+    struct stat sb;
+    if (fstat(fd, &sb) != 0)
+        return false;
+    // Filesize is always PAGE_SIZE * number of pages
+    numPages = sb.st_size / PAGE_SIZE;
+    return true;
+}
+
 
 PagedFileManager* PagedFileManager::instance()
 {
@@ -18,6 +36,7 @@ PagedFileManager* PagedFileManager::instance()
 
 
 PagedFileManager::PagedFileManager()
+: directIO(false), writeBack(true), syncInterval(0)
 {
 }
 
@@ -33,19 +52,36 @@ RC PagedFileManager::createFile(const string &fileName)
     if (fileExists(fileName))
         return PFM_FILE_EXISTS;
 
-    // Attempt to open the file for writing
-    FILE *pFile = fopen(fileName.c_str(), "wb");
+    // Attempt to create the file
+    int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
     // Return an error if we fail
-    if (pFile == NULL)
+    if (fd < 0)
         return PFM_OPEN_FAILED;
 
-    fclose (pFile);
+    close(fd);
+
+    // The new file may have reused the inode of a file removed behind our back,
+    // so make sure no stale frames are left for it
+    FileId id;
+    if (getFileId(fileName, id))
+        BufferManager::instance()->discardFile(id);
+
     return SUCCESS;
 }
 
 
 RC PagedFileManager::destroyFile(const string &fileName)
 {
+    // Forget about any cached pages of the file before it goes away
+    FileId id;
+    if (getFileId(fileName, id))
+    {
+        BufferManager::instance()->discardFile(id);
+        // Handles that are still open keep their OpenFile, but a new file must not find it
+        lock_guard<mutex> guard(openFilesLatch);
+        openFiles.erase(id);
+    }
+
     // If file cannot be successfully removed, error
     if (remove(fileName.c_str()) != 0)
         return PFM_REMOVE_FAILED;
@@ -57,21 +93,58 @@ RC PagedFileManager::destroyFile(const string &fileName)
 RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle)
 {
     // If this handle already has an open file, error
-    if (fileHandle.getfd() != NULL)
+    if (fileHandle.getFile() != NULL)
         return PFM_HANDLE_IN_USE;
 
     // If the file doesn't exist, error
-    if (!fileExists(fileName.c_str()))
+    FileId id;
+    if (!getFileId(fileName, id))
         return PFM_FILE_DN_EXIST;
 
-    // Open the file for reading/writing in binary mode
-    FILE *pFile;
-    pFile = fopen(fileName.c_str(), "rb+");
+    // Share the file with any other handle that already has it open
+    lock_guard<mutex> guard(openFilesLatch);
+    auto it = openFiles.find(id);
+    if (it != openFiles.end())
+    {
+        it->second->handleCount++;
+        fileHandle.setFile(it->second);
+        return SUCCESS;
+    }
+
+    // Open the file for reading/writing. With direct I/O, fall back to buffered
+    // I/O if the filesystem refuses O_DIRECT (e.g. tmpfs).
+    bool direct = directIO;
+    int fd = open(fileName.c_str(), O_RDWR | (direct ? O_DIRECT : 0));
+    if (fd < 0 && direct && errno == EINVAL)
+    {
+        direct = false;
+        fd = open(fileName.c_str(), O_RDWR);
+    }
     // If we fail, error
-    if (pFile == NULL)
+    if (fd < 0)
         return PFM_OPEN_FAILED;
 
-    fileHandle.setfd(pFile);
+    OpenFile *file = new OpenFile;
+    file->fd = fd;
+    file->id = id;
+    file->handleCount = 1;
+    file->directIO = direct;
+    file->writeBack = writeBack;
+    file->syncInterval = syncInterval;
+    file->lastSync = chrono::steady_clock::now().time_since_epoch().count();
+    file->unsynced = false;
+    // The page count is only read from the file here, see FileHandle::refreshNumberOfPages
+    PageNum numPages;
+    if (!getFileSize(fd, numPages))
+    {
+        close(fd);
+        delete file;
+        return PFM_OPEN_FAILED;
+    }
+    file->numPages = numPages;
+    openFiles[id] = file;
+
+    fileHandle.setFile(file);
 
     return SUCCESS;
 }
@@ -79,18 +152,51 @@ RC PagedFileManager::openFile(const string &fileName, FileHandle &fileHandle)
 
 RC PagedFileManager::closeFile(FileHandle &fileHandle)
 {
-    FILE *pFile = fileHandle.getfd();
+    OpenFile *file = fileHandle.getFile();
 
     // If not an open file, error
-    if (pFile == NULL)
+    if (file == NULL)
         return 1;
 
-    // Flush and close the file
-    fclose(pFile);
+    fileHandle.setFile(NULL);
+
+    // Other handles are still using the file
+    {
+        lock_guard<mutex> guard(openFilesLatch);
+        if (--file->handleCount > 0)
+            return SUCCESS;
+
+        auto it = openFiles.find(file->id);
+        if (it != openFiles.end() && it->second == file)
+            openFiles.erase(it);
+    }
 
-    fileHandle.setfd(NULL);
+    // Last handle: make dirty frames durable, then close the file. This runs without
+    // openFilesLatch, so opening and closing other files doesn't wait for the sync. A
+    // handle opening this file meanwhile gets a new OpenFile, and the frames it pins
+    // adopt that one. Clean frames stay cached so that reopening the file does not have
+    // to read them again.
+    RC rc = BufferManager::instance()->syncFile(file);
 
-    return SUCCESS;
+    close(file->fd);
+    delete file;
+
+    return rc;
+}
+
+void PagedFileManager::setDirectIO(bool enable)
+{
+    directIO = enable;
+}
+
+void PagedFileManager::setWriteBack(bool enable)
+{
+    writeBack = enable;
+}
+
+void PagedFileManager::setSyncInterval(unsigned milliseconds)
+{
+    syncInterval = milliseconds;
 }
 
 // Check if a file already exists
@@ -101,6 +207,420 @@ bool PagedFileManager::fileExists(const string &fileName)
     return stat(fileName.c_str(), &sb) == 0;
 }
 
+// Get the device and inode of a file. Returns false if the file doesn't exist
+bool PagedFileManager::getFileId(const string &fileName, FileId &id)
+{
+    struct stat sb;
+    if (stat(fileName.c_str(), &sb) != 0)
+        return false;
+    id.dev = sb.st_dev;
+    id.ino = sb.st_ino;
+    return true;
+}
+
+
+BufferManager* BufferManager::instance()
+{
+    if(!_bf_manager)
+        _bf_manager = new BufferManager();
+
+    return _bf_manager;
+}
+
+
+BufferManager::BufferManager()
+: frames(BUFFER_POOL_SIZE), clockHand(0)
+{
+    // One contiguous allocation for all frames, page aligned for O_DIRECT
+    void *buffer = NULL;
+    if (posix_memalign(&buffer, PAGE_SIZE, (size_t) BUFFER_POOL_SIZE * PAGE_SIZE) != 0)
+        buffer = NULL;
+    pool = (char*) buffer;
+    for (unsigned i = 0; i < BUFFER_POOL_SIZE; i++)
+    {
+        frames[i].data = pool + (size_t) i * PAGE_SIZE;
+        frames[i].file = NULL;
+        frames[i].pinCount = 0;
+        frames[i].valid = false;
+        frames[i].dirty = false;
+        frames[i].referenced = false;
+        frames[i].busy = false;
+        pthread_rwlock_init(&frames[i].pageLatch, NULL);
+    }
+}
+
+
+BufferManager::~BufferManager()
+{
+    for (unsigned i = 0; i < BUFFER_POOL_SIZE; i++)
+        pthread_rwlock_destroy(&frames[i].pageLatch);
+    free(pool);
+}
+
+
+RC BufferManager::pinPage(OpenFile *file, PageNum pageNum, bool load, void *&data)
+{
+    unique_lock<mutex> guard(latch);
+
+    while (true)
+    {
+        // Hit: just pin the frame, once it is done being read or written
+        Frame *frame = lookup(file, pageNum);
+        if (frame != NULL)
+        {
+            if (frame->busy)
+            {
+                ioDone.wait(guard);
+                continue;
+            }
+            frame->pinCount++;
+            frame->referenced = true;
+            // Frames outlive the OpenFile they were read through, so adopt the current one
+            frame->file = file;
+            data = frame->data;
+            return SUCCESS;
+        }
+
+        // Miss: find a frame to replace
+        unsigned frameNum;
+        RC rc = findVictim(frameNum, guard);
+        if (rc)
+            return rc;
+        // Writing back the victim lets other threads in, and one may have read the page
+        // meanwhile. The victim then stays free
+        if (lookup(file, pageNum) != NULL)
+            continue;
+
+        Frame &victim = frames[frameNum];
+        victim.id.file = file->id;
+        victim.id.pageNum = pageNum;
+        victim.file = file;
+        victim.dirty = false;
+        victim.valid = true;
+        victim.pinCount = 1;
+        victim.referenced = true;
+        pageTable[victim.id] = frameNum;
+
+        if (load)
+        {
+            victim.busy = true;
+            guard.unlock();
+            rc = readFrame(victim);
+            guard.lock();
+            victim.busy = false;
+            ioDone.notify_all();
+            if (rc)
+            {
+                // Threads waiting for the page will try to read it themselves
+                pageTable.erase(victim.id);
+                victim.valid = false;
+                victim.pinCount = 0;
+                victim.file = NULL;
+                return rc;
+            }
+        }
+
+        data = victim.data;
+        return SUCCESS;
+    }
+}
+
+
+RC BufferManager::unpinPage(OpenFile *file, PageNum pageNum, bool dirty)
+{
+    unique_lock<mutex> guard(latch);
+
+    Frame *frame = lookup(file, pageNum);
+    if (frame == NULL || frame->pinCount == 0)
+        return FH_NOT_PINNED;
+
+    if (dirty)
+        frame->dirty = true;
+
+    // Write-through files never keep dirty frames around. A flush may be writing the frame,
+    // without this change
+    while (frame->dirty && !file->writeBack && frame->busy)
+        ioDone.wait(guard);
+    if (frame->dirty && !file->writeBack)
+    {
+        frame->file = file;
+        RC rc = writeBack(*frame, guard);
+        if (rc)
+        {
+            frame->pinCount--;
+            return rc;
+        }
+    }
+
+    frame->pinCount--;
+    return SUCCESS;
+}
+
+
+RC BufferManager::writeThrough(OpenFile *file, PageNum pageNum)
+{
+    unique_lock<mutex> guard(latch);
+
+    Frame *frame = lookup(file, pageNum);
+    while (frame != NULL && frame->busy)
+    {
+        ioDone.wait(guard);
+        frame = lookup(file, pageNum);
+    }
+    if (frame == NULL)
+        return FH_NOT_PINNED;
+
+    return writeBack(*frame, guard);
+}
+
+
+RC BufferManager::flushFile(OpenFile *file)
+{
+    unique_lock<mutex> guard(latch);
+
+    for (unsigned i = 0; i < BUFFER_POOL_SIZE; i++)
+    {
+        Frame &frame = frames[i];
+        if (!frame.valid || !(frame.id.file == file->id))
+            continue;
+        // A write in progress must be on disk before the file is synced
+        if (frame.busy)
+        {
+            ioDone.wait(guard);
+            i--;
+            continue;
+        }
+        if (!frame.dirty)
+            continue;
+
+        // Write through this file, then give the frame back. A closing file is flushed after
+        // it has left openFiles, so a new OpenFile for the same file may own the frame by now
+        OpenFile *owner = frame.file;
+        frame.file = file;
+        RC rc = writeBack(frame, guard);
+        frame.file = owner;
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+
+RC BufferManager::syncFile(OpenFile *file)
+{
+    RC rc = flushFile(file);
+    if (rc)
+        return rc;
+
+    // The pool latch is not needed, so other files keep going while fdatasync runs
+    lock_guard<mutex> guard(file->syncLatch);
+
+    // Nothing reached the file since the last sync. Writes that land while fdatasync runs
+    // set the flag again
+    if (!file->unsynced.exchange(false))
+        return SUCCESS;
+
+    if (fdatasync(file->fd) != 0)
+    {
+        file->unsynced = true;
+        return FH_SYNC_FAILED;
+    }
+
+    file->lastSync = chrono::steady_clock::now().time_since_epoch().count();
+    return SUCCESS;
+}
+
+
+void BufferManager::discardPage(OpenFile *file, PageNum pageNum)
+{
+    unique_lock<mutex> guard(latch);
+
+    Frame *frame = lookup(file, pageNum);
+    while (frame != NULL && frame->busy)
+    {
+        ioDone.wait(guard);
+        frame = lookup(file, pageNum);
+    }
+    if (frame == NULL)
+        return;
+
+    pageTable.erase(frame->id);
+    frame->valid = false;
+    frame->dirty = false;
+    frame->pinCount = 0;
+    frame->file = NULL;
+}
+
+
+void BufferManager::prefetchPage(OpenFile *file, PageNum pageNum)
+{
+    {
+        lock_guard<mutex> guard(latch);
+        if (lookup(file, pageNum) != NULL)
+            return;
+    }
+
+    // O_DIRECT reads bypass the page cache, so there is nothing to read ahead into
+    if (!file->directIO)
+        posix_fadvise(file->fd, (off_t) PAGE_SIZE * pageNum, PAGE_SIZE, POSIX_FADV_WILLNEED);
+}
+
+
+// A pinned frame is never replaced, so its latch can be waited for without the pool latch
+RC BufferManager::latchPage(OpenFile *file, PageNum pageNum, bool exclusive)
+{
+    pthread_rwlock_t *pageLatch;
+    {
+        lock_guard<mutex> guard(latch);
+        Frame *frame = lookup(file, pageNum);
+        if (frame == NULL || frame->pinCount == 0)
+            return FH_NOT_PINNED;
+        pageLatch = &frame->pageLatch;
+    }
+
+    if (exclusive)
+        pthread_rwlock_wrlock(pageLatch);
+    else
+        pthread_rwlock_rdlock(pageLatch);
+    return SUCCESS;
+}
+
+
+RC BufferManager::unlatchPage(OpenFile *file, PageNum pageNum)
+{
+    pthread_rwlock_t *pageLatch;
+    {
+        lock_guard<mutex> guard(latch);
+        Frame *frame = lookup(file, pageNum);
+        if (frame == NULL || frame->pinCount == 0)
+            return FH_NOT_PINNED;
+        pageLatch = &frame->pageLatch;
+    }
+
+    pthread_rwlock_unlock(pageLatch);
+    return SUCCESS;
+}
+
+
+void BufferManager::discardFile(const FileId &id)
+{
+    unique_lock<mutex> guard(latch);
+
+    for (unsigned i = 0; i < BUFFER_POOL_SIZE; i++)
+    {
+        Frame &frame = frames[i];
+        if (!frame.valid || !(frame.id.file == id))
+            continue;
+        if (frame.busy)
+        {
+            ioDone.wait(guard);
+            i--;
+            continue;
+        }
+
+        pageTable.erase(frame.id);
+        frame.valid = false;
+        frame.dirty = false;
+        frame.pinCount = 0;
+        frame.file = NULL;
+    }
+}
+
+// Private helper methods ///////////////////////////////////////////////////////////////////
+
+// Pick a frame to replace using the CLOCK algorithm. A dirty victim is written back first,
+// which drops the latch held by guard while the write runs.
+RC BufferManager::findVictim(unsigned &frameNum, unique_lock<mutex> &guard)
+{
+    // Two full sweeps are enough: the first clears reference bits, the second finds a frame
+    for (unsigned sweep = 0; sweep < 2 * BUFFER_POOL_SIZE; sweep++)
+    {
+        Frame &frame = frames[clockHand];
+        unsigned current = clockHand;
+        clockHand = (clockHand + 1) % BUFFER_POOL_SIZE;
+
+        if (!frame.valid)
+        {
+            frameNum = current;
+            return SUCCESS;
+        }
+        if (frame.pinCount > 0 || frame.busy)
+            continue;
+        if (frame.referenced)
+        {
+            frame.referenced = false;
+            continue;
+        }
+
+        if (frame.dirty)
+        {
+            // Pinners of the page wait for the write, so the frame is still unpinned after it
+            RC rc = writeBack(frame, guard);
+            if (rc)
+                return rc;
+        }
+        pageTable.erase(frame.id);
+        frame.valid = false;
+        frameNum = current;
+        return SUCCESS;
+    }
+
+    // Every frame is pinned
+    return FH_NO_FREE_FRAME;
+}
+
+
+RC BufferManager::readFrame(Frame &frame)
+{
+    // Positional read, so concurrent readers of the file don't share an offset
+    off_t offset = (off_t) PAGE_SIZE * frame.id.pageNum;
+    if (pread(frame.file->fd, frame.data, PAGE_SIZE, offset) != PAGE_SIZE)
+        return FH_READ_FAILED;
+
+    return SUCCESS;
+}
+
+
+RC BufferManager::writeFrame(Frame &frame)
+{
+    off_t offset = (off_t) PAGE_SIZE * frame.id.pageNum;
+    if (pwrite(frame.file->fd, frame.data, PAGE_SIZE, offset) != PAGE_SIZE)
+        return FH_WRITE_FAILED;
+
+    frame.file->unsynced = true;
+    return SUCCESS;
+}
+
+
+// The frame is marked clean before the write starts, so a change unpinned while it runs
+// leaves it dirty again. A failed write leaves it dirty
+RC BufferManager::writeBack(Frame &frame, unique_lock<mutex> &guard)
+{
+    frame.busy = true;
+    frame.dirty = false;
+    guard.unlock();
+    RC rc = writeFrame(frame);
+    guard.lock();
+    frame.busy = false;
+    if (rc)
+        frame.dirty = true;
+    ioDone.notify_all();
+    return rc;
+}
+
+
+Frame *BufferManager::lookup(OpenFile *file, PageNum pageNum)
+{
+    PageId id;
+    id.file = file->id;
+    id.pageNum = pageNum;
+
+    auto it = pageTable.find(id);
+    if (it == pageTable.end())
+        return NULL;
+    return &frames[it->second];
+}
+
 
 FileHandle::FileHandle()
 {
@@ -108,7 +628,7 @@ FileHandle::FileHandle()
     writePageCounter = 0;
     appendPageCounter = 0;
 
-    _fd = NULL;
+    _file = NULL;
 }
 
 
@@ -120,16 +640,18 @@ FileHandle::~FileHandle()
 RC FileHandle::readPage(PageNum pageNum, void *data)
 {
     // If pageNum doesn't exist, error
-    if (getNumberOfPages() < pageNum)
+    if (pageNum >= getNumberOfPages())
         return FH_PAGE_DN_EXIST;
 
-    // Try to seek to the specified page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
-        return FH_SEEK_FAILED;
+    // Get the page from the buffer pool, reading it from disk on a miss
+    BufferManager *bm = BufferManager::instance();
+    void *frame;
+    RC rc = bm->pinPage(_file, pageNum, true, frame);
+    if (rc)
+        return rc;
 
-    // Try to read the specified page
-    if (fread(data, 1, PAGE_SIZE, _fd) != PAGE_SIZE)
-        return FH_READ_FAILED;
+    memcpy(data, frame, PAGE_SIZE);
+    bm->unpinPage(_file, pageNum, false);
 
     readPageCounter++;
     return SUCCESS;
@@ -139,52 +661,60 @@ RC FileHandle::readPage(PageNum pageNum, void *data)
 RC FileHandle::writePage(PageNum pageNum, const void *data)
 {
     // Check if the page exists
-    if (getNumberOfPages() < pageNum)
+    if (pageNum >= getNumberOfPages())
         return FH_PAGE_DN_EXIST;
 
-    // Seek to the start of the page
-    if (fseek(_fd, PAGE_SIZE * pageNum, SEEK_SET))
-        return FH_SEEK_FAILED;
-
-    // Write the page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
-    {
-        // Immediately commit changes to disk
-        fflush(_fd);
-        writePageCounter++;
-        return SUCCESS;
-    }
-    
-    return FH_WRITE_FAILED;
+    // The whole frame is overwritten, so there is no need to read the old page
+    BufferManager *bm = BufferManager::instance();
+    void *frame;
+    RC rc = bm->pinPage(_file, pageNum, false, frame);
+    if (rc)
+        return rc;
+
+    // In write-back mode the page stays dirty in the pool, so repeated writes
+    // of a page are coalesced into one write
+    memcpy(frame, data, PAGE_SIZE);
+    rc = bm->unpinPage(_file, pageNum, true);
+    if (rc)
+        return rc;
+
+    writePageCounter++;
+    return maybeSync();
 }
 
 
 RC FileHandle::appendPage(const void *data)
 {
-    // Seek to the end of the file
-    if (fseek(_fd, 0, SEEK_END))
-        return FH_SEEK_FAILED;
-
-    // Write the new page
-    if (fwrite(data, 1, PAGE_SIZE, _fd) == PAGE_SIZE)
+    // The new page goes right after the current last page
+    lock_guard<mutex> guard(_file->appendLatch);
+    PageNum pageNum = _file->numPages;
+
+    BufferManager *bm = BufferManager::instance();
+    void *frame;
+    RC rc = bm->pinPage(_file, pageNum, false, frame);
+    if (rc)
+        return rc;
+
+    // The page count is kept in memory, so the new page can be written back
+    // lazily like any other dirty page
+    memcpy(frame, data, PAGE_SIZE);
+    rc = bm->unpinPage(_file, pageNum, true);
+    if (rc)
     {
-        fflush(_fd);
-        appendPageCounter++;
-        return SUCCESS;
+        // Don't leave a frame behind for a page that was never written
+        bm->discardPage(_file, pageNum);
+        return rc;
     }
-    return FH_WRITE_FAILED;
+
+    _file->numPages++;
+    appendPageCounter++;
+    return maybeSync();
 }
 
 
 unsigned FileHandle::getNumberOfPages()
 {
-    // Use stat to get the file size
-    struct stat sb;
-    if (fstat(fileno(_fd), &sb) != 0)
-        // On error, return 0
-        return 0;
-    // Filesize is always PAGE_SIZE * number of pages
-    return sb.st_size / PAGE_SIZE;
+    return _file->numPages;
 }
 
 
@@ -196,12 +726,110 @@ RC FileHandle::collectCounterValues(unsigned &readPageCount, unsigned &writePage
     return SUCCESS;
 }
 
-void FileHandle::setfd(FILE *fd)
+
+RC FileHandle::fetchPage(PageNum pageNum, void *&data)
 {
-    _fd = fd;
+    // If pageNum doesn't exist, error
+    if (pageNum >= getNumberOfPages())
+        return FH_PAGE_DN_EXIST;
+
+    RC rc = BufferManager::instance()->pinPage(_file, pageNum, true, data);
+    if (rc)
+        return rc;
+
+    readPageCounter++;
+    return SUCCESS;
 }
 
-FILE *FileHandle::getfd()
+
+RC FileHandle::unpinPage(PageNum pageNum, bool dirty)
 {
-    return _fd;
-}
\ No newline at end of file
+    RC rc = BufferManager::instance()->unpinPage(_file, pageNum, dirty);
+    if (rc)
+        return rc;
+
+    if (!dirty)
+        return SUCCESS;
+
+    writePageCounter++;
+    return maybeSync();
+}
+
+
+RC FileHandle::sync()
+{
+    return BufferManager::instance()->syncFile(_file);
+}
+
+void FileHandle::prefetchPage(PageNum pageNum)
+{
+    if (pageNum < getNumberOfPages())
+        BufferManager::instance()->prefetchPage(_file, pageNum);
+}
+
+RC FileHandle::latchPage(PageNum pageNum, bool exclusive)
+{
+    return BufferManager::instance()->latchPage(_file, pageNum, exclusive);
+}
+
+RC FileHandle::unlatchPage(PageNum pageNum)
+{
+    return BufferManager::instance()->unlatchPage(_file, pageNum);
+}
+
+RC FileHandle::allocatePages(unsigned count, PageNum &firstPage)
+{
+    lock_guard<mutex> guard(_file->appendLatch);
+    firstPage = _file->numPages;
+
+    // Reserve the blocks and extend the file in one call
+    off_t offset = (off_t) PAGE_SIZE * firstPage;
+    if (count > 0 && posix_fallocate(_file->fd, offset, (off_t) PAGE_SIZE * count) != 0)
+        return FH_ALLOC_FAILED;
+
+    _file->numPages += count;
+    appendPageCounter += count;
+    return SUCCESS;
+}
+
+
+RC FileHandle::refreshNumberOfPages()
+{
+    // Appended pages may only exist in the buffer pool so far
+    lock_guard<mutex> guard(_file->appendLatch);
+    RC rc = BufferManager::instance()->flushFile(_file);
+    if (rc)
+        return rc;
+
+    PageNum numPages;
+    if (!getFileSize(_file->fd, numPages))
+        return FH_STAT_FAILED;
+
+    _file->numPages = numPages;
+    return SUCCESS;
+}
+
+void FileHandle::setFile(OpenFile *file)
+{
+    _file = file;
+}
+
+OpenFile *FileHandle::getFile()
+{
+    return _file;
+}
+
+// Group commit: after a write, sync if the file's sync interval has passed, so bulk
+// loads pay one sync per interval rather than one per page
+RC FileHandle::maybeSync()
+{
+    if (_file->syncInterval == 0)
+        return SUCCESS;
+
+    chrono::steady_clock::duration elapsed = chrono::steady_clock::now().time_since_epoch() -
+            chrono::steady_clock::duration(_file->lastSync.load());
+    if (elapsed < chrono::milliseconds(_file->syncInterval))
+        return SUCCESS;
+
+    return sync();
+}
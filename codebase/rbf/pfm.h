@@ -14,18 +14,114 @@
 #define FH_SEEK_FAILED    2
 #define FH_READ_FAILED    3
 #define FH_WRITE_FAILED   4
+#define FH_NO_FREE_FRAME  5
+#define FH_NOT_PINNED     6
+#define FH_SYNC_FAILED    7
+#define FH_STAT_FAILED    8
+#define FH_ALLOC_FAILED   9
 
 typedef unsigned PageNum;
 typedef int RC;
 typedef char byte;
 
 #define PAGE_SIZE 4096
+
+// Number of page frames in the buffer pool shared by all open files
+#define BUFFER_POOL_SIZE 1024
+
 #include <string>
 #include <climits>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <unordered_map>
+
+#include <sys/types.h>
+#include <pthread.h>
+
 using namespace std;
 
 class FileHandle;
 
+// Identifies a file by device and inode rather than by name or handle, so every
+// FileHandle opened on the same file shares one OpenFile and one set of frames.
+typedef struct FileId
+{
+    dev_t dev;
+    ino_t ino;
+
+    bool operator==(const FileId &other) const
+    {
+        return dev == other.dev && ino == other.ino;
+    }
+} FileId;
+
+struct FileIdHash
+{
+    size_t operator()(const FileId &id) const
+    {
+        return hash<unsigned long long>()(((unsigned long long) id.ino << 16) ^ id.dev);
+    }
+};
+
+// Identifies a page in the buffer pool
+typedef struct PageId
+{
+    FileId file;
+    PageNum pageNum;
+
+    bool operator==(const PageId &other) const
+    {
+        return file == other.file && pageNum == other.pageNum;
+    }
+} PageId;
+
+struct PageIdHash
+{
+    size_t operator()(const PageId &id) const
+    {
+        return FileIdHash()(id.file) * 31 + id.pageNum;
+    }
+};
+
+// Shared state for a file that is open through one or more FileHandles.
+// All page I/O uses pread/pwrite, so handles never share a file offset.
+typedef struct OpenFile
+{
+    int fd;
+    FileId id;
+    unsigned handleCount;
+    bool directIO;      // Opened with O_DIRECT, bypassing the OS page cache
+    mutex appendLatch;  // Serializes appends so two threads never claim the same page
+
+    // Authoritative page count. It is read from the file on open and then maintained
+    // in memory, so appended pages may still be waiting in the buffer pool.
+    atomic<PageNum> numPages;
+
+    // Durability policy, see PagedFileManager::setWriteBack/setSyncInterval
+    bool writeBack;
+    unsigned syncInterval;
+    atomic<chrono::steady_clock::rep> lastSync;     // Ticks of the last fdatasync, read without a latch
+    atomic<bool> unsynced;      // Pages were written since the last fdatasync
+    mutex syncLatch;    // Serializes syncs, so none returns before an fdatasync covering its writes
+} OpenFile;
+
+// A single page frame in the buffer pool
+typedef struct Frame
+{
+    PageId id;
+    OpenFile *file;
+    char *data;
+    unsigned pinCount;
+    bool valid;
+    bool dirty;
+    bool referenced;    // Second-chance bit for CLOCK replacement
+    bool busy;          // Being read in or written out without the pool latch
+    pthread_rwlock_t pageLatch;     // Taken by threads reading or changing the pinned page
+} Frame;
+
 class PagedFileManager
 {
 public:
@@ -35,6 +131,20 @@ public:
     RC destroyFile   (const string &fileName);                          // Destroy a file
     RC openFile      (const string &fileName, FileHandle &fileHandle);  // Open a file
     RC closeFile     (FileHandle &fileHandle);                          // Close a file
+    bool getFileId   (const string &fileName, FileId &id);              // Identify a file however it is named
+
+    // Open files that are not already open with O_DIRECT. The buffer pool then is the
+    // only cache; filesystems that don't support O_DIRECT fall back to buffered I/O.
+    void setDirectIO (bool enable);
+
+    // Durability policy for files opened afterwards. In write-back mode (the default)
+    // writePage only dirties the cached frame; dirty pages are written and made
+    // durable by FileHandle::sync() and when the file is closed. A non-zero sync
+    // interval additionally syncs after a write once that many milliseconds have
+    // passed since the last sync (group commit). Write-through mode writes every
+    // page to the OS immediately, as before.
+    void setWriteBack    (bool enable);
+    void setSyncInterval (unsigned milliseconds);
 
 protected:
     PagedFileManager();                                                 // Constructor
@@ -43,19 +153,79 @@ protected:
 private:
     static PagedFileManager *_pf_manager;
 
+    bool directIO;
+    bool writeBack;
+    unsigned syncInterval;
+
+    // Files with at least one open FileHandle
+    unordered_map<FileId, OpenFile*, FileIdHash> openFiles;
+    mutex openFilesLatch;
+
     // Private helper methods
     bool fileExists(const string &fileName);
 };
 
 
+// BufferManager caches pages of all open files in a fixed number of frames.
+// Pages are looked up through a page table keyed by (file, page number) and
+// evicted with the CLOCK algorithm. Pinned frames are never evicted; dirty frames
+// are written back when they are evicted or when their file is closed.
+// Frames are PAGE_SIZE aligned so they can be used for O_DIRECT transfers, and
+// all methods may be called from several threads at once. Disk reads and writes
+// run without the pool latch: the frame is marked busy meanwhile, so it is not
+// replaced, and threads pinning its page wait until the transfer is done.
+class BufferManager
+{
+public:
+    static BufferManager* instance();                                   // Access to the _bf_manager instance
+
+    // Pin a page in the pool. If load is false the caller will overwrite the whole
+    // frame, so it is not read in from disk on a miss. Unpinning a dirty page of a
+    // write-through file writes it immediately.
+    RC pinPage       (OpenFile *file, PageNum pageNum, bool load, void *&data);
+    RC unpinPage     (OpenFile *file, PageNum pageNum, bool dirty);
+
+    RC writeThrough  (OpenFile *file, PageNum pageNum);                 // Write a resident page to disk now
+    RC flushFile     (OpenFile *file);                                  // Write back all dirty pages of a file
+    RC syncFile      (OpenFile *file);                                  // Flush, then fdatasync the file
+    void discardPage (OpenFile *file, PageNum pageNum);                 // Drop one frame without writing
+    void prefetchPage(OpenFile *file, PageNum pageNum);                 // Start reading a page that is not resident
+    RC latchPage     (OpenFile *file, PageNum pageNum, bool exclusive);  // Wait for the latch of a pinned page
+    RC unlatchPage   (OpenFile *file, PageNum pageNum);
+    void discardFile (const FileId &id);                                // Drop all frames of a file without writing
+
+protected:
+    BufferManager();                                                    // Constructor
+    ~BufferManager();                                                   // Destructor
+
+private:
+    static BufferManager *_bf_manager;
+
+    char *pool;
+    vector<Frame> frames;
+    unordered_map<PageId, unsigned, PageIdHash> pageTable;
+    unsigned clockHand;
+    mutex latch;        // Protects the page table and frame metadata
+    condition_variable ioDone;     // Signalled when a busy frame finishes its transfer
+
+    // Private helper methods
+    RC findVictim(unsigned &frameNum, unique_lock<mutex> &guard);
+    RC readFrame(Frame &frame);
+    RC writeFrame(Frame &frame);
+    RC writeBack(Frame &frame, unique_lock<mutex> &guard);     // writeFrame with the latch dropped
+    Frame *lookup(OpenFile *file, PageNum pageNum);
+};
+
+
 class FileHandle
 {
 public:
-    // variables to keep the counter for each operation
+    // variables to keep the counter for each operation. Threads sharing a handle update them
+    // without synchronization, so they are only approximate then
     unsigned readPageCounter;
     unsigned writePageCounter;
     unsigned appendPageCounter;
-    
+
     FileHandle();                                                       // Default constructor
     ~FileHandle();                                                      // Destructor
 
@@ -65,15 +235,41 @@ public:
     unsigned getNumberOfPages();                                        // Get the number of pages in the file
     RC collectCounterValues(unsigned &readPageCount, unsigned &writePageCount, unsigned &appendPageCount);  // Put the current counter values into variables
 
+    // Work directly on a buffer pool frame instead of a private copy. The frame stays
+    // valid until unpinPage is called; pass dirty = true if the frame was modified.
+    RC fetchPage(PageNum pageNum, void *&data);                         // Pin a page and get its frame
+    RC unpinPage(PageNum pageNum, bool dirty);                          // Release a pinned page
+
+    RC sync();                                                          // Write back dirty pages and make them durable
+
+    // Hint that pageNum will be fetched soon. The OS starts reading it in the background,
+    // so a sequential reader overlaps its I/O with processing the current page.
+    void prefetchPage(PageNum pageNum);
+
+    // Page latches let threads that share a file coordinate access to a page's contents. The
+    // caller must have the page pinned with fetchPage for as long as it holds the latch.
+    // Readers take it shared and writers exclusive; it is not recursive, and the buffer pool
+    // itself never takes it.
+    RC latchPage(PageNum pageNum, bool exclusive);
+    RC unlatchPage(PageNum pageNum);
+
+    // Add count zero-filled pages to the end of the file with a single allocation and
+    // return the number of the first one. Cheaper than appending the pages one by one
+    // when the caller is going to write them anyway.
+    RC allocatePages(unsigned count, PageNum &firstPage);
+    // Re-read the page count from the file, e.g. after it was extended by another process
+    RC refreshNumberOfPages();
+
     // Let PagedFileManager access our private helper methods
     friend class PagedFileManager;
 
 private:
-    FILE *_fd;
+    OpenFile *_file;
 
     // Private helper methods
-    void setfd(FILE *fd);
-    FILE *getfd();
-}; 
+    void setFile(OpenFile *file);
+    OpenFile *getFile();
+    RC maybeSync();
+};
 
 #endif
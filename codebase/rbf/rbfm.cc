@@ -40,14 +40,22 @@ RC RecordBasedFileManager::createFile(const string &fileName)
     void * firstPageData = calloc(PAGE_SIZE, 1);
     if (firstPageData == NULL)
         return RBFM_MALLOC_FAILED;
-    newRecordBasedPage(firstPageData);
 
-    // Adds the first record based page.
+    // Adds an empty free-space map root, then the first record based page (and its FSM leaf).
     FileHandle handle;
     if (_pf_manager->openFile(fileName.c_str(), handle))
         return RBFM_OPEN_FAILED;
+    FreeSpaceMapHeader header;
+    header.magic = FSM_MAGIC;
+    header.version = FSM_VERSION;
+    memcpy(firstPageData, &header, sizeof(FreeSpaceMapHeader));
     if (handle.appendPage(firstPageData))
         return RBFM_APPEND_FAILED;
+    memset(firstPageData, 0, PAGE_SIZE);
+    newRecordBasedPage(firstPageData);
+    PageNum pageNum;
+    if (appendDataPage(handle, firstPageData, pageNum))
+        return RBFM_APPEND_FAILED;
     _pf_manager->closeFile(handle);
 
     free(firstPageData);
@@ -62,7 +70,25 @@ RC RecordBasedFileManager::destroyFile(const string &fileName)
 
 RC RecordBasedFileManager::openFile(const string &fileName, FileHandle &fileHandle) 
 {
-    return _pf_manager->openFile(fileName.c_str(), fileHandle);
+    RC rc = _pf_manager->openFile(fileName.c_str(), fileHandle);
+    if (rc)
+        return rc;
+
+    // Only files laid out around a free-space map can be used
+    void *root;
+    if (fileHandle.getNumberOfPages() == 0 || fileHandle.fetchPage(FSM_ROOT_PAGE, root))
+    {
+        _pf_manager->closeFile(fileHandle);
+        return RBFM_BAD_FORMAT;
+    }
+    bool valid = getRootClasses(root) != NULL;
+    fileHandle.unpinPage(FSM_ROOT_PAGE, false);
+    if (!valid)
+    {
+        _pf_manager->closeFile(fileHandle);
+        return RBFM_BAD_FORMAT;
+    }
+    return SUCCESS;
 }
 
 RC RecordBasedFileManager::closeFile(FileHandle &fileHandle) 
@@ -70,87 +96,163 @@ RC RecordBasedFileManager::closeFile(FileHandle &fileHandle)
     return _pf_manager->closeFile(fileHandle);
 }
 
+RC RecordBasedFileManager::flush(FileHandle &fileHandle)
+{
+    if (fileHandle.sync())
+        return RBFM_FLUSH_FAILED;
+    return SUCCESS;
+}
+
 RC RecordBasedFileManager::insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid) 
 {
     // Gets the size of the record.
     unsigned recordSize = getRecordSize(recordDescriptor, data);
 
-    // Cycles through pages looking for enough free space for the new entry.
-    void *pageData = malloc(PAGE_SIZE);
-    if (pageData == NULL)
-        return RBFM_MALLOC_FAILED;
-    bool pageFound = false;
-    unsigned i;
-    unsigned numPages = fileHandle.getNumberOfPages();
-    for (i = 0; i < numPages; i++)
+    // Looks up a page with enough free space (accounting also for the size that will be added to the slot directory)
+    // in the free-space map.
+    void *pageData = NULL;
+    bool pageFound = true;
+    PageNum pageNum;
+    while (pageFound)
     {
-        if (fileHandle.readPage(i, pageData))
+        if (findFreePage(fileHandle, sizeof(SlotDirectoryRecordEntry) + recordSize, pageNum, pageFound))
             return RBFM_READ_FAILED;
+        if (!pageFound)
+            break;
 
-        // When we find a page with enough space (accounting also for the size that will be added to the slot directory), we stop the loop.
-        if (getPageFreeSpaceSize(pageData) >= sizeof(SlotDirectoryRecordEntry) + recordSize)
-        {
-            pageFound = true;
+        // Look at the cached frame directly; the page is modified in place
+        if (fileHandle.fetchPage(pageNum, pageData))
+            return RBFM_READ_FAILED;
+        unsigned freeSpace = getPageFreeSpaceSize(pageData);
+        if (freeSpace >= sizeof(SlotDirectoryRecordEntry) + recordSize)
             break;
-        }
+
+        // The map was out of date; correct it and look again
+        fileHandle.unpinPage(pageNum, false);
+        if (updateFreeSpaceMap(fileHandle, pageNum, freeSpace))
+            return RBFM_WRITE_FAILED;
     }
 
     // If we can't find a page with enough space, we create a new one
     if(!pageFound)
     {
+        pageData = malloc(PAGE_SIZE);
+        if (pageData == NULL)
+            return RBFM_MALLOC_FAILED;
         newRecordBasedPage(pageData);
     }
 
-    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
-
-    // Setting the return RID.
-    rid.pageNum = i;
-    rid.slotNum = getOpenSlot(pageData);
-
-    // Adding the new record reference in the slot directory.
-    SlotDirectoryRecordEntry newRecordEntry;
-    newRecordEntry.length = recordSize;
-    newRecordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
-    setSlotDirectoryRecordEntry(pageData, rid.slotNum, newRecordEntry);
-
-    // Updating the slot directory header.
-    slotHeader.freeSpaceOffset = newRecordEntry.offset;
-    if (rid.slotNum == slotHeader.recordEntriesNumber)
-        slotHeader.recordEntriesNumber += 1;
-    setSlotDirectoryHeader(pageData, slotHeader);
-
-    // Adding the record data.
-    setRecordAtOffset (pageData, newRecordEntry.offset, recordDescriptor, data);
+    // Setting the return RID. The page number of a new page is only known once it is appended.
+    rid.slotNum = placeRecord(pageData, recordDescriptor, data, recordSize);
 
     // Writing the page to disk.
     if (pageFound)
     {
-        if (fileHandle.writePage(i, pageData))
+        unsigned freeSpace = getPageFreeSpaceSize(pageData);
+        // Releasing the frame marks it dirty; it is written back lazily
+        if (fileHandle.unpinPage(pageNum, true))
+            return RBFM_WRITE_FAILED;
+        if (updateFreeSpaceMap(fileHandle, pageNum, freeSpace))
             return RBFM_WRITE_FAILED;
     }
     else
     {
-        if (fileHandle.appendPage(pageData))
+        RC rc = appendDataPage(fileHandle, pageData, pageNum);
+        free(pageData);
+        if (rc)
             return RBFM_APPEND_FAILED;
     }
+    rid.pageNum = pageNum;
+
+    return SUCCESS;
+}
+
+RC RecordBasedFileManager::insertRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<const void*> &data, vector<RID> &rids)
+{
+    rids.resize(data.size());
+
+    unsigned i = 0;
+    while (i < data.size())
+    {
+        // Pick a page for the next record like insertRecord does, but then keep filling it
+        unsigned recordSize = getRecordSize(recordDescriptor, data[i]);
+        PageNum pageNum;
+        bool pageFound;
+        if (findFreePage(fileHandle, sizeof(SlotDirectoryRecordEntry) + recordSize, pageNum, pageFound))
+            return RBFM_READ_FAILED;
+
+        void *pageData;
+        if (pageFound)
+        {
+            if (fileHandle.fetchPage(pageNum, pageData))
+                return RBFM_READ_FAILED;
+            if (getPageFreeSpaceSize(pageData) < sizeof(SlotDirectoryRecordEntry) + recordSize)
+            {
+                // The map was out of date; correct it and look again
+                unsigned freeSpace = getPageFreeSpaceSize(pageData);
+                fileHandle.unpinPage(pageNum, false);
+                if (updateFreeSpaceMap(fileHandle, pageNum, freeSpace))
+                    return RBFM_WRITE_FAILED;
+                continue;
+            }
+        }
+        else
+        {
+            pageData = malloc(PAGE_SIZE);
+            if (pageData == NULL)
+                return RBFM_MALLOC_FAILED;
+            newRecordBasedPage(pageData);
+        }
+
+        // Pack records into the page for as long as they fit. A new page always takes at least one.
+        unsigned first = i;
+        do
+        {
+            rids[i].slotNum = placeRecord(pageData, recordDescriptor, data[i], recordSize);
+            if (++i == data.size())
+                break;
+            recordSize = getRecordSize(recordDescriptor, data[i]);
+        }
+        while (getPageFreeSpaceSize(pageData) >= sizeof(SlotDirectoryRecordEntry) + recordSize);
+
+        // Write the whole page once
+        unsigned freeSpace = getPageFreeSpaceSize(pageData);
+        if (pageFound)
+        {
+            if (fileHandle.unpinPage(pageNum, true))
+                return RBFM_WRITE_FAILED;
+            if (updateFreeSpaceMap(fileHandle, pageNum, freeSpace))
+                return RBFM_WRITE_FAILED;
+        }
+        else
+        {
+            RC rc = appendDataPage(fileHandle, pageData, pageNum);
+            free(pageData);
+            if (rc)
+                return RBFM_APPEND_FAILED;
+        }
+
+        for (unsigned j = first; j < i; j++)
+            rids[j].pageNum = pageNum;
+    }
 
-    free(pageData);
     return SUCCESS;
 }
 
 RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data) 
 {
-    // Retrieve the specific page
-    void *pageData = malloc(PAGE_SIZE);
-    if (pageData == NULL)
-        return RBFM_MALLOC_FAILED;
-    if (fileHandle.readPage(rid.pageNum, pageData))
+    // Pin the specific page, reading straight out of the buffer pool frame
+    void *pageData;
+    if (fileHandle.fetchPage(rid.pageNum, pageData))
         return RBFM_READ_FAILED;
 
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
     if(slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        fileHandle.unpinPage(rid.pageNum, false);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -160,11 +262,11 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
     {
         // Error to read a deleted record
         case DEAD:
-            free(pageData);
+            fileHandle.unpinPage(rid.pageNum, false);
             return RBFM_READ_AFTER_DEL;
         // Get the forwarding address from the record entry and recurse
         case MOVED:
-            free(pageData);
+            fileHandle.unpinPage(rid.pageNum, false);
             RID newRid;
             newRid.pageNum = recordEntry.length;
             newRid.slotNum = -recordEntry.offset;
@@ -173,7 +275,7 @@ RC RecordBasedFileManager::readRecord(FileHandle &fileHandle, const vector<Attri
         case VALID:
             int32_t offset = recordEntry.offset;
             getRecordAtOffset(pageData, offset, recordDescriptor, data);
-            free(pageData);
+            fileHandle.unpinPage(rid.pageNum, false);
             return SUCCESS;
     }
     // Not possible to reach this point, but compiler doesn't know that
@@ -223,6 +325,8 @@ RC RecordBasedFileManager::deleteRecord(FileHandle &fileHandle, const vector<Att
     
     // Once we've deleted the page(s), write changes to disk
     RC rc = fileHandle.writePage(rid.pageNum, pageData);
+    if (rc == SUCCESS)
+        rc = updateFreeSpaceMap(fileHandle, rid.pageNum, getPageFreeSpaceSize(pageData));
     free(pageData);
     return rc;
 }
@@ -287,6 +391,8 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
         setSlotDirectoryRecordEntry(pageData, rid.slotNum, recordEntry);
         reorganizePage(pageData);
         RC rc = fileHandle.writePage(rid.pageNum, pageData);
+        if (rc == SUCCESS)
+            rc = updateFreeSpaceMap(fileHandle, rid.pageNum, getPageFreeSpaceSize(pageData));
         free(pageData);
         return rc;
     }
@@ -332,6 +438,8 @@ RC RecordBasedFileManager::updateRecord(FileHandle &fileHandle, const vector<Att
         }
     }
     RC rc = fileHandle.writePage(rid.pageNum, pageData);
+    if (rc == SUCCESS)
+        rc = updateFreeSpaceMap(fileHandle, rid.pageNum, getPageFreeSpaceSize(pageData));
     free(pageData);
     return rc;
 }
@@ -402,19 +510,17 @@ RC RecordBasedFileManager::printRecord(const vector<Attribute> &recordDescriptor
 
 RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, const string &attributeName, void *data)
 {
-    char *pageData = (char*)malloc(PAGE_SIZE);
-    if (pageData == NULL)
-        return RBFM_MALLOC_FAILED;
-    if (fileHandle.readPage(rid.pageNum, pageData) != SUCCESS)
-    {
-        free(pageData);
+    void *pageData;
+    if (fileHandle.fetchPage(rid.pageNum, pageData) != SUCCESS)
         return RBFM_READ_FAILED;
-    }
     // Get record header, recurse if forwarded
     // Checks if the specific slot id exists in the page
     SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(pageData);
-    if(slotHeader.recordEntriesNumber < rid.slotNum)
+    if(slotHeader.recordEntriesNumber <= rid.slotNum)
+    {
+        fileHandle.unpinPage(rid.pageNum, false);
         return RBFM_SLOT_DN_EXIST;
+    }
 
     // Gets the slot directory record entry data
     SlotDirectoryRecordEntry recordEntry = getSlotDirectoryRecordEntry(pageData, rid.slotNum);
@@ -424,11 +530,11 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     {
         // Error to get attribute of a deleted record
         case DEAD:
-            free(pageData);
+            fileHandle.unpinPage(rid.pageNum, false);
             return RBFM_READ_AFTER_DEL;
         // Get the forwarding address from the record entry and recurse
         case MOVED:
-            free(pageData);
+            fileHandle.unpinPage(rid.pageNum, false);
             RID newRid;
             newRid.pageNum = recordEntry.length;
             newRid.slotNum = -recordEntry.offset;
@@ -444,11 +550,14 @@ RC RecordBasedFileManager::readAttribute(FileHandle &fileHandle, const vector<At
     auto iterPos = find_if(recordDescriptor.begin(), recordDescriptor.end(), pred);
     unsigned index = distance(recordDescriptor.begin(), iterPos);
     if (index == recordDescriptor.size())
+    {
+        fileHandle.unpinPage(rid.pageNum, false);
         return RBFM_NO_SUCH_ATTR;
+    }
     AttrType type = recordDescriptor[index].type;
     // Write attribute to data
     getAttributeFromRecord(pageData, offset, index, type, data);
-    free(pageData);
+    fileHandle.unpinPage(rid.pageNum, false);
     return SUCCESS;
 }
 
@@ -484,8 +593,10 @@ RC RBFM_ScanIterator::scanInit(FileHandle &fh,
         const void *v, 
         const vector<string> &an)
 {
-    // Start at page 0 slot 0
-    currPage = 0;
+    // Start at the first data page, slot 0
+    currPage = FSM_ROOT_PAGE + 1;
+    while (rbfm->isFreeSpaceMapPage(currPage))
+        currPage++;
     currSlot = 0;
     totalPage = 0;
     totalSlot = 0;
@@ -504,9 +615,9 @@ RC RBFM_ScanIterator::scanInit(FileHandle &fh,
 
     // Get total number of pages
     totalPage = fh.getNumberOfPages();
-    if (totalPage > 0)
+    if (currPage < totalPage)
     {
-        if (fh.readPage(0, pageData))
+        if (fh.readPage(currPage, pageData))
             return RBFM_READ_FAILED;
     }
     else
@@ -617,9 +728,11 @@ RC RBFM_ScanIterator::getNextSlot()
     // If we're done with the current page, or we've read the last page
     if (currSlot >= totalSlot || currPage >= totalPage)
     {
-        // Reinitialize the current slot and increment page number
+        // Reinitialize the current slot and move on to the next data page
         currSlot = 0;
         currPage++;
+        while (rbfm->isFreeSpaceMapPage(currPage))
+            currPage++;
         // If we're done with last page, return EOF
         if (currPage >= totalPage)
             return RBFM_EOF;
@@ -960,7 +1073,7 @@ void RecordBasedFileManager::getRecordAtOffset(void *page, int32_t offset, const
     // If this new recordDescriptor has had fields added to it, we set all of the new fields to null
     for (unsigned i = len; i < recordDescriptor.size(); i++)
     {
-        int indicatorIndex = (i+1) / CHAR_BIT;
+        int indicatorIndex = i / CHAR_BIT;
         int indicatorMask  = 1 << (CHAR_BIT - 1 - (i % CHAR_BIT));
         nullIndicator[indicatorIndex] |= indicatorMask;
     }
@@ -1072,6 +1185,30 @@ void RecordBasedFileManager::reorganizePage(void *page)
     setSlotDirectoryHeader(page, header);
 }
 
+// Adds a record of recordSize bytes to a page with enough free space and returns its slot number
+unsigned RecordBasedFileManager::placeRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned recordSize)
+{
+    SlotDirectoryHeader slotHeader = getSlotDirectoryHeader(page);
+    unsigned slotNum = getOpenSlot(page);
+
+    // Adding the new record reference in the slot directory.
+    SlotDirectoryRecordEntry newRecordEntry;
+    newRecordEntry.length = recordSize;
+    newRecordEntry.offset = slotHeader.freeSpaceOffset - recordSize;
+    setSlotDirectoryRecordEntry(page, slotNum, newRecordEntry);
+
+    // Updating the slot directory header.
+    slotHeader.freeSpaceOffset = newRecordEntry.offset;
+    if (slotNum == slotHeader.recordEntriesNumber)
+        slotHeader.recordEntriesNumber += 1;
+    setSlotDirectoryHeader(page, slotHeader);
+
+    // Adding the record data.
+    setRecordAtOffset (page, newRecordEntry.offset, recordDescriptor, data);
+
+    return slotNum;
+}
+
 void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type, void *data)
 {
     char *start = (char*)page + offset;
@@ -1086,9 +1223,9 @@ void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset,
     char recordNullIndicator[recordNullIndicatorSize];
     memcpy (recordNullIndicator, start + sizeof(RecordLength), recordNullIndicatorSize);
 
-    // Set null indicator for result
+    // Set null indicator for result. Fields added to the table after the record was written are null.
     char resultNullIndicator = 0;
-    if (fieldIsNull(recordNullIndicator, attrIndex))
+    if (attrIndex >= n || fieldIsNull(recordNullIndicator, attrIndex))
         resultNullIndicator |= (1 << 7);
     memcpy(data, &resultNullIndicator, 1);
     data_offset += 1;
@@ -1117,4 +1254,163 @@ void RecordBasedFileManager::getAttributeFromRecord(void *page, unsigned offset,
     }
     // For all types, we then copy the data into the result
     memcpy((char*)data + data_offset, start + attrStart, len);
-}
\ No newline at end of file
+}
+
+// Free-space map helpers ///////////////////////////////////////////////////////////////////
+
+// Page 0 and every leaf position hold the free-space map rather than records
+bool RecordBasedFileManager::isFreeSpaceMapPage(PageNum pageNum)
+{
+    return pageNum == FSM_ROOT_PAGE || (pageNum - 1) % (FSM_LEAF_ENTRIES + 1) == 0;
+}
+
+// The leaf classes of the root, after its header
+FreeSpaceClass *RecordBasedFileManager::getRootClasses(void *root)
+{
+    FreeSpaceMapHeader header;
+    memcpy(&header, root, sizeof(FreeSpaceMapHeader));
+    if (header.magic != FSM_MAGIC || header.version != FSM_VERSION)
+        return NULL;
+    return (FreeSpaceClass*) ((char*) root + sizeof(FreeSpaceMapHeader));
+}
+
+// The FSM leaf that covers a data page
+PageNum RecordBasedFileManager::getFreeSpaceMapLeaf(PageNum pageNum)
+{
+    return pageNum - (pageNum - 1) % (FSM_LEAF_ENTRIES + 1);
+}
+
+// Rounding down means a page is never reported to have more room than it has
+FreeSpaceClass RecordBasedFileManager::getFreeSpaceClass(unsigned freeSpace)
+{
+    unsigned freeSpaceClass = freeSpace / FSM_CLASS_SIZE;
+    return freeSpaceClass > UCHAR_MAX ? UCHAR_MAX : freeSpaceClass;
+}
+
+// Find the first data page with at least size bytes free. Reads the root and at most one leaf.
+RC RecordBasedFileManager::findFreePage(FileHandle &fileHandle, unsigned size, PageNum &pageNum, bool &found)
+{
+    found = false;
+
+    // Smallest class that guarantees enough room
+    unsigned needed = (size + FSM_CLASS_SIZE - 1) / FSM_CLASS_SIZE;
+    if (needed > UCHAR_MAX)
+        return SUCCESS;
+
+    unsigned numPages = fileHandle.getNumberOfPages();
+    if (numPages < 2)
+        return SUCCESS;
+    unsigned numLeaves = (numPages - 2) / (FSM_LEAF_ENTRIES + 1) + 1;
+    if (numLeaves > FSM_MAX_LEAVES)
+        numLeaves = FSM_MAX_LEAVES;
+
+    void *root;
+    if (fileHandle.fetchPage(FSM_ROOT_PAGE, root))
+        return RBFM_READ_FAILED;
+    FreeSpaceClass *rootClasses = getRootClasses(root);
+    if (rootClasses == NULL)
+    {
+        fileHandle.unpinPage(FSM_ROOT_PAGE, false);
+        return RBFM_BAD_FORMAT;
+    }
+    unsigned leaf;
+    for (leaf = 0; leaf < numLeaves; leaf++)
+    {
+        if (rootClasses[leaf] >= needed)
+            break;
+    }
+    fileHandle.unpinPage(FSM_ROOT_PAGE, false);
+    if (leaf == numLeaves)
+        return SUCCESS;
+
+    PageNum leafPage = 1 + leaf * (FSM_LEAF_ENTRIES + 1);
+    void *leafData;
+    if (fileHandle.fetchPage(leafPage, leafData))
+        return RBFM_READ_FAILED;
+    FreeSpaceClass *leafClasses = (FreeSpaceClass*) leafData;
+    for (unsigned i = 0; i < FSM_LEAF_ENTRIES && leafPage + 1 + i < numPages; i++)
+    {
+        if (leafClasses[i] >= needed)
+        {
+            pageNum = leafPage + 1 + i;
+            found = true;
+            break;
+        }
+    }
+    fileHandle.unpinPage(leafPage, false);
+
+    return SUCCESS;
+}
+
+// Record the free space of a data page in its leaf, and the leaf's new maximum in the root
+RC RecordBasedFileManager::updateFreeSpaceMap(FileHandle &fileHandle, PageNum pageNum, unsigned freeSpace)
+{
+    PageNum leafPage = getFreeSpaceMapLeaf(pageNum);
+    unsigned leaf = (leafPage - 1) / (FSM_LEAF_ENTRIES + 1);
+    // Pages past the last leaf the root can describe are simply not tracked
+    if (leaf >= FSM_MAX_LEAVES)
+        return SUCCESS;
+
+    // The root is checked before anything is written to what should be the leaf
+    void *root;
+    if (fileHandle.fetchPage(FSM_ROOT_PAGE, root))
+        return RBFM_READ_FAILED;
+    FreeSpaceClass *rootClasses = getRootClasses(root);
+    if (rootClasses == NULL)
+    {
+        fileHandle.unpinPage(FSM_ROOT_PAGE, false);
+        return RBFM_BAD_FORMAT;
+    }
+
+    void *leafData;
+    if (fileHandle.fetchPage(leafPage, leafData))
+    {
+        fileHandle.unpinPage(FSM_ROOT_PAGE, false);
+        return RBFM_READ_FAILED;
+    }
+    FreeSpaceClass *leafClasses = (FreeSpaceClass*) leafData;
+    FreeSpaceClass newClass = getFreeSpaceClass(freeSpace);
+    unsigned entry = pageNum - leafPage - 1;
+    if (leafClasses[entry] == newClass)
+    {
+        fileHandle.unpinPage(leafPage, false);
+        fileHandle.unpinPage(FSM_ROOT_PAGE, false);
+        return SUCCESS;
+    }
+    leafClasses[entry] = newClass;
+    FreeSpaceClass maxClass = *max_element(leafClasses, leafClasses + FSM_LEAF_ENTRIES);
+    if (fileHandle.unpinPage(leafPage, true))
+    {
+        fileHandle.unpinPage(FSM_ROOT_PAGE, false);
+        return RBFM_WRITE_FAILED;
+    }
+
+    bool changed = rootClasses[leaf] != maxClass;
+    rootClasses[leaf] = maxClass;
+    if (fileHandle.unpinPage(FSM_ROOT_PAGE, changed))
+        return RBFM_WRITE_FAILED;
+
+    return SUCCESS;
+}
+
+// Append a record based page, first adding the FSM leaf for it if the file has reached a leaf position
+RC RecordBasedFileManager::appendDataPage(FileHandle &fileHandle, void *page, PageNum &pageNum)
+{
+    pageNum = fileHandle.getNumberOfPages();
+    if (isFreeSpaceMapPage(pageNum))
+    {
+        void *leafData = calloc(PAGE_SIZE, 1);
+        if (leafData == NULL)
+            return RBFM_MALLOC_FAILED;
+        RC rc = fileHandle.appendPage(leafData);
+        free(leafData);
+        if (rc)
+            return RBFM_APPEND_FAILED;
+        pageNum++;
+    }
+
+    if (fileHandle.appendPage(page))
+        return RBFM_APPEND_FAILED;
+
+    return updateFreeSpaceMap(fileHandle, pageNum, getPageFreeSpaceSize(page));
+}
@@ -22,6 +22,8 @@
 #define RBFM_SLOT_DN_EXIST  7
 #define RBFM_READ_AFTER_DEL 8
 #define RBFM_NO_SUCH_ATTR   9
+#define RBFM_FLUSH_FAILED   10
+#define RBFM_BAD_FORMAT     11
 
 using namespace std;
 
@@ -86,6 +88,29 @@ typedef uint16_t ColumnOffset;
 
 typedef uint16_t RecordLength;
 
+// Free-space map (FSM)
+// Page 0 is the FSM root and FSM leaf i is page 1 + i * (FSM_LEAF_ENTRIES + 1); data pages fill
+// the pages in between. A leaf holds one byte per data page following it: the page's free space
+// in units of FSM_CLASS_SIZE, rounded down. Byte i of the root's classes is the largest class in
+// leaf i, so finding a page with room for a record takes two page reads however large the file is.
+// The root starts with a FreeSpaceMapHeader. Files without it, such as those with records on
+// page 0, are refused rather than having free-space bytes written over their data pages.
+#define FSM_ROOT_PAGE     0
+#define FSM_LEAF_ENTRIES  PAGE_SIZE
+#define FSM_CLASS_SIZE    16
+#define FSM_MAGIC         0x4D534652    // "RFSM"
+#define FSM_VERSION       1
+
+typedef uint8_t FreeSpaceClass;
+
+typedef struct FreeSpaceMapHeader
+{
+    uint32_t magic;
+    uint32_t version;
+} FreeSpaceMapHeader;
+
+#define FSM_MAX_LEAVES    (PAGE_SIZE - sizeof(FreeSpaceMapHeader))
+
 
 /********************************************************************************
 The scan iterator is NOT required to be implemented for the part 1 of the project 
@@ -170,6 +195,10 @@ public:
   
   RC closeFile(FileHandle &fileHandle);
 
+  // Make all changes to the file durable. Pages are otherwise written back lazily
+  // and synced when the file is closed.
+  RC flush(FileHandle &fileHandle);
+
   //  Format of the data passed into the function is the following:
   //  [n byte-null-indicators for y fields] [actual value for the first field] [actual value for the second field] ...
   //  1) For y fields, there is n-byte-null-indicators in the beginning of each record.
@@ -186,6 +215,10 @@ public:
   // For example, refer to the Q6 of Project 1 Environment document.
   RC insertRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const void *data, RID &rid);
 
+  // Insert a batch of records, returning their RIDs in the same order. Records are packed into
+  // each page until it is full and every page is written once, rather than once per record.
+  RC insertRecords(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const vector<const void*> &data, vector<RID> &rids);
+
   RC readRecord(FileHandle &fileHandle, const vector<Attribute> &recordDescriptor, const RID &rid, void *data);
   
   // This method will be mainly used for debugging/testing. 
@@ -248,9 +281,19 @@ private:
   unsigned getOpenSlot(void *page);
 
   void markSlotDeleted(void *page, unsigned i);
+  unsigned placeRecord(void *page, const vector<Attribute> &recordDescriptor, const void *data, unsigned recordSize);
 
   void reorganizePage(void *page);
 
+  // Free-space map helpers
+  bool isFreeSpaceMapPage(PageNum pageNum);
+  FreeSpaceClass *getRootClasses(void *root);    // NULL if the root has no valid header
+  PageNum getFreeSpaceMapLeaf(PageNum pageNum);
+  FreeSpaceClass getFreeSpaceClass(unsigned freeSpace);
+  RC findFreePage(FileHandle &fileHandle, unsigned size, PageNum &pageNum, bool &found);
+  RC updateFreeSpaceMap(FileHandle &fileHandle, PageNum pageNum, unsigned freeSpace);
+  RC appendDataPage(FileHandle &fileHandle, void *page, PageNum &pageNum);
+
   void getAttributeFromRecord(void *page, unsigned offset, unsigned attrIndex, AttrType type,void *data);
 };
 
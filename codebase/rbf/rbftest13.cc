@@ -0,0 +1,157 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <chrono>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <dlfcn.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// The paged file layer's system calls are counted by wrapping them here. A definition in the
+// program takes precedence over the C library's for the calls made from librbf.a
+static unsigned fstatCalls = 0;
+static unsigned preadCalls = 0;
+static unsigned pwriteCalls = 0;
+
+extern "C" int fstat(int fd, struct stat *buf)
+{
+    static int (*next)(int, struct stat *) = (int (*)(int, struct stat *)) dlsym(RTLD_NEXT, "fstat");
+    fstatCalls++;
+    return next(fd, buf);
+}
+
+extern "C" ssize_t pread(int fd, void *buf, size_t count, off_t offset)
+{
+    static ssize_t (*next)(int, void *, size_t, off_t) = (ssize_t (*)(int, void *, size_t, off_t)) dlsym(RTLD_NEXT, "pread");
+    preadCalls++;
+    return next(fd, buf, count, offset);
+}
+
+extern "C" ssize_t pwrite(int fd, const void *buf, size_t count, off_t offset)
+{
+    static ssize_t (*next)(int, const void *, size_t, off_t) = (ssize_t (*)(int, const void *, size_t, off_t)) dlsym(RTLD_NEXT, "pwrite");
+    pwriteCalls++;
+    return next(fd, buf, count, offset);
+}
+
+void printCalls(const string &what, unsigned accesses, unsigned fstats, unsigned preads, unsigned pwrites)
+{
+    cout << what << ": " << accesses << " page accesses, " << fstats << " fstat, " << preads << " pread, "
+         << pwrites << " pwrite" << endl;
+}
+
+int RBFTest_13(PagedFileManager *pfm) {
+    // Functions tested
+    // 1. Create File
+    // 2. Open File
+    // 3. Append, read and write pages, counting the system calls they make **
+    // 4. Close and reopen File
+    // 5. Destroy File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cout << endl << "***** In RBF Test Case 13 *****" << endl;
+
+    RC rc;
+    string fileName = "test13";
+    remove(fileName.c_str());
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    FileHandle fileHandle;
+    unsigned fstatsBefore = fstatCalls;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (fstatCalls == fstatsBefore) {
+        // The C library resolved the calls some other way, so nothing is counted
+        cout << "System calls can't be counted here, only the contents are checked." << endl;
+    }
+
+    const unsigned numPages = 500;
+    const unsigned numAccesses = 200000;
+    char data[PAGE_SIZE];
+    char buffer[PAGE_SIZE];
+
+    unsigned fstats = fstatCalls, preads = preadCalls, pwrites = pwriteCalls;
+    for (unsigned i = 0; i < numPages; i++) {
+        memset(data, i % 256, PAGE_SIZE);
+        memcpy(data, &i, sizeof(unsigned));
+        rc = fileHandle.appendPage(data);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+    printCalls("Append", numPages, fstatCalls - fstats, preadCalls - preads, pwriteCalls - pwrites);
+    bool counted = fstatCalls != fstats || preadCalls != preads || pwriteCalls != pwrites || fstatsBefore != fstatCalls;
+
+    // Every access asks for the page count, as the record layer does before each page
+    fstats = fstatCalls;
+    preads = preadCalls;
+    pwrites = pwriteCalls;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < numAccesses; i++) {
+        PageNum pageNum = (i * 7919) % fileHandle.getNumberOfPages();
+        rc = fileHandle.readPage(pageNum, buffer);
+        assert(rc == success && "Reading a page should not fail.");
+        unsigned stored;
+        memcpy(&stored, buffer, sizeof(unsigned));
+        if (stored != pageNum) {
+            cout << "Page " << pageNum << " holds page " << stored << endl;
+            cout << "***** [FAIL] RBF Test Case 13 failed. *****" << endl;
+            return -1;
+        }
+        if (i % 10 == 0) {
+            rc = fileHandle.writePage(pageNum, buffer);
+            assert(rc == success && "Writing a page should not fail.");
+        }
+    }
+    chrono::steady_clock::duration elapsed = chrono::steady_clock::now() - start;
+    unsigned accessFstats = fstatCalls - fstats;
+    printCalls("Read and write", numAccesses, accessFstats, preadCalls - preads, pwriteCalls - pwrites);
+    cout << "Time per access: " << chrono::duration_cast<chrono::nanoseconds>(elapsed).count() / numAccesses
+         << " ns" << endl;
+
+    // Dirty pages reach the file once each when it is closed
+    fstats = fstatCalls;
+    preads = preadCalls;
+    pwrites = pwriteCalls;
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    printCalls("Close", 0, fstatCalls - fstats, preadCalls - preads, pwriteCalls - pwrites);
+
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    if (fileHandle.getNumberOfPages() != numPages) {
+        cout << "The file has " << fileHandle.getNumberOfPages() << " pages instead of " << numPages << endl;
+        cout << "***** [FAIL] RBF Test Case 13 failed. *****" << endl;
+        return -1;
+    }
+    rc = fileHandle.readPage(numPages - 1, buffer);
+    assert(rc == success && "Reading a page should not fail.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    if (counted && accessFstats != 0) {
+        cout << "Page accesses called fstat " << accessFstats << " times." << endl;
+        cout << "***** [FAIL] RBF Test Case 13 failed. *****" << endl;
+        return -1;
+    }
+
+    cout << "RBF Test Case 13 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+
+    PagedFileManager *pfm = PagedFileManager::instance();
+
+    RC rcmain = RBFTest_13(pfm);
+
+    return rcmain;
+}
@@ -0,0 +1,101 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+int RBFTest_14(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Open a paged file without a free-space map as a Record-Based File **
+    // 2. Insert a Record through a handle on such a file **
+    // 3. Create, open and close a Record-Based File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cout << endl << "***** In RBF Test Case 14 *****" << endl;
+
+    RC rc;
+    string fileName = "test14";
+    PagedFileManager *pfm = PagedFileManager::instance();
+    remove(fileName.c_str());
+
+    // A file with a record page where the free-space map root should be, as files had
+    // before there was one: an empty slot directory at page 0
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    char page[PAGE_SIZE];
+    memset(page, 0, PAGE_SIZE);
+    uint16_t freeSpaceOffset = PAGE_SIZE;
+    memcpy(page, &freeSpaceOffset, sizeof(uint16_t));
+    for (unsigned i = 0; i < 2; i++) {
+        rc = fileHandle.appendPage(page);
+        assert(rc == success && "Appending a page should not fail.");
+    }
+
+    // Records can't go into it, and its pages are left as they were
+    vector<Attribute> recordDescriptor;
+    createRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+    void *record = malloc(100);
+    int recordSize = 0;
+    prepareRecord(recordDescriptor.size(), nullsIndicator, 8, "Anteater", 25, 177.8, 6200, record, &recordSize);
+    RID rid;
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc != success && "Inserting into a file without a free-space map should fail.");
+    char returnedPage[PAGE_SIZE];
+    for (unsigned i = 0; i < 2; i++) {
+        rc = fileHandle.readPage(i, returnedPage);
+        assert(rc == success && "Reading a page should not fail.");
+        if (memcmp(page, returnedPage, PAGE_SIZE) != 0) {
+            cout << "Page " << i << " of the old file was changed." << endl;
+            cout << "***** [FAIL] RBF Test Case 14 failed. *****" << endl;
+            return -1;
+        }
+    }
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == RBFM_BAD_FORMAT && "Opening a file without a free-space map should fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    // A file created as a Record-Based File opens
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    rc = rbfm->insertRecord(fileHandle, recordDescriptor, record, rid);
+    assert(rc == success && "Inserting a record should not fail.");
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    free(record);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 14 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    RC rcmain = RBFTest_14(rbfm);
+
+    return rcmain;
+}
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <thread>
+#include <chrono>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Reads a page straight from the file, past the buffer pool, so it shows what has been written
+// out. Returns false if the file doesn't hold the page yet
+bool readFromFile(const string &fileName, PageNum pageNum, char *data)
+{
+    FILE *file = fopen(fileName.c_str(), "rb");
+    if (file == NULL)
+        return false;
+    bool found = fseek(file, (long) pageNum * PAGE_SIZE, SEEK_SET) == 0 &&
+            fread(data, 1, PAGE_SIZE, file) == PAGE_SIZE;
+    fclose(file);
+    return found;
+}
+
+// Checks that the file holds page pageNum filled with value
+bool fileHolds(const string &fileName, PageNum pageNum, char value)
+{
+    char data[PAGE_SIZE];
+    if (!readFromFile(fileName, pageNum, data))
+        return false;
+    for (unsigned i = 0; i < PAGE_SIZE; i++) {
+        if (data[i] != value)
+            return false;
+    }
+    return true;
+}
+
+int RBFTest_15(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create File
+    // 2. Open File in write-back mode, write pages and sync them **
+    // 3. Open File with a sync interval **
+    // 4. Open File in write-through mode **
+    // 5. Close File
+    // 6. Destroy File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cout << endl << "***** In RBF Test Case 15 *****" << endl;
+
+    RC rc;
+    string fileName = "test15";
+    PagedFileManager *pfm = PagedFileManager::instance();
+    remove(fileName.c_str());
+
+    rc = pfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+
+    // Write-back: pages stay dirty in the buffer pool until a sync
+    pfm->setWriteBack(true);
+    pfm->setSyncInterval(0);
+    FileHandle fileHandle;
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    char data[PAGE_SIZE];
+    char buffer[PAGE_SIZE];
+    memset(data, 'a', PAGE_SIZE);
+    rc = fileHandle.appendPage(data);
+    assert(rc == success && "Appending a page should not fail.");
+    memset(data, 'b', PAGE_SIZE);
+    rc = fileHandle.writePage(0, data);
+    assert(rc == success && "Writing a page should not fail.");
+    rc = fileHandle.readPage(0, buffer);
+    assert(rc == success && "Reading a page should not fail.");
+    assert(memcmp(data, buffer, PAGE_SIZE) == 0 && "The page should read back as written.");
+    assert(!readFromFile(fileName, 0, buffer) && "An appended page should not reach the file before a sync.");
+
+    // A sync writes the page out, and a later write waits for the next one
+    rc = fileHandle.sync();
+    assert(rc == success && "Syncing the file should not fail.");
+    assert(fileHolds(fileName, 0, 'b') && "A synced page should be in the file.");
+    memset(data, 'c', PAGE_SIZE);
+    rc = fileHandle.writePage(0, data);
+    assert(rc == success && "Writing a page should not fail.");
+    assert(fileHolds(fileName, 0, 'b') && "A written page should not reach the file before a sync.");
+
+    // So does a flush of the record layer, and a second handle sees the same page
+    rc = rbfm->flush(fileHandle);
+    assert(rc == success && "Flushing the file should not fail.");
+    assert(fileHolds(fileName, 0, 'c') && "A flushed page should be in the file.");
+    FileHandle otherHandle;
+    rc = pfm->openFile(fileName, otherHandle);
+    assert(rc == success && "Opening the file a second time should not fail.");
+    rc = otherHandle.readPage(0, buffer);
+    assert(rc == success && "Reading a page should not fail.");
+    assert(memcmp(data, buffer, PAGE_SIZE) == 0 && "The second handle should read the flushed page.");
+
+    // Closing the last handle syncs too
+    memset(data, 'd', PAGE_SIZE);
+    rc = otherHandle.writePage(0, data);
+    assert(rc == success && "Writing a page should not fail.");
+    rc = pfm->closeFile(otherHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    assert(fileHolds(fileName, 0, 'c') && "Closing one of two handles should not sync the file.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    assert(fileHolds(fileName, 0, 'd') && "Closing the last handle should sync the file.");
+
+    // With a sync interval, a write syncs once the interval has passed since the last sync
+    const unsigned syncInterval = 500;
+    pfm->setSyncInterval(syncInterval);
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    memset(data, 'e', PAGE_SIZE);
+    rc = fileHandle.writePage(0, data);
+    assert(rc == success && "Writing a page should not fail.");
+    assert(fileHolds(fileName, 0, 'd') && "A write within the sync interval should not sync.");
+    this_thread::sleep_for(chrono::milliseconds(syncInterval + 100));
+    memset(data, 'f', PAGE_SIZE);
+    rc = fileHandle.writePage(0, data);
+    assert(rc == success && "Writing a page should not fail.");
+    assert(fileHolds(fileName, 0, 'f') && "A write after the sync interval should sync.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // Write-through: every write reaches the file at once
+    pfm->setSyncInterval(0);
+    pfm->setWriteBack(false);
+    rc = pfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    memset(data, 'g', PAGE_SIZE);
+    rc = fileHandle.writePage(0, data);
+    assert(rc == success && "Writing a page should not fail.");
+    assert(fileHolds(fileName, 0, 'g') && "A write-through write should be in the file.");
+    memset(data, 'h', PAGE_SIZE);
+    rc = fileHandle.appendPage(data);
+    assert(rc == success && "Appending a page should not fail.");
+    assert(fileHolds(fileName, 1, 'h') && "A write-through append should be in the file.");
+    rc = pfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    pfm->setWriteBack(true);
+
+    rc = pfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    cout << "RBF Test Case 15 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    RC rcmain = RBFTest_15(rbfm);
+
+    return rcmain;
+}
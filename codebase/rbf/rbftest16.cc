@@ -0,0 +1,154 @@
+#include <iostream>
+#include <string>
+#include <cassert>
+#include <chrono>
+#include <set>
+#include <sys/stat.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "pfm.h"
+#include "rbfm.h"
+#include "test_util.h"
+
+using namespace std;
+
+// Inserts the records one at a time into fileName and returns the time it took in microseconds
+long insertOneByOne(RecordBasedFileManager *rbfm, const string &fileName, const vector<Attribute> &recordDescriptor,
+        const vector<const void*> &records)
+{
+    RC rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    RID rid;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned i = 0; i < records.size(); i++) {
+        rc = rbfm->insertRecord(fileHandle, recordDescriptor, records[i], rid);
+        assert(rc == success && "Inserting a record should not fail.");
+    }
+    long elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+    return elapsed;
+}
+
+int RBFTest_16(RecordBasedFileManager *rbfm) {
+    // Functions tested
+    // 1. Create Record-Based File
+    // 2. Open Record-Based File
+    // 3. Insert a batch of Records **
+    // 4. Close and reopen Record-Based File
+    // 5. Read the Records back
+    // 6. Destroy Record-Based File
+    // NOTE: "**" signifies the new functions being tested in this test case.
+    cout << endl << "***** In RBF Test Case 16 *****" << endl;
+
+    RC rc;
+    string fileName = "test16";
+    string loopFileName = "test16loop";
+    remove(fileName.c_str());
+    remove(loopFileName.c_str());
+
+    vector<Attribute> recordDescriptor;
+    createLargeRecordDescriptor(recordDescriptor);
+    int nullFieldsIndicatorActualSize = getActualByteForNullsIndicator(recordDescriptor.size());
+    unsigned char *nullsIndicator = (unsigned char *) malloc(nullFieldsIndicatorActualSize);
+    memset(nullsIndicator, 0, nullFieldsIndicatorActualSize);
+
+    const int numRecords = 2000;
+    vector<const void*> records;
+    vector<int> sizes;
+    for (int i = 0; i < numRecords; i++) {
+        void *record = malloc(1000);
+        int size = 0;
+        memset(record, 0, 1000);
+        prepareLargeRecord(recordDescriptor.size(), nullsIndicator, i, record, &size);
+        records.push_back(record);
+        sizes.push_back(size);
+    }
+
+    rc = rbfm->createFile(fileName);
+    assert(rc == success && "Creating the file should not fail.");
+    FileHandle fileHandle;
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+
+    vector<RID> rids;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    rc = rbfm->insertRecords(fileHandle, recordDescriptor, records, rids);
+    long batchTime = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    assert(rc == success && "Inserting a batch of records should not fail.");
+    assert(rids.size() == records.size() && "There should be a RID for every record.");
+
+    // Every record gets a slot of its own, and the batch spreads over several pages. A record
+    // that fits into the space an earlier page has left goes there, as with insertRecord, so
+    // the RIDs need not increase
+    set<pair<unsigned, unsigned> > slots;
+    set<unsigned> pageNums;
+    for (unsigned i = 0; i < rids.size(); i++) {
+        if (!slots.insert(make_pair(rids[i].pageNum, rids[i].slotNum)).second) {
+            cout << "RID " << i << " (" << rids[i].pageNum << ", " << rids[i].slotNum << ") is given out twice." << endl;
+            cout << "***** [FAIL] RBF Test Case 16 failed. *****" << endl;
+            return -1;
+        }
+        pageNums.insert(rids[i].pageNum);
+    }
+    unsigned pages = pageNums.size();
+    if (pages < 2) {
+        cout << "The batch fits in " << pages << " page, it should span several." << endl;
+        cout << "***** [FAIL] RBF Test Case 16 failed. *****" << endl;
+        return -1;
+    }
+
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+
+    // The RIDs come back in the order of the records: each one reads back its own record
+    rc = rbfm->openFile(fileName, fileHandle);
+    assert(rc == success && "Opening the file should not fail.");
+    void *returnedData = malloc(1000);
+    for (int i = 0; i < numRecords; i++) {
+        memset(returnedData, 0, 1000);
+        rc = rbfm->readRecord(fileHandle, recordDescriptor, rids[i], returnedData);
+        assert(rc == success && "Reading a record should not fail.");
+        if (memcmp(returnedData, records[i], sizes[i]) != 0) {
+            cout << "Record " << i << " doesn't read back as it was inserted." << endl;
+            cout << "***** [FAIL] RBF Test Case 16 failed. *****" << endl;
+            return -1;
+        }
+    }
+    rc = rbfm->closeFile(fileHandle);
+    assert(rc == success && "Closing the file should not fail.");
+    rc = rbfm->destroyFile(fileName);
+    assert(rc == success && "Destroying the file should not fail.");
+
+    // The same records inserted one at a time
+    long loopTime = insertOneByOne(rbfm, loopFileName, recordDescriptor, records);
+    cout << numRecords << " records on " << pages << " pages: " << loopTime << " us one at a time, "
+         << batchTime << " us as a batch" << endl;
+
+    for (int i = 0; i < numRecords; i++)
+        free((void *) records[i]);
+    free(returnedData);
+    free(nullsIndicator);
+
+    cout << "RBF Test Case 16 Finished! The result will be examined." << endl << endl;
+    return 0;
+}
+
+int main() {
+
+    // To test the functionality of the record-based file manager
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+
+    RC rcmain = RBFTest_16(rbfm);
+
+    return rcmain;
+}
@@ -2,6 +2,7 @@
 #include "rm.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <cstring>
 
 RelationManager* RelationManager::_rm = 0;
@@ -9,56 +10,101 @@ RelationManager* RelationManager::_rm = 0;
 RelationManager* RelationManager::instance()
 {
     if(!_rm)
+    {
         _rm = new RelationManager();
+        atexit(shutdown);
+    }
 
     return _rm;
 }
 
 RelationManager::RelationManager()
-: tableDescriptor(createTableDescriptor()), columnDescriptor(createColumnDescriptor())
+: tableDescriptor(createTableDescriptor()), columnDescriptor(createColumnDescriptor()),
+  indexDescriptor(createIndexDescriptor())
 {
 }
 
 RelationManager::~RelationManager()
 {
+    // Close all table files, which writes back their dirty pages
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    for (auto entry : tables)
+    {
+        rbfm->closeFile(entry.second->fileHandle);
+        delete entry.second;
+    }
+    tables.clear();
+
+    // And the index files, which writes back their metadata
+    IndexManager *ix = IndexManager::instance();
+    for (auto entry : indexFiles)
+    {
+        ix->closeFile(entry.second->ixfileHandle);
+        delete entry.second;
+    }
+    indexFiles.clear();
+}
+
+// Table and index files are kept open between calls, so close them before the process exits
+void RelationManager::shutdown()
+{
+    delete _rm;
+    _rm = 0;
 }
 
 RC RelationManager::createCatalog()
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
-    // Create both tables and columns tables, return error if either fails
+    catalog.clear();
+    closeTable(getFileName(TABLES_TABLE_NAME));
+    closeTable(getFileName(COLUMNS_TABLE_NAME));
+    closeTable(getFileName(INDEXES_TABLE_NAME));
+    // Create the tables, columns and indexes tables, return error if any fails
     RC rc;
     rc = rbfm->createFile(getFileName(TABLES_TABLE_NAME));
     if (rc)
         return rc;
     rc = rbfm->createFile(getFileName(COLUMNS_TABLE_NAME));
+    if (rc)
+        return rc;
+    rc = rbfm->createFile(getFileName(INDEXES_TABLE_NAME));
     if (rc)
         return rc;
 
-    // Add table entries for both Tables and Columns
+    // Add table entries for Tables, Columns and Indexes
     rc = insertTable(TABLES_TABLE_ID, 1, TABLES_TABLE_NAME);
     if (rc)
         return rc;
     rc = insertTable(COLUMNS_TABLE_ID, 1, COLUMNS_TABLE_NAME);
     if (rc)
         return rc;
+    rc = insertTable(INDEXES_TABLE_ID, 1, INDEXES_TABLE_NAME);
+    if (rc)
+        return rc;
 
 
-    // Add entries for tables and columns to Columns table
+    // Add entries for all three to Columns table
     rc = insertColumns(TABLES_TABLE_ID, tableDescriptor);
     if (rc)
         return rc;
     rc = insertColumns(COLUMNS_TABLE_ID, columnDescriptor);
+    if (rc)
+        return rc;
+    rc = insertColumns(INDEXES_TABLE_ID, indexDescriptor);
     if (rc)
         return rc;
 
     return SUCCESS;
 }
 
-// Just delete the the two catalog files
+// Just delete the the three catalog files
 RC RelationManager::deleteCatalog()
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    catalog.clear();
+    closeTable(getFileName(TABLES_TABLE_NAME));
+    closeTable(getFileName(COLUMNS_TABLE_NAME));
+    closeTable(getFileName(INDEXES_TABLE_NAME));
 
     RC rc;
 
@@ -70,6 +116,10 @@ RC RelationManager::deleteCatalog()
     if (rc)
         return rc;
 
+    rc = rbfm->destroyFile(getFileName(INDEXES_TABLE_NAME));
+    if (rc)
+        return rc;
+
     return SUCCESS;
 }
 
@@ -82,6 +132,9 @@ RC RelationManager::createTable(const string &tableName, const vector<Attribute>
     if ((rc = rbfm->createFile(getFileName(tableName))))
         return rc;
 
+    // Nothing about an earlier table of this name may survive in the cache
+    catalog.erase(tableName);
+
     // Get the table's ID
     int32_t id;
     rc = getNextTableID(id);
@@ -106,30 +159,37 @@ RC RelationManager::deleteTable(const string &tableName)
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     RC rc;
 
-    // If this is a system table, we cannot delete it
-    bool isSystem;
-    rc = isSystemTable(isSystem, tableName);
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
-    if (isSystem)
+
+    // If this is a system table, we cannot delete it
+    if (info->system)
         return RM_CANNOT_MOD_SYS_TBL;
 
-    // Delete the rbfm file holding this table's entries
-    rc = rbfm->destroyFile(getFileName(tableName));
+    // Grab the table ID and file name, then forget the cached entry
+    int32_t id = info->id;
+    string fileName = info->fileName;
+    catalog.erase(tableName);
+
+    // Close the table's file and delete it
+    closeTable(fileName);
+    rc = rbfm->destroyFile(fileName);
     if (rc)
         return rc;
 
-    // Grab the table ID
-    int32_t id;
-    rc = getTableID(tableName, id);
+    // Its indexes go with it
+    rc = removeIndexes(id, [](const vector<string> &) {return true;});
     if (rc)
         return rc;
 
     // Open tables file
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(TABLES_TABLE_NAME), fileHandle);
+    TableHandle *table;
+    rc = openTable(getFileName(TABLES_TABLE_NAME), table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
     // Find entry with same table ID
     // Use empty projection because we only care about RID
@@ -142,50 +202,60 @@ RC RelationManager::deleteTable(const string &tableName)
     RID rid;
     rc = rbfm_si.getNextRecord(rid, NULL);
     if (rc)
+    {
+        releaseTable(table);
         return rc;
+    }
 
-    // Delete RID from table and close file
+    // Delete RID from table and release the file
     rbfm->deleteRecord(fileHandle, tableDescriptor, rid);
-    rbfm->closeFile(fileHandle);
+    releaseTable(table);
     rbfm_si.close();
 
     // Delete from Columns table
-    rc = rbfm->openFile(getFileName(COLUMNS_TABLE_NAME), fileHandle);
+    TableHandle *columns;
+    rc = openTable(getFileName(COLUMNS_TABLE_NAME), columns);
     if (rc)
         return rc;
 
     // Find all of the entries whose table-id equal this table's ID
-    rbfm->scan(fileHandle, columnDescriptor, COLUMNS_COL_TABLE_ID, EQ_OP, value, projection, rbfm_si);
+    rbfm->scan(columns->fileHandle, columnDescriptor, COLUMNS_COL_TABLE_ID, EQ_OP, value, projection, rbfm_si);
 
     while((rc = rbfm_si.getNextRecord(rid, NULL)) == SUCCESS)
     {
         // Delete each result with the returned RID
-        rc = rbfm->deleteRecord(fileHandle, columnDescriptor, rid);
+        rc = rbfm->deleteRecord(columns->fileHandle, columnDescriptor, rid);
         if (rc)
-            return rc;
+            break;
     }
+    releaseTable(columns);
+    rbfm_si.close();
     if (rc != RBFM_EOF)
         return rc;
 
-    rbfm->closeFile(fileHandle);
-    rbfm_si.close();
-
     return SUCCESS;
 }
 
 // Fills the given attribute vector with the recordDescriptor of tableName
 RC RelationManager::getAttributes(const string &tableName, vector<Attribute> &attrs)
+{
+    TableInfo *info;
+    RC rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
+
+    attrs = info->attrs;
+    return SUCCESS;
+}
+
+// Reads the recordDescriptor of the table with the given ID from the Columns table
+RC RelationManager::getColumns(int32_t id, vector<Attribute> &attrs)
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     // Clear out any old values
     attrs.clear();
     RC rc;
 
-    int32_t id;
-    rc = getTableID(tableName, id);
-    if (rc)
-        return rc;
-
     void *value = &id;
 
     // We need to get the three values that make up an Attribute: name, type, length
@@ -197,15 +267,19 @@ RC RelationManager::getAttributes(const string &tableName, vector<Attribute> &at
     projection.push_back(COLUMNS_COL_COLUMN_LENGTH);
     projection.push_back(COLUMNS_COL_COLUMN_POSITION);
 
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(COLUMNS_TABLE_NAME), fileHandle);
+    TableHandle *table;
+    rc = openTable(getFileName(COLUMNS_TABLE_NAME), table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
     // Scan through the Column table for all entries whose table-id equals tableName's table id.
     rc = rbfm->scan(fileHandle, columnDescriptor, COLUMNS_COL_TABLE_ID, EQ_OP, value, projection, rbfm_si);
     if (rc)
+    {
+        releaseTable(table);
         return rc;
+    }
 
     RID rid;
     void *data = malloc(COLUMNS_RECORD_DATA_SIZE);
@@ -257,7 +331,7 @@ RC RelationManager::getAttributes(const string &tableName, vector<Attribute> &at
     }
     // Do cleanup
     rbfm_si.close();
-    rbfm->closeFile(fileHandle);
+    releaseTable(table);
     free(data);
     // If we ended on an error, return that error
     if (rc != RBFM_EOF)
@@ -277,35 +351,147 @@ RC RelationManager::getAttributes(const string &tableName, vector<Attribute> &at
     return SUCCESS;
 }
 
+// Reads the indexes of the table with the given ID from the Indexes table. A catalog created
+// before there were indexes has no Indexes table, and its tables have no indexes.
+RC RelationManager::getIndexes(int32_t id, const vector<Attribute> &attrs, vector<IndexInfo> &indexes)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    indexes.clear();
+    RC rc;
+
+    TableHandle *table;
+    rc = openTable(getFileName(INDEXES_TABLE_NAME), table);
+    if (rc == PFM_FILE_DN_EXIST)
+        return SUCCESS;
+    if (rc)
+        return rc;
+
+    RBFM_ScanIterator rbfm_si;
+    vector<string> projection;
+    projection.push_back(INDEXES_COL_COLUMN_NAMES);
+    projection.push_back(INDEXES_COL_FILE_NAME);
+    void *value = &id;
+    rc = rbfm->scan(table->fileHandle, indexDescriptor, INDEXES_COL_TABLE_ID, EQ_OP, value, projection, rbfm_si);
+    if (rc)
+    {
+        releaseTable(table);
+        return rc;
+    }
+
+    RID rid;
+    void *data = malloc(INDEXES_RECORD_DATA_SIZE);
+    while ((rc = rbfm_si.getNextRecord(rid, data)) == SUCCESS)
+    {
+        vector<string> columnNames;
+        IndexInfo index;
+        parseIndexesRecord(data, columnNames, index.fileName);
+
+        // Find the key columns among the table's current columns
+        for (auto name : columnNames)
+        {
+            auto pred = [&](Attribute a) {return a.name == name;};
+            unsigned pos = distance(attrs.begin(), find_if(attrs.begin(), attrs.end(), pred));
+            if (pos == attrs.size())
+            {
+                rc = RM_NO_SUCH_ATTR;
+                break;
+            }
+            index.fields.push_back(pos);
+            index.attrs.push_back(attrs[pos]);
+        }
+        if (rc)
+            break;
+        indexes.push_back(index);
+    }
+    rbfm_si.close();
+    releaseTable(table);
+    free(data);
+    if (rc != RBFM_EOF)
+        return rc;
+
+    return SUCCESS;
+}
+
 RC RelationManager::insertTuple(const string &tableName, const void *data, RID &rid)
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     RC rc;
 
-    // If this is a system table, we cannot modify it
-    bool isSystem;
-    rc = isSystemTable(isSystem, tableName);
+    // Get the table's catalog entry
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
-    if (isSystem)
+
+    // If this is a system table, we cannot modify it
+    if (info->system)
         return RM_CANNOT_MOD_SYS_TBL;
 
-    // Get recordDescriptor
-    vector<Attribute> recordDescriptor;
-    rc = getAttributes(tableName, recordDescriptor);
+    // And get the table's file, which stays open between calls
+    TableHandle *table;
+    rc = openTable(info->fileName, table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
-    // And get fileHandle
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    // Let rbfm store the tuple, then add it to the table's indexes. If an index can't take it,
+    // take the tuple back out so the table and its indexes still agree.
+    rc = rbfm->insertRecord(fileHandle, info->attrs, data, rid);
+    if (rc == SUCCESS)
+    {
+        rc = insertIndexEntries(*info, data, rid);
+        if (rc)
+            rbfm->deleteRecord(fileHandle, info->attrs, rid);
+    }
+    releaseTable(table);
+    return rc;
+}
+
+RC RelationManager::insertTuples(const string &tableName, const vector<const void*> &data, vector<RID> &rids)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    // Get the table's catalog entry
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
 
-    // Let rbfm do all the work
-    rc = rbfm->insertRecord(fileHandle, recordDescriptor, data, rid);
-    rbfm->closeFile(fileHandle);
+    // If this is a system table, we cannot modify it
+    if (info->system)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    // And get the table's file, which stays open between calls
+    TableHandle *table;
+    rc = openTable(info->fileName, table);
+    if (rc)
+        return rc;
+    FileHandle &fileHandle = table->fileHandle;
+
+    // Let rbfm pack the records into pages
+    rc = rbfm->insertRecords(fileHandle, info->attrs, data, rids);
+    if (rc)
+    {
+        releaseTable(table);
+        return rc;
+    }
 
+    // Then index them. If that fails part way, undo the whole batch like insertTuple does.
+    unsigned indexed = 0;
+    while (indexed < rids.size() && (rc = insertIndexEntries(*info, data[indexed], rids[indexed])) == SUCCESS)
+        indexed++;
+    if (rc)
+    {
+        for (unsigned i = 0; i < rids.size(); i++)
+        {
+            if (i < indexed)
+                deleteIndexEntries(*info, data[i], rids[i]);
+            rbfm->deleteRecord(fileHandle, info->attrs, rids[i]);
+        }
+        rids.clear();
+    }
+    releaseTable(table);
     return rc;
 }
 
@@ -314,30 +500,38 @@ RC RelationManager::deleteTuple(const string &tableName, const RID &rid)
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     RC rc;
 
-    // If this is a system table, we cannot modify it
-    bool isSystem;
-    rc = isSystemTable(isSystem, tableName);
+    // Get the table's catalog entry
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
-    if (isSystem)
+
+    // If this is a system table, we cannot modify it
+    if (info->system)
         return RM_CANNOT_MOD_SYS_TBL;
 
-    // Get recordDescriptor
-    vector<Attribute> recordDescriptor;
-    rc = getAttributes(tableName, recordDescriptor);
+    // And get the table's file, which stays open between calls
+    TableHandle *table;
+    rc = openTable(info->fileName, table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
-    // And get fileHandle
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(tableName), fileHandle);
-    if (rc)
-        return rc;
+    // The index entries of the tuple are found by its key columns, so read it first
+    void *tuple = NULL;
+    if (!info->indexes.empty())
+    {
+        tuple = malloc(PAGE_SIZE);
+        rc = rbfm->readRecord(fileHandle, info->attrs, rid, tuple);
+    }
 
-    // Let rbfm do all the work
-    rc = rbfm->deleteRecord(fileHandle, recordDescriptor, rid);
-    rbfm->closeFile(fileHandle);
+    if (rc == SUCCESS)
+        rc = rbfm->deleteRecord(fileHandle, info->attrs, rid);
+    releaseTable(table);
+    if (rc == SUCCESS && tuple != NULL)
+        rc = deleteIndexEntries(*info, tuple, rid);
 
+    free(tuple);
     return rc;
 }
 
@@ -346,30 +540,59 @@ RC RelationManager::updateTuple(const string &tableName, const void *data, const
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     RC rc;
 
-    // If this is a system table, we cannot modify it
-    bool isSystem;
-    rc = isSystemTable(isSystem, tableName);
+    // Get the table's catalog entry
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
-    if (isSystem)
+
+    // If this is a system table, we cannot modify it
+    if (info->system)
         return RM_CANNOT_MOD_SYS_TBL;
 
-    // Get recordDescriptor
-    vector<Attribute> recordDescriptor;
-    rc = getAttributes(tableName, recordDescriptor);
+    // And get the table's file, which stays open between calls
+    TableHandle *table;
+    rc = openTable(info->fileName, table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
-    // And get fileHandle
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(tableName), fileHandle);
-    if (rc)
-        return rc;
+    void *tuple = NULL;
+    if (!info->indexes.empty())
+    {
+        tuple = malloc(PAGE_SIZE);
+        rc = rbfm->readRecord(fileHandle, info->attrs, rid, tuple);
+    }
 
-    // Let rbfm do all the work
-    rc = rbfm->updateRecord(fileHandle, recordDescriptor, data, rid);
-    rbfm->closeFile(fileHandle);
+    // The tuple keeps its RID, so only indexes whose key columns changed need new entries
+    if (rc == SUCCESS)
+        rc = rbfm->updateRecord(fileHandle, info->attrs, data, rid);
+    releaseTable(table);
+    if (rc == SUCCESS && tuple != NULL)
+    {
+        IndexManager *ix = IndexManager::instance();
+        char oldKey[PAGE_SIZE];
+        char newKey[PAGE_SIZE];
+        for (unsigned i = 0; i < info->indexes.size() && rc == SUCCESS; i++)
+        {
+            const IndexInfo &index = info->indexes[i];
+            unsigned oldSize = getKeyTuple(info->attrs, index, tuple, oldKey);
+            unsigned newSize = getKeyTuple(info->attrs, index, data, newKey);
+            if (oldSize == newSize && memcmp(oldKey, newKey, oldSize) == 0)
+                continue;
+
+            IndexHandle *indexHandle;
+            rc = openIndex(index.fileName, indexHandle);
+            if (rc)
+                break;
+            rc = ix->deleteEntry(indexHandle->ixfileHandle, index.attrs, oldKey, rid);
+            if (rc == SUCCESS)
+                rc = ix->insertEntry(indexHandle->ixfileHandle, index.attrs, newKey, rid);
+            releaseIndex(indexHandle);
+        }
+    }
 
+    free(tuple);
     return rc;
 }
 
@@ -378,21 +601,22 @@ RC RelationManager::readTuple(const string &tableName, const RID &rid, void *dat
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     RC rc;
 
-    // Get record descriptor
-    vector<Attribute> recordDescriptor;
-    rc = getAttributes(tableName, recordDescriptor);
+    // Get the table's catalog entry
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
 
-    // And get fileHandle
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    // And get the table's file, which stays open between calls
+    TableHandle *table;
+    rc = openTable(info->fileName, table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
     // Let rbfm do all the work
-    rc = rbfm->readRecord(fileHandle, recordDescriptor, rid, data);
-    rbfm->closeFile(fileHandle);
+    rc = rbfm->readRecord(fileHandle, info->attrs, rid, data);
+    releaseTable(table);
     return rc;
 }
 
@@ -408,21 +632,589 @@ RC RelationManager::readAttribute(const string &tableName, const RID &rid, const
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     RC rc;
 
-    vector<Attribute> recordDescriptor;
-    rc = getAttributes(tableName, recordDescriptor);
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
+
+    TableHandle *table;
+    rc = openTable(info->fileName, table);
+    if (rc)
+        return rc;
+    FileHandle &fileHandle = table->fileHandle;
+
+    rc = rbfm->readAttribute(fileHandle, info->attrs, rid, attributeName, data);
+    releaseTable(table);
+    return rc;
+}
+
+RC RelationManager::addAttribute(const string &tableName, const Attribute &attr)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
+    if (info->system)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    // The new column goes last. Existing records have fewer fields, which read back as null.
+    int32_t id = info->id;
+    int32_t pos = info->attrs.size() + 1;
+    catalog.erase(tableName);
+
+    TableHandle *table;
+    rc = openTable(getFileName(COLUMNS_TABLE_NAME), table);
+    if (rc)
+        return rc;
+    FileHandle &fileHandle = table->fileHandle;
+
+    void *columnData = malloc(COLUMNS_RECORD_DATA_SIZE);
+    RID rid;
+    prepareColumnsRecordData(id, pos, attr, columnData);
+    rc = rbfm->insertRecord(fileHandle, columnDescriptor, columnData, rid);
+
+    releaseTable(table);
+    free(columnData);
+    return rc;
+}
+
+RC RelationManager::dropAttribute(const string &tableName, const string &attributeName)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    RC rc;
+
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
+    if (info->system)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    // Find the column and build the descriptor without it
+    vector<Attribute> oldDescriptor = info->attrs;
+    auto pred = [&](Attribute a) {return a.name == attributeName;};
+    auto iterPos = find_if(oldDescriptor.begin(), oldDescriptor.end(), pred);
+    unsigned index = distance(oldDescriptor.begin(), iterPos);
+    if (index == oldDescriptor.size())
+        return RM_NO_SUCH_ATTR;
+    vector<Attribute> newDescriptor = oldDescriptor;
+    newDescriptor.erase(newDescriptor.begin() + index);
+
+    int32_t id = info->id;
+    string fileName = info->fileName;
+    catalog.erase(tableName);
+
+    // Indexes over the column go with it. The others find their columns again by name
+    auto hasColumn = [&](const vector<string> &names)
+        {return find(names.begin(), names.end(), attributeName) != names.end();};
+    rc = removeIndexes(id, hasColumn);
+    if (rc)
+        return rc;
+
+    // Rewrite every record without the column, so stored records keep matching the descriptor.
+    // Records only shrink, so they are updated in place and keep their RIDs.
+    TableHandle *table;
+    rc = openTable(fileName, table);
+    if (rc)
+        return rc;
+    FileHandle &fileHandle = table->fileHandle;
+
+    RBFM_ScanIterator rbfm_si;
+    vector<string> projection; // Empty, we only need the RIDs
+    vector<RID> rids;
+    RID rid;
+    rbfm->scan(fileHandle, oldDescriptor, "", NO_OP, NULL, projection, rbfm_si);
+    while ((rc = rbfm_si.getNextRecord(rid, NULL)) == SUCCESS)
+        rids.push_back(rid);
+    rbfm_si.close();
+    if (rc != RBFM_EOF)
+    {
+        releaseTable(table);
+        return rc;
+    }
+
+    void *tuple = malloc(PAGE_SIZE);
+    void *data = malloc(PAGE_SIZE);
+    rc = SUCCESS;
+    for (unsigned i = 0; i < rids.size() && rc == SUCCESS; i++)
+    {
+        rc = rbfm->readRecord(fileHandle, oldDescriptor, rids[i], tuple);
+        if (rc)
+            break;
+        dropField(oldDescriptor, index, tuple, data);
+        rc = rbfm->updateRecord(fileHandle, newDescriptor, data, rids[i]);
+    }
+    free(tuple);
+    free(data);
+    releaseTable(table);
+    if (rc)
+        return rc;
+
+    // Delete the column's entry and move the columns after it up by one position
+    TableHandle *columns;
+    rc = openTable(getFileName(COLUMNS_TABLE_NAME), columns);
+    if (rc)
+        return rc;
+
+    void *value = &id;
+    rids.clear();
+    rbfm->scan(columns->fileHandle, columnDescriptor, COLUMNS_COL_TABLE_ID, EQ_OP, value, projection, rbfm_si);
+    while ((rc = rbfm_si.getNextRecord(rid, NULL)) == SUCCESS)
+        rids.push_back(rid);
+    rbfm_si.close();
+    if (rc != RBFM_EOF)
+    {
+        releaseTable(columns);
+        return rc;
+    }
+
+    int32_t droppedPos = index + 1;
+    void *columnData = malloc(COLUMNS_RECORD_DATA_SIZE);
+    rc = SUCCESS;
+    for (unsigned i = 0; i < rids.size() && rc == SUCCESS; i++)
+    {
+        rc = rbfm->readRecord(columns->fileHandle, columnDescriptor, rids[i], columnData);
+        if (rc)
+            break;
+
+        // Position is the last field of a Columns record
+        int32_t nameLen;
+        memcpy(&nameLen, (char*) columnData + 1 + INT_SIZE, VARCHAR_LENGTH_SIZE);
+        unsigned posOffset = 1 + INT_SIZE + VARCHAR_LENGTH_SIZE + nameLen + 2 * INT_SIZE;
+        int32_t pos;
+        memcpy(&pos, (char*) columnData + posOffset, INT_SIZE);
+
+        if (pos == droppedPos)
+            rc = rbfm->deleteRecord(columns->fileHandle, columnDescriptor, rids[i]);
+        else if (pos > droppedPos)
+        {
+            pos--;
+            memcpy((char*) columnData + posOffset, &pos, INT_SIZE);
+            rc = rbfm->updateRecord(columns->fileHandle, columnDescriptor, columnData, rids[i]);
+        }
+    }
+    free(columnData);
+    releaseTable(columns);
+    return rc;
+}
+
+RC RelationManager::createIndex(const string &tableName, const vector<string> &attributeNames)
+{
+    return createIndex(tableName, attributeNames, IX_BTREE);
+}
+
+RC RelationManager::createIndex(const string &tableName, const vector<string> &attributeNames, IndexType indexType)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    IndexManager *ix = IndexManager::instance();
+    RC rc;
+
+    TableInfo *info;
+    rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
+    if (info->system)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    // Each key column must be a column of the table, and appear only once
+    if (attributeNames.empty() || attributeNames.size() > IX_MAX_KEY_FIELDS)
+        return RM_BAD_INDEX;
+    IndexInfo index;
+    string columnNames;
+    for (unsigned i = 0; i < attributeNames.size(); i++)
+    {
+        const string &name = attributeNames[i];
+        if (name.find(',') != string::npos || find(attributeNames.begin(), attributeNames.begin() + i, name) != attributeNames.begin() + i)
+            return RM_BAD_INDEX;
+        auto pred = [&](Attribute a) {return a.name == name;};
+        unsigned pos = distance(info->attrs.begin(), find_if(info->attrs.begin(), info->attrs.end(), pred));
+        if (pos == info->attrs.size())
+            return RM_NO_SUCH_ATTR;
+        index.fields.push_back(pos);
+        index.attrs.push_back(info->attrs[pos]);
+        columnNames += (i > 0 ? "," : "") + name;
+    }
+    IndexInfo *existing;
+    if (findIndex(info, attributeNames, existing) == SUCCESS)
+        return RM_INDEX_EXISTS;
+    int32_t id = info->id;
+    index.fileName = getIndexFileName(id, tableName, attributeNames);
+
+    // Collect the key of every tuple
+    TableHandle *table;
+    rc = openTable(info->fileName, table);
+    if (rc)
+        return rc;
+
+    RBFM_ScanIterator rbfm_si;
+    vector<string> projection;
+    for (auto attr : info->attrs)
+        projection.push_back(attr.name);
+    rbfm->scan(table->fileHandle, info->attrs, "", NO_OP, NULL, projection, rbfm_si);
+
+    vector<char> keyData;
+    vector<unsigned> keyOffsets;
+    vector<RID> rids;
+    RID rid;
+    void *tuple = malloc(PAGE_SIZE);
+    char key[PAGE_SIZE];
+    while ((rc = rbfm_si.getNextRecord(rid, tuple)) == SUCCESS)
+    {
+        unsigned keySize = getKeyTuple(info->attrs, index, tuple, key);
+        keyOffsets.push_back(keyData.size());
+        keyData.insert(keyData.end(), key, key + keySize);
+        rids.push_back(rid);
+    }
+    rbfm_si.close();
+    releaseTable(table);
+    free(tuple);
+    if (rc != RBFM_EOF)
+        return rc;
+
+    vector<const void*> keys;
+    for (unsigned i = 0; i < keyOffsets.size(); i++)
+        keys.push_back(&keyData[keyOffsets[i]]);
+
+    // Build the index from them in one pass
+    rc = ix->createFile(index.fileName, indexType);
+    if (rc)
+        return rc;
+    IndexHandle *indexHandle;
+    rc = openIndex(index.fileName, indexHandle);
+    if (rc == SUCCESS)
+    {
+        rc = ix->bulkLoad(indexHandle->ixfileHandle, index.attrs, keys, rids, INDEX_FILL_FACTOR);
+        releaseIndex(indexHandle);
+    }
+
+    // And add it to the Indexes table
+    if (rc == SUCCESS)
+    {
+        TableHandle *indexes;
+        rc = openTable(getFileName(INDEXES_TABLE_NAME), indexes);
+        if (rc == SUCCESS)
+        {
+            void *indexData = malloc(INDEXES_RECORD_DATA_SIZE);
+            prepareIndexesRecordData(id, columnNames, index.fileName, indexData);
+            rc = rbfm->insertRecord(indexes->fileHandle, indexDescriptor, indexData, rid);
+            releaseTable(indexes);
+            free(indexData);
+        }
+    }
     if (rc)
+    {
+        closeIndex(index.fileName);
+        ix->destroyFile(index.fileName);
         return rc;
+    }
+
+    catalog.erase(tableName);
+    return SUCCESS;
+}
+
+RC RelationManager::destroyIndex(const string &tableName, const vector<string> &attributeNames)
+{
+    TableInfo *info;
+    RC rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
+    if (info->system)
+        return RM_CANNOT_MOD_SYS_TBL;
+
+    IndexInfo *index;
+    rc = findIndex(info, attributeNames, index);
+    if (rc)
+        return rc;
+
+    int32_t id = info->id;
+    catalog.erase(tableName);
+    return removeIndexes(id, [&](const vector<string> &names) {return names == attributeNames;});
+}
+
+RC RelationManager::findIndex(TableInfo *info, const vector<string> &attributeNames, IndexInfo *&index)
+{
+    for (auto &candidate : info->indexes)
+    {
+        bool same = candidate.attrs.size() == attributeNames.size();
+        for (unsigned i = 0; same && i < attributeNames.size(); i++)
+            same = candidate.attrs[i].name == attributeNames[i];
+        if (same)
+        {
+            index = &candidate;
+            return SUCCESS;
+        }
+    }
+    return RM_INDEX_DN_EXIST;
+}
+
+// Deletes the Indexes entries of the table with the given ID whose key columns match, and
+// destroys their index files
+RC RelationManager::removeIndexes(int32_t id, const function<bool(const vector<string>&)> &matches)
+{
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    IndexManager *ix = IndexManager::instance();
+    RC rc;
 
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(tableName), fileHandle);
+    TableHandle *table;
+    rc = openTable(getFileName(INDEXES_TABLE_NAME), table);
+    if (rc == PFM_FILE_DN_EXIST)
+        return SUCCESS;
     if (rc)
         return rc;
 
-    rc = rbfm->readAttribute(fileHandle, recordDescriptor, rid, attributeName, data);
-    rbfm->closeFile(fileHandle);
+    RBFM_ScanIterator rbfm_si;
+    vector<string> projection;
+    projection.push_back(INDEXES_COL_COLUMN_NAMES);
+    projection.push_back(INDEXES_COL_FILE_NAME);
+    void *value = &id;
+    rbfm->scan(table->fileHandle, indexDescriptor, INDEXES_COL_TABLE_ID, EQ_OP, value, projection, rbfm_si);
+
+    vector<RID> rids;
+    vector<string> fileNames;
+    RID rid;
+    void *data = malloc(INDEXES_RECORD_DATA_SIZE);
+    while ((rc = rbfm_si.getNextRecord(rid, data)) == SUCCESS)
+    {
+        vector<string> columnNames;
+        string fileName;
+        parseIndexesRecord(data, columnNames, fileName);
+        if (matches(columnNames))
+        {
+            rids.push_back(rid);
+            fileNames.push_back(fileName);
+        }
+    }
+    rbfm_si.close();
+    free(data);
+    if (rc != RBFM_EOF)
+    {
+        releaseTable(table);
+        return rc;
+    }
+
+    rc = SUCCESS;
+    for (unsigned i = 0; i < rids.size() && rc == SUCCESS; i++)
+    {
+        rc = rbfm->deleteRecord(table->fileHandle, indexDescriptor, rids[i]);
+        if (rc)
+            break;
+        closeIndex(fileNames[i]);
+        rc = ix->destroyFile(fileNames[i]);
+    }
+    releaseTable(table);
     return rc;
 }
 
+// Copies the key columns of an index out of a tuple of its table. The key gets its own null
+// indicator, as if it were a tuple of just those columns
+unsigned RelationManager::getKeyTuple(const vector<Attribute> &recordDescriptor, const IndexInfo &index, const void *tuple, void *key)
+{
+    // Find where each field of the tuple is; null fields take no space
+    unsigned nullSize = (recordDescriptor.size() + CHAR_BIT - 1) / CHAR_BIT;
+    const char *nulls = (const char*) tuple;
+    vector<unsigned> offsets(recordDescriptor.size());
+    vector<unsigned> sizes(recordDescriptor.size(), 0);
+    unsigned offset = nullSize;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        offsets[i] = offset;
+        if (nulls[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - (i % CHAR_BIT))))
+            continue;
+        if (recordDescriptor[i].type == TypeVarChar)
+        {
+            uint32_t varcharSize;
+            memcpy(&varcharSize, (const char*) tuple + offset, VARCHAR_LENGTH_SIZE);
+            sizes[i] = VARCHAR_LENGTH_SIZE + varcharSize;
+        }
+        else
+            sizes[i] = INT_SIZE;
+        offset += sizes[i];
+    }
+
+    unsigned keyNullSize = (index.fields.size() + CHAR_BIT - 1) / CHAR_BIT;
+    char *keyNulls = (char*) key;
+    memset(keyNulls, 0, keyNullSize);
+    unsigned keyOffset = keyNullSize;
+    for (unsigned j = 0; j < index.fields.size(); j++)
+    {
+        unsigned i = index.fields[j];
+        if (nulls[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - (i % CHAR_BIT))))
+        {
+            keyNulls[j / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (j % CHAR_BIT));
+            continue;
+        }
+        memcpy((char*) key + keyOffset, (const char*) tuple + offsets[i], sizes[i]);
+        keyOffset += sizes[i];
+    }
+    return keyOffset;
+}
+
+// Adds a tuple to every index of its table. If one of them fails, the entries already added
+// are removed again, so the tuple is in all of the indexes or in none.
+RC RelationManager::insertIndexEntries(const TableInfo &info, const void *tuple, const RID &rid)
+{
+    IndexManager *ix = IndexManager::instance();
+    char key[PAGE_SIZE];
+    for (unsigned i = 0; i < info.indexes.size(); i++)
+    {
+        const IndexInfo &index = info.indexes[i];
+        getKeyTuple(info.attrs, index, tuple, key);
+        IndexHandle *indexHandle;
+        RC rc = openIndex(index.fileName, indexHandle);
+        if (rc == SUCCESS)
+        {
+            rc = ix->insertEntry(indexHandle->ixfileHandle, index.attrs, key, rid);
+            releaseIndex(indexHandle);
+        }
+        if (rc)
+        {
+            deleteIndexEntries(info, tuple, rid, i);
+            return rc;
+        }
+    }
+    return SUCCESS;
+}
+
+// Removes a tuple from every index of its table
+RC RelationManager::deleteIndexEntries(const TableInfo &info, const void *tuple, const RID &rid)
+{
+    return deleteIndexEntries(info, tuple, rid, info.indexes.size());
+}
+
+// Removes a tuple from the first numIndexes indexes of its table
+RC RelationManager::deleteIndexEntries(const TableInfo &info, const void *tuple, const RID &rid, unsigned numIndexes)
+{
+    IndexManager *ix = IndexManager::instance();
+    char key[PAGE_SIZE];
+    for (unsigned i = 0; i < numIndexes; i++)
+    {
+        const IndexInfo &index = info.indexes[i];
+        getKeyTuple(info.attrs, index, tuple, key);
+        IndexHandle *indexHandle;
+        RC rc = openIndex(index.fileName, indexHandle);
+        if (rc)
+            return rc;
+        rc = ix->deleteEntry(indexHandle->ixfileHandle, index.attrs, key, rid);
+        releaseIndex(indexHandle);
+        if (rc)
+            return rc;
+    }
+    return SUCCESS;
+}
+
+// Gets the open handle of a table file, opening the file the first time. The handle stays open
+// after it is released, so later calls on the table don't have to open the file again.
+RC RelationManager::openTable(const string &fileName, TableHandle *&table)
+{
+    auto it = tables.find(fileName);
+    if (it != tables.end())
+    {
+        table = it->second;
+        table->refCount++;
+        return SUCCESS;
+    }
+
+    table = new TableHandle;
+    RC rc = RecordBasedFileManager::instance()->openFile(fileName, table->fileHandle);
+    if (rc)
+    {
+        delete table;
+        table = NULL;
+        return rc;
+    }
+    table->refCount = 1;
+    table->closed = false;
+    tables[fileName] = table;
+    return SUCCESS;
+}
+
+void RelationManager::releaseTable(TableHandle *table)
+{
+    if (table == NULL)
+        return;
+
+    // A table closed while still in use is closed by its last user
+    if (--table->refCount == 0 && table->closed)
+    {
+        RecordBasedFileManager::instance()->closeFile(table->fileHandle);
+        delete table;
+    }
+}
+
+// Closes a table file for good, e.g. before it is destroyed
+void RelationManager::closeTable(const string &fileName)
+{
+    auto it = tables.find(fileName);
+    if (it == tables.end())
+        return;
+
+    TableHandle *table = it->second;
+    tables.erase(it);
+    table->closed = true;
+    if (table->refCount == 0)
+    {
+        RecordBasedFileManager::instance()->closeFile(table->fileHandle);
+        delete table;
+    }
+}
+
+// Gets the open handle of an index file; index files stay open like table files
+RC RelationManager::openIndex(const string &fileName, IndexHandle *&index)
+{
+    auto it = indexFiles.find(fileName);
+    if (it != indexFiles.end())
+    {
+        index = it->second;
+        index->refCount++;
+        return SUCCESS;
+    }
+
+    index = new IndexHandle;
+    RC rc = IndexManager::instance()->openFile(fileName, index->ixfileHandle);
+    if (rc)
+    {
+        delete index;
+        index = NULL;
+        return rc;
+    }
+    index->refCount = 1;
+    index->closed = false;
+    indexFiles[fileName] = index;
+    return SUCCESS;
+}
+
+void RelationManager::releaseIndex(IndexHandle *index)
+{
+    if (index == NULL)
+        return;
+
+    if (--index->refCount == 0 && index->closed)
+    {
+        IndexManager::instance()->closeFile(index->ixfileHandle);
+        delete index;
+    }
+}
+
+// Closes an index file for good, e.g. before it is destroyed
+void RelationManager::closeIndex(const string &fileName)
+{
+    auto it = indexFiles.find(fileName);
+    if (it == indexFiles.end())
+        return;
+
+    IndexHandle *index = it->second;
+    indexFiles.erase(it);
+    index->closed = true;
+    if (index->refCount == 0)
+    {
+        IndexManager::instance()->closeFile(index->ixfileHandle);
+        delete index;
+    }
+}
+
 string RelationManager::getFileName(const char *tableName)
 {
     return string(tableName) + string(TABLE_FILE_EXTENSION);
@@ -433,6 +1225,59 @@ string RelationManager::getFileName(const string &tableName)
     return tableName + string(TABLE_FILE_EXTENSION);
 }
 
+// Index files are named after their table and key columns. The name starts with the table-id,
+// which fixes the table name, and the key columns are joined by commas, which cannot appear in
+// them, so no two indexes share a file.
+string RelationManager::getIndexFileName(int32_t tableID, const string &tableName, const vector<string> &attributeNames)
+{
+    string fileName = to_string(tableID) + "_" + tableName + "_";
+    for (unsigned i = 0; i < attributeNames.size(); i++)
+        fileName += (i > 0 ? "," : "") + attributeNames[i];
+    return fileName + string(INDEX_FILE_EXTENSION);
+}
+
+// Copies tuple into data without the field at index, shifting the null bits of later fields
+void RelationManager::dropField(const vector<Attribute> &recordDescriptor, unsigned index, const void *tuple, void *data)
+{
+    unsigned oldNullSize = (recordDescriptor.size() + CHAR_BIT - 1) / CHAR_BIT;
+    unsigned newNullSize = (recordDescriptor.size() - 1 + CHAR_BIT - 1) / CHAR_BIT;
+    char *oldNulls = (char*) tuple;
+    char *newNulls = (char*) data;
+    memset(newNulls, 0, newNullSize);
+
+    unsigned oldOffset = oldNullSize;
+    unsigned newOffset = newNullSize;
+    unsigned j = 0;
+    for (unsigned i = 0; i < recordDescriptor.size(); i++)
+    {
+        bool isNull = (oldNulls[i / CHAR_BIT] & (1 << (CHAR_BIT - 1 - (i % CHAR_BIT)))) != 0;
+
+        // Size of this field in the tuple
+        unsigned size = 0;
+        if (!isNull)
+        {
+            if (recordDescriptor[i].type == TypeVarChar)
+            {
+                uint32_t varcharSize;
+                memcpy(&varcharSize, (char*) tuple + oldOffset, VARCHAR_LENGTH_SIZE);
+                size = VARCHAR_LENGTH_SIZE + varcharSize;
+            }
+            else
+                size = INT_SIZE;
+        }
+
+        if (i != index)
+        {
+            if (isNull)
+                newNulls[j / CHAR_BIT] |= 1 << (CHAR_BIT - 1 - (j % CHAR_BIT));
+            memcpy((char*) data + newOffset, (char*) tuple + oldOffset, size);
+            newOffset += size;
+            j++;
+        }
+        oldOffset += size;
+    }
+}
+
 vector<Attribute> RelationManager::createTableDescriptor()
 {
     vector<Attribute> td;
@@ -494,6 +1339,29 @@ vector<Attribute> RelationManager::createColumnDescriptor()
     return cd;
 }
 
+vector<Attribute> RelationManager::createIndexDescriptor()
+{
+    vector<Attribute> id;
+
+    Attribute attr;
+    attr.name = INDEXES_COL_TABLE_ID;
+    attr.type = TypeInt;
+    attr.length = (AttrLength)INT_SIZE;
+    id.push_back(attr);
+
+    attr.name = INDEXES_COL_COLUMN_NAMES;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)INDEXES_COL_COLUMN_NAMES_SIZE;
+    id.push_back(attr);
+
+    attr.name = INDEXES_COL_FILE_NAME;
+    attr.type = TypeVarChar;
+    attr.length = (AttrLength)INDEXES_COL_FILE_NAME_SIZE;
+    id.push_back(attr);
+
+    return id;
+}
+
 // Creates the Tables table entry for the given id and tableName
 // Assumes fileName is just tableName + file extension
 void RelationManager::prepareTablesRecordData(int32_t id, bool system, const string &tableName, void *data)
@@ -562,6 +1430,61 @@ void RelationManager::prepareColumnsRecordData(int32_t id, int32_t pos, Attribut
     offset += INT_SIZE;
 }
 
+// Prepares the Indexes table entry for an index; columnNames is the comma separated key columns
+void RelationManager::prepareIndexesRecordData(int32_t id, const string &columnNames, const string &fileName, void *data)
+{
+    unsigned offset = 0;
+    int32_t names_len = columnNames.length();
+    int32_t file_name_len = fileName.length();
+
+    // None will ever be null
+    char null = 0;
+
+    memcpy((char*) data + offset, &null, 1);
+    offset += 1;
+
+    memcpy((char*) data + offset, &id, INT_SIZE);
+    offset += INT_SIZE;
+
+    memcpy((char*) data + offset, &names_len, VARCHAR_LENGTH_SIZE);
+    offset += VARCHAR_LENGTH_SIZE;
+    memcpy((char*) data + offset, columnNames.c_str(), names_len);
+    offset += names_len;
+
+    memcpy((char*) data + offset, &file_name_len, VARCHAR_LENGTH_SIZE);
+    offset += VARCHAR_LENGTH_SIZE;
+    memcpy((char*) data + offset, fileName.c_str(), file_name_len);
+    offset += file_name_len;
+}
+
+// Reads the column-names and file-name fields of an Indexes entry, projected in that order
+void RelationManager::parseIndexesRecord(const void *data, vector<string> &columnNames, string &fileName)
+{
+    // Skip the null indicator, none of these fields is ever null
+    unsigned offset = 1;
+    int32_t names_len;
+    memcpy(&names_len, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+    offset += VARCHAR_LENGTH_SIZE;
+    string names((char*) data + offset, names_len);
+    offset += names_len;
+
+    int32_t file_name_len;
+    memcpy(&file_name_len, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+    offset += VARCHAR_LENGTH_SIZE;
+    fileName = string((char*) data + offset, file_name_len);
+
+    columnNames.clear();
+    size_t start = 0;
+    while (true)
+    {
+        size_t end = names.find(',', start);
+        columnNames.push_back(names.substr(start, end == string::npos ? string::npos : end - start));
+        if (end == string::npos)
+            break;
+        start = end + 1;
+    }
+}
+
 // Insert the given columns into the Columns table
 RC RelationManager::insertColumns(int32_t id, const vector<Attribute> &recordDescriptor)
 {
@@ -569,10 +1492,11 @@ RC RelationManager::insertColumns(int32_t id, const vector<Attribute> &recordDes
 
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
 
-    FileHandle fileHandle;
-    rc = rbfm->openFile(getFileName(COLUMNS_TABLE_NAME), fileHandle);
+    TableHandle *table;
+    rc = openTable(getFileName(COLUMNS_TABLE_NAME), table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
     void *columnData = malloc(COLUMNS_RECORD_DATA_SIZE);
     RID rid;
@@ -582,30 +1506,31 @@ RC RelationManager::insertColumns(int32_t id, const vector<Attribute> &recordDes
         prepareColumnsRecordData(id, pos, recordDescriptor[i], columnData);
         rc = rbfm->insertRecord(fileHandle, columnDescriptor, columnData, rid);
         if (rc)
-            return rc;
+            break;
     }
 
-    rbfm->closeFile(fileHandle);
+    releaseTable(table);
     free(columnData);
-    return SUCCESS;
+    return rc;
 }
 
 RC RelationManager::insertTable(int32_t id, int32_t system, const string &tableName)
 {
-    FileHandle fileHandle;
     RID rid;
     RC rc;
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
 
-    rc = rbfm->openFile(getFileName(TABLES_TABLE_NAME), fileHandle);
+    TableHandle *table;
+    rc = openTable(getFileName(TABLES_TABLE_NAME), table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
     void *tableData = malloc (TABLES_RECORD_DATA_SIZE);
     prepareTablesRecordData(id, system, tableName, tableData);
     rc = rbfm->insertRecord(fileHandle, tableDescriptor, tableData, rid);
 
-    rbfm->closeFile(fileHandle);
+    releaseTable(table);
     free (tableData);
     return rc;
 }
@@ -614,12 +1539,13 @@ RC RelationManager::insertTable(int32_t id, int32_t system, const string &tableN
 RC RelationManager::getNextTableID(int32_t &table_id)
 {
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
-    FileHandle fileHandle;
     RC rc;
 
-    rc = rbfm->openFile(getFileName(TABLES_TABLE_NAME), fileHandle);
+    TableHandle *table;
+    rc = openTable(getFileName(TABLES_TABLE_NAME), table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
     // Grab only the table ID
     vector<string> projection;
@@ -647,7 +1573,7 @@ RC RelationManager::getNextTableID(int32_t &table_id)
     free(data);
     // Next table ID is 1 more than largest table id
     table_id = max_table_id + 1;
-    rbfm->closeFile(fileHandle);
+    releaseTable(table);
     rbfm_si.close();
     return SUCCESS;
 }
@@ -655,87 +1581,104 @@ RC RelationManager::getNextTableID(int32_t &table_id)
 // Gets the table ID of the given tableName
 RC RelationManager::getTableID(const string &tableName, int32_t &tableID)
 {
-    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
-    FileHandle fileHandle;
-    RC rc;
-
-    rc = rbfm->openFile(getFileName(TABLES_TABLE_NAME), fileHandle);
+    TableInfo *info;
+    RC rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
 
-    // We only care about the table ID
-    vector<string> projection;
-    projection.push_back(TABLES_COL_TABLE_ID);
+    tableID = info->id;
+    return SUCCESS;
+}
 
-    // Fill value with the string tablename in api format (without null indicator)
-    void *value = malloc(4 + TABLES_COL_TABLE_NAME_SIZE);
-    int32_t name_len = tableName.length();
-    memcpy(value, &name_len, INT_SIZE);
-    memcpy((char*)value + INT_SIZE, tableName.c_str(), name_len);
+// Determine if table tableName is a system table. Set the boolean argument as the result
+RC RelationManager::isSystemTable(bool &system, const string &tableName)
+{
+    TableInfo *info;
+    RC rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
 
-    // Find the table entries whose table-name field matches tableName
-    RBFM_ScanIterator rbfm_si;
-    rc = rbfm->scan(fileHandle, tableDescriptor, TABLES_COL_TABLE_NAME, EQ_OP, value, projection, rbfm_si);
+    system = info->system;
+    return SUCCESS;
+}
 
-    // There will only be one such entry, so we use if rather than while
-    RID rid;
-    void *data = malloc (1 + INT_SIZE);
-    if ((rc = rbfm_si.getNextRecord(rid, data)) == SUCCESS)
+// Gets the catalog entry of tableName. The Tables, Columns and Indexes tables are only scanned
+// the first time a table is used; afterwards the entry comes from the catalog cache.
+RC RelationManager::getTableInfo(const string &tableName, TableInfo *&info)
+{
+    auto it = catalog.find(tableName);
+    if (it != catalog.end())
     {
-        int32_t tid;
-        fromAPI(tid, data);
-        tableID = tid;
+        info = &it->second;
+        return SUCCESS;
     }
 
-    free(data);
-    free(value);
-    rbfm->closeFile(fileHandle);
-    rbfm_si.close();
-    return rc;
-}
-
-// Determine if table tableName is a system table. Set the boolean argument as the result
-RC RelationManager::isSystemTable(bool &system, const string &tableName)
-{
     RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
-    FileHandle fileHandle;
     RC rc;
 
-    rc = rbfm->openFile(getFileName(TABLES_TABLE_NAME), fileHandle);
+    TableHandle *table;
+    rc = openTable(getFileName(TABLES_TABLE_NAME), table);
     if (rc)
         return rc;
+    FileHandle &fileHandle = table->fileHandle;
 
-    // We only care about system column
     vector<string> projection;
+    projection.push_back(TABLES_COL_TABLE_ID);
+    projection.push_back(TABLES_COL_FILE_NAME);
     projection.push_back(TABLES_COL_SYSTEM);
 
-    // Set up value to be tableName in API format (without null indicator)
-    void *value = malloc(5 + TABLES_COL_TABLE_NAME_SIZE);
+    // Fill value with the string tablename in api format (without null indicator)
+    void *value = malloc(4 + TABLES_COL_TABLE_NAME_SIZE);
     int32_t name_len = tableName.length();
     memcpy(value, &name_len, INT_SIZE);
     memcpy((char*)value + INT_SIZE, tableName.c_str(), name_len);
 
-    // Find table whose table-name is equal to tableName
+    // Find the table entry whose table-name field matches tableName
     RBFM_ScanIterator rbfm_si;
     rc = rbfm->scan(fileHandle, tableDescriptor, TABLES_COL_TABLE_NAME, EQ_OP, value, projection, rbfm_si);
 
+    // There will only be one such entry, so we use if rather than while
     RID rid;
-    void *data = malloc (1 + INT_SIZE);
+    void *data = malloc (TABLES_RECORD_DATA_SIZE);
+    TableInfo entry;
     if ((rc = rbfm_si.getNextRecord(rid, data)) == SUCCESS)
     {
-        // Parse the system field from that table entry
-        int32_t tmp;
-        fromAPI(tmp, data);
-        system = tmp == 1;
+        // Skip the null indicator, none of these fields is ever null
+        unsigned offset = 1;
+        memcpy(&entry.id, (char*) data + offset, INT_SIZE);
+        offset += INT_SIZE;
+
+        int32_t file_name_len;
+        memcpy(&file_name_len, (char*) data + offset, VARCHAR_LENGTH_SIZE);
+        offset += VARCHAR_LENGTH_SIZE;
+        entry.fileName = string((char*) data + offset, file_name_len);
+        offset += file_name_len;
+
+        int32_t system;
+        memcpy(&system, (char*) data + offset, INT_SIZE);
+        entry.system = system == 1;
     }
-    if (rc == RBFM_EOF)
-        rc = SUCCESS;
 
     free(data);
     free(value);
-    rbfm->closeFile(fileHandle);
+    releaseTable(table);
     rbfm_si.close();
-    return rc;   
+
+    if (rc == RBFM_EOF)
+        return RM_TABLE_DN_EXIST;
+    if (rc)
+        return rc;
+
+    rc = getColumns(entry.id, entry.attrs);
+    if (rc)
+        return rc;
+
+    rc = getIndexes(entry.id, entry.attrs, entry.indexes);
+    if (rc)
+        return rc;
+
+    info = &(catalog[tableName] = entry);
+    return SUCCESS;
 }
 
 void RelationManager::toAPI(const string &str, void *data)
@@ -820,23 +1763,27 @@ RC RelationManager::scan(const string &tableName,
       const vector<string> &attributeNames,
       RM_ScanIterator &rm_ScanIterator)
 {
-    // Open the file for the given tableName
-    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
-    RC rc = rbfm->openFile(getFileName(tableName), rm_ScanIterator.fileHandle);
+    // grab the catalog entry for the given tableName
+    TableInfo *info;
+    RC rc = getTableInfo(tableName, info);
     if (rc)
         return rc;
 
-    // grab the record descriptor for the given tableName
-    vector<Attribute> recordDescriptor;
-    rc = getAttributes(tableName, recordDescriptor);
+    // Hold on to the table's file until the iterator is closed
+    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
+    rc = openTable(info->fileName, rm_ScanIterator.table);
     if (rc)
         return rc;
 
     // Use the underlying rbfm_scaniterator to do all the work
-    rc = rbfm->scan(rm_ScanIterator.fileHandle, recordDescriptor, conditionAttribute,
+    rc = rbfm->scan(rm_ScanIterator.table->fileHandle, info->attrs, conditionAttribute,
                      compOp, value, attributeNames, rm_ScanIterator.rbfm_iter);
     if (rc)
+    {
+        releaseTable(rm_ScanIterator.table);
+        rm_ScanIterator.table = NULL;
         return rc;
+    }
 
     return SUCCESS;
 }
@@ -847,11 +1794,65 @@ RC RM_ScanIterator::getNextTuple(RID &rid, void *data)
     return rbfm_iter.getNextRecord(rid, data);
 }
 
-// Close our file handle, rbfm_scaniterator
+// Close our rbfm_scaniterator and release the table's file
 RC RM_ScanIterator::close()
 {
-    RecordBasedFileManager *rbfm = RecordBasedFileManager::instance();
     rbfm_iter.close();
-    rbfm->closeFile(fileHandle);
+    RelationManager::instance()->releaseTable(table);
+    table = NULL;
     return SUCCESS;
-}
\ No newline at end of file
+}
+
+// RM_IndexScanIterator ///////////////
+
+RC RelationManager::indexScan(const string &tableName,
+      const vector<string> &attributeNames,
+      const void *lowKey,
+      unsigned lowKeyFields,
+      const void *highKey,
+      unsigned highKeyFields,
+      bool lowKeyInclusive,
+      bool highKeyInclusive,
+      RM_IndexScanIterator &rm_IndexScanIterator)
+{
+    TableInfo *info;
+    RC rc = getTableInfo(tableName, info);
+    if (rc)
+        return rc;
+
+    IndexInfo *index;
+    rc = findIndex(info, attributeNames, index);
+    if (rc)
+        return rc;
+
+    // Hold on to the index file until the iterator is closed
+    rc = openIndex(index->fileName, rm_IndexScanIterator.index);
+    if (rc)
+        return rc;
+
+    rc = IndexManager::instance()->scan(rm_IndexScanIterator.index->ixfileHandle, index->attrs, lowKey, lowKeyFields,
+            highKey, highKeyFields, lowKeyInclusive, highKeyInclusive, rm_IndexScanIterator.ix_iter);
+    if (rc)
+    {
+        releaseIndex(rm_IndexScanIterator.index);
+        rm_IndexScanIterator.index = NULL;
+        return rc;
+    }
+
+    return SUCCESS;
+}
+
+// Let ix do all the work
+RC RM_IndexScanIterator::getNextEntry(RID &rid, void *key)
+{
+    return ix_iter.getNextEntry(rid, key);
+}
+
+// Close our ix_scaniterator and release the index file
+RC RM_IndexScanIterator::close()
+{
+    ix_iter.close();
+    RelationManager::instance()->releaseIndex(index);
+    index = NULL;
+    return SUCCESS;
+}
@@ -4,12 +4,16 @@
 
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <functional>
 
 #include "../rbf/rbfm.h"
+#include "../ix/ix.h"
 
 using namespace std;
 
 #define TABLE_FILE_EXTENSION ".t"
+#define INDEX_FILE_EXTENSION ".i"
 
 #define TABLES_TABLE_NAME           "Tables"
 #define TABLES_TABLE_ID             1
@@ -41,10 +45,34 @@ using namespace std;
 // 1 null byte, 4 integer fields and a varchar
 #define COLUMNS_RECORD_DATA_SIZE 1 + 5 * INT_SIZE + COLUMNS_COL_COLUMN_NAME_SIZE
 
+#define INDEXES_TABLE_NAME           "Indexes"
+#define INDEXES_TABLE_ID             3
+
+// Format for Indexes table:
+// (table-id:int, column-names:varchar(408), file-name:varchar(473))
+// column-names lists the key columns of the index in order, separated by commas
+
+#define INDEXES_COL_TABLE_ID          "table-id"
+#define INDEXES_COL_COLUMN_NAMES      "column-names"
+#define INDEXES_COL_FILE_NAME         "file-name"
+#define INDEXES_COL_COLUMN_NAMES_SIZE (IX_MAX_KEY_FIELDS * (COLUMNS_COL_COLUMN_NAME_SIZE + 1))
+#define INDEXES_COL_FILE_NAME_SIZE    (11 + TABLES_COL_TABLE_NAME_SIZE + INDEXES_COL_COLUMN_NAMES_SIZE + 4)
+
+// 1 null byte, an integer and 2 varchars
+#define INDEXES_RECORD_DATA_SIZE 1 + 3 * INT_SIZE + INDEXES_COL_COLUMN_NAMES_SIZE + INDEXES_COL_FILE_NAME_SIZE
+
+// Indexes are built with room left in their nodes for the tuples inserted later
+#define INDEX_FILL_FACTOR 0.8f
+
 # define RM_EOF (-1)  // end of a scan operator
 
 #define RM_CANNOT_MOD_SYS_TBL 1
 #define RM_NULL_COLUMN        2
+#define RM_TABLE_DN_EXIST     3
+#define RM_NO_SUCH_ATTR       4
+#define RM_INDEX_EXISTS       5
+#define RM_INDEX_DN_EXIST     6
+#define RM_BAD_INDEX          7     // No columns, too many, or one of them twice
 
 typedef struct IndexedAttr
 {
@@ -52,10 +80,44 @@ typedef struct IndexedAttr
     Attribute attr;
 } IndexedAttr;
 
+// An index of a table, as the Indexes table describes it
+typedef struct IndexInfo
+{
+    vector<Attribute> attrs;    // Key columns in index order
+    vector<unsigned> fields;    // Their positions in the table's tuples, from 0
+    string fileName;
+} IndexInfo;
+
+// Everything the catalog knows about a table, cached by RelationManager
+typedef struct TableInfo
+{
+    int32_t id;
+    bool system;
+    string fileName;
+    vector<Attribute> attrs;    // Sorted by column position
+    vector<IndexInfo> indexes;
+} TableInfo;
+
+// A table file kept open by RelationManager between calls
+typedef struct TableHandle
+{
+    FileHandle fileHandle;
+    unsigned refCount;          // Calls and scan iterators currently using the handle
+    bool closed;                // Closed by deleteTable while in use; the last user closes the file
+} TableHandle;
+
+// An index file kept open by RelationManager between calls, like a TableHandle
+typedef struct IndexHandle
+{
+    IXFileHandle ixfileHandle;
+    unsigned refCount;
+    bool closed;
+} IndexHandle;
+
 // RM_ScanIterator is an iteratr to go through tuples
 class RM_ScanIterator {
 public:
-  RM_ScanIterator() {};
+  RM_ScanIterator() : table(NULL) {};
   ~RM_ScanIterator() {};
 
   // "data" follows the same format as RelationManager::insertTuple()
@@ -65,7 +127,26 @@ public:
   friend class RelationManager;
 private:
   RBFM_ScanIterator rbfm_iter;
-  FileHandle fileHandle;
+  TableHandle *table;
+};
+
+
+// RM_IndexScanIterator goes through the entries of an index in key order, or of a hash index in
+// no particular order. Every entry comes with the key columns of its tuple, so they can be
+// checked without reading the tuple.
+class RM_IndexScanIterator {
+public:
+  RM_IndexScanIterator() : index(NULL) {};
+  ~RM_IndexScanIterator() {};
+
+  // "key" is a tuple over the columns of the index, with its own null indicator
+  RC getNextEntry(RID &rid, void *key);
+  RC close();
+
+  friend class RelationManager;
+private:
+  IX_ScanIterator ix_iter;
+  IndexHandle *index;
 };
 
 
@@ -87,6 +168,9 @@ public:
 
   RC insertTuple(const string &tableName, const void *data, RID &rid);
 
+  // Insert many tuples at once; rids[i] is the RID of data[i]
+  RC insertTuples(const string &tableName, const vector<const void*> &data, vector<RID> &rids);
+
   RC deleteTuple(const string &tableName, const RID &rid);
 
   RC updateTuple(const string &tableName, const void *data, const RID &rid);
@@ -108,6 +192,31 @@ public:
       const vector<string> &attributeNames, // a list of projected attributes
       RM_ScanIterator &rm_ScanIterator);
 
+  // Create an index over the given columns of a table, in that order. The index is filled with
+  // the table's tuples and kept up to date by every later change to the table. It is a B+ tree
+  // unless indexType asks for a hash index, which finds the tuples with one key faster but
+  // returns every other scan in no particular order.
+  RC createIndex(const string &tableName, const vector<string> &attributeNames);
+  RC createIndex(const string &tableName, const vector<string> &attributeNames, IndexType indexType);
+
+  RC destroyIndex(const string &tableName, const vector<string> &attributeNames);
+
+  // Scan an index in key order. The bounds are tuples over the first lowKeyFields and
+  // highKeyFields columns of the index, or NULL for no bound, so a scan can fix the leading
+  // columns and give a range on the next one.
+  RC indexScan(const string &tableName,
+      const vector<string> &attributeNames,
+      const void *lowKey,
+      unsigned lowKeyFields,
+      const void *highKey,
+      unsigned highKeyFields,
+      bool lowKeyInclusive,
+      bool highKeyInclusive,
+      RM_IndexScanIterator &rm_IndexScanIterator);
+
+
+  friend class RM_ScanIterator;
+  friend class RM_IndexScanIterator;
 
 protected:
   RelationManager();
@@ -117,18 +226,33 @@ private:
   static RelationManager *_rm;
   const vector<Attribute> tableDescriptor;
   const vector<Attribute> columnDescriptor;
+  const vector<Attribute> indexDescriptor;
+
+  // Open table files by file name
+  unordered_map<string, TableHandle*> tables;
+
+  // Open index files by file name
+  unordered_map<string, IndexHandle*> indexFiles;
+
+  // Catalog cache, filled in as tables are used. Entries are dropped whenever the
+  // Tables, Columns or Indexes rows of a table change.
+  unordered_map<string, TableInfo> catalog;
 
   // Convert tableName to file name (append extension)
   static string getFileName(const char *tableName);
   static string getFileName(const string &tableName);
+  static string getIndexFileName(int32_t tableID, const string &tableName, const vector<string> &attributeNames);
 
   // Create recordDescriptor for Table/Column tables
   static vector<Attribute> createTableDescriptor();
   static vector<Attribute> createColumnDescriptor();
+  static vector<Attribute> createIndexDescriptor();
 
   // Prepare an entry for the Table/Column table
   void prepareTablesRecordData(int32_t id, bool system, const string &tableName, void *data);
   void prepareColumnsRecordData(int32_t id, int32_t pos, Attribute attr, void *data);
+  void prepareIndexesRecordData(int32_t id, const string &columnNames, const string &fileName, void *data);
+  void parseIndexesRecord(const void *data, vector<string> &columnNames, string &fileName);
 
   // Given a table ID and recordDescriptor, creates entries in Column table
   RC insertColumns(int32_t id, const vector<Attribute> &recordDescriptor);
@@ -142,6 +266,37 @@ private:
 
   RC isSystemTable(bool &system, const string &tableName);
 
+  // Table file registry
+  RC openTable(const string &fileName, TableHandle *&table);
+  void releaseTable(TableHandle *table);
+  void closeTable(const string &fileName);
+  static void shutdown();
+
+  // Index file registry, works like the table file registry
+  RC openIndex(const string &fileName, IndexHandle *&index);
+  void releaseIndex(IndexHandle *index);
+  void closeIndex(const string &fileName);
+
+  // Get the catalog entry of tableName, from the cache if possible
+  RC getTableInfo(const string &tableName, TableInfo *&info);
+  // Read the recordDescriptor of table ID from the Columns table
+  RC getColumns(int32_t id, vector<Attribute> &attrs);
+  // Copy a tuple of recordDescriptor into data, leaving out the field at index
+  void dropField(const vector<Attribute> &recordDescriptor, unsigned index, const void *tuple, void *data);
+
+  // Read the indexes of table ID from the Indexes table
+  RC getIndexes(int32_t id, const vector<Attribute> &attrs, vector<IndexInfo> &indexes);
+  // Find the index of a table over exactly these columns
+  RC findIndex(TableInfo *info, const vector<string> &attributeNames, IndexInfo *&index);
+  // Delete the Indexes entries of table ID that match, along with their index files
+  RC removeIndexes(int32_t id, const function<bool(const vector<string>&)> &matches);
+  // Copy the key columns of an index out of a tuple, with their own null indicator. Returns the key size
+  unsigned getKeyTuple(const vector<Attribute> &recordDescriptor, const IndexInfo &index, const void *tuple, void *key);
+  // Keep the indexes of a table in step with its tuples
+  RC insertIndexEntries(const TableInfo &info, const void *tuple, const RID &rid);
+  RC deleteIndexEntries(const TableInfo &info, const void *tuple, const RID &rid);
+  RC deleteIndexEntries(const TableInfo &info, const void *tuple, const RID &rid, unsigned numIndexes);
+
 public: 
 // Extra credit work (10 points)
   RC addAttribute(const string &tableName, const Attribute &attr);
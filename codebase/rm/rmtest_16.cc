@@ -0,0 +1,356 @@
+#include "rm_test_util.h"
+
+#include <algorithm>
+#include <glob.h>
+
+// Whether the table has an index file over the given key columns. Index file names start
+// with the table-id, which the test doesn't know.
+bool indexFileExists(const string &tableName, const string &columnNames)
+{
+    glob_t files;
+    string pattern = "*_" + tableName + "_" + columnNames + INDEX_FILE_EXTENSION;
+    bool found = glob(pattern.c_str(), 0, NULL, &files) == 0;
+    globfree(&files);
+    return found;
+}
+
+// An order as the test expects to find it through the index
+typedef struct Order
+{
+    int customer;
+    int date;           // -1 if the date is null
+    RID rid;
+    bool deleted;
+} Order;
+
+RC createOrdersTable(const string &tableName)
+{
+    vector<Attribute> attrs;
+
+    Attribute attr;
+    attr.name = "customer_id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    attr.name = "order_date";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    attr.name = "amount";
+    attr.type = TypeReal;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    return rm->createTable(tableName, attrs);
+}
+
+// A tuple of the orders table, or a key over its first two columns if amount is left out
+int prepareOrder(int customer, int date, bool withAmount, void *buffer)
+{
+    unsigned char nulls = date < 0 ? 0x40 : 0;
+    int offset = 1;
+    memcpy(buffer, &nulls, 1);
+    memcpy((char *)buffer + offset, &customer, sizeof(int));
+    offset += sizeof(int);
+    if (date >= 0)
+    {
+        memcpy((char *)buffer + offset, &date, sizeof(int));
+        offset += sizeof(int);
+    }
+    if (withAmount)
+    {
+        float amount = customer + date / 100.0;
+        memcpy((char *)buffer + offset, &amount, sizeof(float));
+        offset += sizeof(float);
+    }
+    return offset;
+}
+
+Order makeOrder(int i)
+{
+    Order order;
+    order.customer = i % 50;
+    order.date = i % 37 == 0 ? -1 : i / 50;
+    order.deleted = false;
+    return order;
+}
+
+// Scans the orders of one customer with dates in [low, high] (-1 for no bound) and compares
+// them with what is expected, using only the keys the index returns
+int checkCustomer(const string &tableName, const vector<string> &indexColumns, const vector<Order> &orders,
+        int customer, int low, int high)
+{
+    char lowKey[100];
+    char highKey[100];
+    prepareOrder(customer, low, false, lowKey);
+    prepareOrder(customer, high, false, highKey);
+
+    RM_IndexScanIterator rmisi;
+    RC rc = rm->indexScan(tableName, indexColumns, lowKey, low < 0 ? 1 : 2, highKey, high < 0 ? 1 : 2, true, true, rmisi);
+    if (rc != success)
+    {
+        cout << "RelationManager::indexScan() failed." << endl;
+        return -1;
+    }
+
+    vector<int> expected;
+    for (unsigned i = 0; i < orders.size(); i++)
+    {
+        if (orders[i].deleted || orders[i].customer != customer)
+            continue;
+        if ((low >= 0 && orders[i].date < low) || (high >= 0 && orders[i].date > high))
+            continue;
+        expected.push_back(orders[i].date);
+    }
+    sort(expected.begin(), expected.end());
+
+    RID rid;
+    char key[100];
+    unsigned count = 0;
+    int previous = -2;
+    while (rmisi.getNextEntry(rid, key) == success)
+    {
+        int keyCustomer;
+        memcpy(&keyCustomer, key + 1, sizeof(int));
+        int date = -1;
+        if (!(key[0] & 0x40))
+            memcpy(&date, key + 1 + sizeof(int), sizeof(int));
+        if (keyCustomer != customer || date < previous || count >= expected.size() || date != expected[count])
+        {
+            cout << "Wrong entry for customer " << customer << ": (" << keyCustomer << ", " << date << ")" << endl;
+            rmisi.close();
+            return -1;
+        }
+        previous = date;
+        count++;
+    }
+    rmisi.close();
+    if (count != expected.size())
+    {
+        cout << "Customer " << customer << " has " << count << " orders instead of " << expected.size() << endl;
+        return -1;
+    }
+    return success;
+}
+
+// Counts the tuples of a table, and the entries of its index over the given column
+int countTuples(const string &tableName, const string &column, unsigned &tuples, unsigned &entries)
+{
+    RM_ScanIterator rmsi;
+    vector<string> projection(1, column);
+    RC rc = rm->scan(tableName, "", NO_OP, NULL, projection, rmsi);
+    if (rc != success)
+        return -1;
+    RID rid;
+    char tuple[PAGE_SIZE];
+    tuples = 0;
+    while (rmsi.getNextTuple(rid, tuple) == success)
+        tuples++;
+    rmsi.close();
+
+    RM_IndexScanIterator rmisi;
+    vector<string> indexColumns(1, column);
+    rc = rm->indexScan(tableName, indexColumns, NULL, 0, NULL, 0, true, true, rmisi);
+    if (rc != success)
+        return -1;
+    entries = 0;
+    while (rmisi.getNextEntry(rid, tuple) == success)
+        entries++;
+    rmisi.close();
+    return success;
+}
+
+// A tuple one of the indexes can't take is taken out of the table and the other indexes again
+int checkRollback(const string &tableName)
+{
+    vector<Attribute> attrs(2);
+    attrs[0].name = "id";
+    attrs[0].type = TypeInt;
+    attrs[0].length = (AttrLength)4;
+    attrs[1].name = "note";
+    attrs[1].type = TypeVarChar;
+    attrs[1].length = (AttrLength)2000;
+    rm->deleteTable(tableName);
+    RC rc = rm->createTable(tableName, attrs);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    rc = rm->createIndex(tableName, vector<string>(1, "id"));
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+    rc = rm->createIndex(tableName, vector<string>(1, "note"));
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+
+    // Notes longer than an index key can be go into the table but not into the note index
+    char shortNote[100];
+    char longNote[2000];
+    for (int i = 0; i < 2; i++)
+    {
+        char *tuple = i == 0 ? shortNote : longNote;
+        int id = i;
+        int length = i == 0 ? 10 : 1500;
+        tuple[0] = 0;
+        memcpy(tuple + 1, &id, sizeof(int));
+        memcpy(tuple + 1 + sizeof(int), &length, sizeof(int));
+        memset(tuple + 1 + 2 * sizeof(int), 'a' + i, length);
+    }
+
+    RID rid;
+    rc = rm->insertTuple(tableName, shortNote, rid);
+    assert(rc == success && "RelationManager::insertTuple() should not fail.");
+    rc = rm->insertTuple(tableName, longNote, rid);
+    assert(rc != success && "Inserting a tuple with a key too long for an index should fail.");
+    vector<const void*> batch;
+    batch.push_back(shortNote);
+    batch.push_back(longNote);
+    batch.push_back(shortNote);
+    vector<RID> rids;
+    rc = rm->insertTuples(tableName, batch, rids);
+    assert(rc != success && "Inserting a batch with a key too long for an index should fail.");
+
+    unsigned tuples, entries;
+    if (countTuples(tableName, "id", tuples, entries) != success || tuples != 1 || entries != 1)
+    {
+        cout << "Failed inserts were left in the table or its index." << endl;
+        return -1;
+    }
+
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    return success;
+}
+
+int TEST_RM_16(const string &tableName)
+{
+    // Functions Tested:
+    // 1. Create a composite index on a table with tuples **
+    // 2. Insert, update and delete tuples of an indexed table **
+    // 3. Index scans over a prefix of the key columns **
+    // 4. Destroy an index **
+    // 5. Roll back inserts an index can't take **
+    cout << endl << "***** In RM Test Case 16 *****" << endl;
+
+    const unsigned numTuples = 2000;
+    vector<string> indexColumns;
+    indexColumns.push_back("customer_id");
+    indexColumns.push_back("order_date");
+
+    // The first half of the orders is there when the index is created, the rest comes after
+    vector<Order> orders;
+    char tuple[100];
+    RC rc;
+    for (unsigned i = 0; i < numTuples; i++)
+    {
+        if (i == numTuples / 2)
+        {
+            rc = rm->createIndex(tableName, indexColumns);
+            assert(rc == success && "RelationManager::createIndex() should not fail.");
+        }
+        Order order = makeOrder(i);
+        prepareOrder(order.customer, order.date, true, tuple);
+        rc = rm->insertTuple(tableName, tuple, order.rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+        orders.push_back(order);
+    }
+
+    // The same index can't be created twice, and needs columns of the table
+    rc = rm->createIndex(tableName, indexColumns);
+    assert(rc != success && "Creating an existing index should fail.");
+    vector<string> badColumns(1, "no_such_column");
+    rc = rm->createIndex(tableName, badColumns);
+    assert(rc != success && "Creating an index on a column that doesn't exist should fail.");
+    if (!indexFileExists(tableName, "customer_id,order_date"))
+    {
+        cout << "The index file is missing." << endl;
+        return -1;
+    }
+
+    // An index whose table and column names join to the same string gets a file of its own
+    const string otherTable = tableName + "_customer";
+    vector<Attribute> otherAttrs(1);
+    otherAttrs[0].name = "id_order_date";
+    otherAttrs[0].type = TypeInt;
+    otherAttrs[0].length = (AttrLength)4;
+    rm->deleteTable(otherTable);
+    rc = rm->createTable(otherTable, otherAttrs);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+    vector<string> otherColumns(1, "id_order_date");
+    rc = rm->createIndex(otherTable, otherColumns);
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+    rc = rm->deleteTable(otherTable);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+
+    for (int customer = 0; customer < 50; customer += 7)
+    {
+        if (checkCustomer(tableName, indexColumns, orders, customer, -1, -1) != success ||
+                checkCustomer(tableName, indexColumns, orders, customer, 5, 12) != success ||
+                checkCustomer(tableName, indexColumns, orders, customer, 30, -1) != success)
+            return -1;
+    }
+
+    // Move some orders to another date and delete others
+    for (unsigned i = 0; i < numTuples; i += 3)
+    {
+        if (i % 2 == 0)
+        {
+            rc = rm->deleteTuple(tableName, orders[i].rid);
+            assert(rc == success && "RelationManager::deleteTuple() should not fail.");
+            orders[i].deleted = true;
+        }
+        else
+        {
+            orders[i].date = orders[i].date < 0 ? 7 : (orders[i].date * 7) % 40;
+            prepareOrder(orders[i].customer, orders[i].date, true, tuple);
+            rc = rm->updateTuple(tableName, tuple, orders[i].rid);
+            assert(rc == success && "RelationManager::updateTuple() should not fail.");
+        }
+    }
+
+    for (int customer = 0; customer < 50; customer += 7)
+    {
+        if (checkCustomer(tableName, indexColumns, orders, customer, -1, -1) != success ||
+                checkCustomer(tableName, indexColumns, orders, customer, 5, 12) != success)
+            return -1;
+    }
+
+    // The index file goes with the index
+    rc = rm->destroyIndex(tableName, indexColumns);
+    assert(rc == success && "RelationManager::destroyIndex() should not fail.");
+    RM_IndexScanIterator rmisi;
+    rc = rm->indexScan(tableName, indexColumns, NULL, 0, NULL, 0, true, true, rmisi);
+    assert(rc != success && "Scanning a destroyed index should fail.");
+    if (indexFileExists(tableName, "customer_id,order_date"))
+    {
+        cout << "The index file is still there." << endl;
+        return -1;
+    }
+
+    // An index dropped with its table
+    rc = rm->createIndex(tableName, indexColumns);
+    assert(rc == success && "RelationManager::createIndex() should not fail.");
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+    if (indexFileExists(tableName, "customer_id,order_date"))
+    {
+        cout << "The index file is still there after deleteTable." << endl;
+        return -1;
+    }
+
+    return checkRollback(tableName + "_notes");
+}
+
+int main()
+{
+    const string tableName = "tbl_orders";
+    rm->deleteTable(tableName);
+    RC rc = createOrdersTable(tableName);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+
+    rc = TEST_RM_16(tableName);
+    if (rc == success) {
+        cout << "***** RM Test Case 16 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cout << "***** [FAIL] RM Test Case 16 failed. *****" << endl;
+        return -1;
+    }
+}
@@ -0,0 +1,233 @@
+#include "rm_test_util.h"
+
+#include <algorithm>
+#include <glob.h>
+
+// Whether the table has an index file over the given key columns. Index file names start
+// with the table-id, which the test doesn't know.
+bool indexFileExists(const string &tableName, const string &columnNames)
+{
+    glob_t files;
+    string pattern = "*_" + tableName + "_" + columnNames + INDEX_FILE_EXTENSION;
+    bool found = glob(pattern.c_str(), 0, NULL, &files) == 0;
+    globfree(&files);
+    return found;
+}
+
+// An order as the test expects to find it through the index
+typedef struct Order
+{
+    int customer;
+    int date;
+    RID rid;
+    bool deleted;
+} Order;
+
+RC createOrdersTable(const string &tableName)
+{
+    vector<Attribute> attrs;
+
+    Attribute attr;
+    attr.name = "customer_id";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    attr.name = "order_date";
+    attr.type = TypeInt;
+    attr.length = (AttrLength)4;
+    attrs.push_back(attr);
+
+    return rm->createTable(tableName, attrs);
+}
+
+void prepareOrder(const Order &order, void *buffer)
+{
+    unsigned char nulls = 0;
+    memcpy(buffer, &nulls, 1);
+    memcpy((char *)buffer + 1, &order.customer, sizeof(int));
+    memcpy((char *)buffer + 1 + sizeof(int), &order.date, sizeof(int));
+}
+
+bool ridLess(const RID &a, const RID &b)
+{
+    if (a.pageNum != b.pageNum)
+        return a.pageNum < b.pageNum;
+    return a.slotNum < b.slotNum;
+}
+
+// Looks up one customer through the hash index and compares the RIDs it returns with the
+// orders the customer has
+int checkCustomer(const string &tableName, const vector<string> &indexColumns, const vector<Order> &orders,
+        int customer)
+{
+    char key[100];
+    unsigned char nulls = 0;
+    memcpy(key, &nulls, 1);
+    memcpy(key + 1, &customer, sizeof(int));
+
+    RM_IndexScanIterator rmisi;
+    RC rc = rm->indexScan(tableName, indexColumns, key, 1, key, 1, true, true, rmisi);
+    if (rc != success)
+    {
+        cout << "RelationManager::indexScan() failed." << endl;
+        return -1;
+    }
+
+    vector<RID> expected;
+    for (unsigned i = 0; i < orders.size(); i++)
+    {
+        if (!orders[i].deleted && orders[i].customer == customer)
+            expected.push_back(orders[i].rid);
+    }
+
+    RID rid;
+    char returnedKey[100];
+    vector<RID> found;
+    while (rmisi.getNextEntry(rid, returnedKey) == success)
+    {
+        int keyCustomer;
+        memcpy(&keyCustomer, returnedKey + 1, sizeof(int));
+        if (keyCustomer != customer)
+        {
+            cout << "Customer " << keyCustomer << " is returned for customer " << customer << endl;
+            rmisi.close();
+            return -1;
+        }
+        found.push_back(rid);
+    }
+    rmisi.close();
+
+    sort(expected.begin(), expected.end(), ridLess);
+    sort(found.begin(), found.end(), ridLess);
+    if (found.size() != expected.size())
+    {
+        cout << "Customer " << customer << " has " << found.size() << " orders instead of " << expected.size() << endl;
+        return -1;
+    }
+    for (unsigned i = 0; i < found.size(); i++)
+    {
+        if (found[i].pageNum != expected[i].pageNum || found[i].slotNum != expected[i].slotNum)
+        {
+            cout << "Wrong order (" << found[i].pageNum << "," << found[i].slotNum << ") for customer " << customer << endl;
+            return -1;
+        }
+    }
+    return success;
+}
+
+int TEST_RM_17(const string &tableName)
+{
+    // Functions Tested:
+    // 1. Create a hash index on a table with tuples **
+    // 2. Insert, update and delete tuples of an indexed table
+    // 3. Equality index scans **
+    // 4. Destroy an index
+    cout << endl << "***** In RM Test Case 17 *****" << endl;
+
+    const unsigned numTuples = 3000;
+    const int numCustomers = 400;
+    vector<string> indexColumns(1, "customer_id");
+
+    // The first half of the orders is there when the index is created, the rest comes after
+    vector<Order> orders;
+    char tuple[100];
+    RC rc;
+    for (unsigned i = 0; i < numTuples; i++)
+    {
+        if (i == numTuples / 2)
+        {
+            rc = rm->createIndex(tableName, indexColumns, IX_HASH);
+            assert(rc == success && "RelationManager::createIndex() should not fail.");
+        }
+        Order order;
+        order.customer = (i * 37) % numCustomers;
+        order.date = i;
+        order.deleted = false;
+        prepareOrder(order, tuple);
+        rc = rm->insertTuple(tableName, tuple, order.rid);
+        assert(rc == success && "RelationManager::insertTuple() should not fail.");
+        orders.push_back(order);
+    }
+
+    rc = rm->createIndex(tableName, indexColumns, IX_BTREE);
+    assert(rc != success && "Creating an existing index should fail.");
+
+    for (int customer = -1; customer <= numCustomers; customer += 3)
+    {
+        if (checkCustomer(tableName, indexColumns, orders, customer) != success)
+            return -1;
+    }
+
+    // Move some orders to another customer and delete others
+    for (unsigned i = 0; i < numTuples; i += 3)
+    {
+        if (i % 2 == 0)
+        {
+            rc = rm->deleteTuple(tableName, orders[i].rid);
+            assert(rc == success && "RelationManager::deleteTuple() should not fail.");
+            orders[i].deleted = true;
+        }
+        else
+        {
+            orders[i].customer = (orders[i].customer + 1) % numCustomers;
+            prepareOrder(orders[i], tuple);
+            rc = rm->updateTuple(tableName, tuple, orders[i].rid);
+            assert(rc == success && "RelationManager::updateTuple() should not fail.");
+        }
+    }
+
+    for (int customer = 0; customer < numCustomers; customer += 2)
+    {
+        if (checkCustomer(tableName, indexColumns, orders, customer) != success)
+            return -1;
+    }
+
+    // A scan without bounds returns every order once, in no particular order
+    RM_IndexScanIterator rmisi;
+    rc = rm->indexScan(tableName, indexColumns, NULL, 0, NULL, 0, true, true, rmisi);
+    assert(rc == success && "RelationManager::indexScan() should not fail.");
+    RID rid;
+    char key[100];
+    unsigned count = 0;
+    while (rmisi.getNextEntry(rid, key) == success)
+        count++;
+    rmisi.close();
+    unsigned live = 0;
+    for (unsigned i = 0; i < orders.size(); i++)
+        live += orders[i].deleted ? 0 : 1;
+    if (count != live)
+    {
+        cout << "The index has " << count << " entries instead of " << live << endl;
+        return -1;
+    }
+
+    rc = rm->destroyIndex(tableName, indexColumns);
+    assert(rc == success && "RelationManager::destroyIndex() should not fail.");
+    if (indexFileExists(tableName, "customer_id"))
+    {
+        cout << "The index file is still there." << endl;
+        return -1;
+    }
+    rc = rm->deleteTable(tableName);
+    assert(rc == success && "RelationManager::deleteTable() should not fail.");
+
+    return success;
+}
+
+int main()
+{
+    const string tableName = "tbl_hashed_orders";
+    rm->deleteTable(tableName);
+    RC rc = createOrdersTable(tableName);
+    assert(rc == success && "RelationManager::createTable() should not fail.");
+
+    rc = TEST_RM_17(tableName);
+    if (rc == success) {
+        cout << "***** RM Test Case 17 finished. The result will be examined. *****" << endl;
+        return success;
+    } else {
+        cout << "***** [FAIL] RM Test Case 17 failed. *****" << endl;
+        return -1;
+    }
+}